@@ -9,6 +9,8 @@ layout (location = 2) in vec3 inColor;
 layout (location = 3) in vec3 inNormal;
 layout (location = 4) in vec3 inTangent;
 layout (location = 5) in float inMaterialID;
+// Per instance, camera relative model matrix (see RenderQueue)
+layout (location = 6) in mat4 inModel;
 
 layout (set = 0, binding = 0) uniform UBO 
 {
@@ -29,11 +31,6 @@ layout (set = 0, binding = 1) uniform UBOLIGHT
     int numLights;
 } uboLights;
 
-layout (set = 0, binding = 2) uniform PER_OBJECT 
-{
-	mat4 model;
-} ubdo;
-
 layout (set = 1, binding = 0) uniform sampler2D samplerColorMap;
 layout (set = 1, binding = 1) uniform sampler2D samplerNormalMap;
 
@@ -63,10 +60,10 @@ void main()
 	outTangent = inTangent;
 	outUV = inUV;
 	outUV.t = 1.0 - outUV.t;
-	gl_Position = ubo.projection * ubo.view * ubdo.model * vec4(inPos.xyz, 1.0);
+	gl_Position = ubo.projection * ubo.view * inModel * vec4(inPos.xyz, 1.0);
 	
-	outPos = ubdo.model * vec4(inPos, 1.0);
-	outNormal = mat3(ubdo.model) * normalize(inNormal);
+	outPos = inModel * vec4(inPos, 1.0);
+	outNormal = mat3(inModel) * normalize(inNormal);
 
 	outMaterialID = inMaterialID;
 }
\ No newline at end of file
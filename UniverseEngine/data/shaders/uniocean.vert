@@ -19,6 +19,9 @@ layout(binding = 0) uniform UBO {
 	vec2 viewportDim;
 	float tessellatedEdgeSize;
 	bool hasOcean;
+	//Static grid placement, identity and zero when the CPU placed the vertices
+	mat4 gridRotation;
+	vec4 gridOffset;
 } ubo;
 
 
@@ -38,7 +41,8 @@ void main()
 {
 	//initial position
 
-	vec3 n = normalize(inPos);
+	vec3 gridPos = mat3(ubo.gridRotation) * vec3(inPos.xy, inPos.z - ubo.gridOffset.y);
+	vec3 n = normalize(gridPos);
 	float height = ubo.radius + ubo.radius * ubo.maxHeight / 2.0;
 	
 	outNormal = n;
@@ -21,6 +21,9 @@ layout(binding = 0) uniform UBO {
 	vec2 viewportDim;
 	float tessellatedEdgeSize;
 	bool hasOcean;
+	//Static grid placement, identity and zero when the CPU placed the vertices
+	mat4 gridRotation;
+	vec4 gridOffset;
 } ubo;
 
 
@@ -48,8 +51,9 @@ void main()
 {
 	//initial position
 
-	vec3 n = normalize(inPos);
-	float height = GetHeight(inPos, continentTexture, ubo.radius, ubo.maxHeight);
+	vec3 gridPos = mat3(ubo.gridRotation) * vec3(inPos.xy, inPos.z - ubo.gridOffset.x);
+	vec3 n = normalize(gridPos);
+	float height = GetHeight(gridPos, continentTexture, ubo.radius, ubo.maxHeight);
 	
 	outNormal = n;
 	outPos = n * height;
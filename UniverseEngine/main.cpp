@@ -1,6 +1,7 @@
 #include <iostream>
 #include <limits>
 #include "source/UniEngine.h"
+#include "source/Benchmarks.h"
 
 #include <iostream>
 
@@ -175,13 +176,16 @@ int APIENTRY WinMain(HINSTANCE hInstance, HINSTANCE, LPSTR, int) {
   for (int32_t i = 0; i < __argc; i++) {
     UniEngine::args.push_back(__argv[i]);
   };
-  auto engine = UniEngine::GetInstance();
-  engine->initVulkan();
-  engine->setupWindow(hInstance, WndProc);
-  engine->prepare();
-  engine->renderLoop();
-  engine->Shutdown();
-  UniEngine::Delete();
+  // --cpubench runs instead of the engine
+  if (!uni::bench::Run(UniEngine::args)) {
+    auto engine = UniEngine::GetInstance();
+    engine->initVulkan();
+    engine->setupWindow(hInstance, WndProc);
+    engine->prepare();
+    engine->renderLoop();
+    engine->Shutdown();
+    UniEngine::Delete();
+  }
   std::cout << std::endl;
   std::cout.rdbuf(stdoutbuf);
   std::cerr << std::endl;
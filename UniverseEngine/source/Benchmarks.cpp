@@ -0,0 +1,517 @@
+#include "Benchmarks.h"
+#include <cmath>
+#include <cstring>
+#include <fstream>
+#include <functional>
+#include <iostream>
+#include <map>
+#include <numeric>
+#include <random>
+#include <sstream>
+#include <string>
+#if defined(_WIN32)
+#include <windows.h>
+#endif
+#include <vulkan/vulkan.h>
+// Not through vulkanexamplebase.h, none of the engine is needed here
+#include "vks/benchmark.hpp"
+#include "ECS.h"
+#include "FastNoise.h"
+#include "systems/FloatingOriginSystem.h"
+#include "systems/GravityOctree.h"
+#include "components/PlanetVolume.h"
+
+using namespace uni;
+
+namespace {
+  struct Options {
+    uint32_t warmup = 1;
+    uint32_t duration = 3;
+  };
+
+  struct Case {
+    const char* name;
+    std::function<void(const Options&)> run;
+  };
+
+  /** @brief Time pass until the runtime is used up, the label goes where the device name would */
+  void Measure(const Options& options, const std::string& label,
+               const std::function<void()>& pass) {
+    vks::Benchmark benchmark;
+    benchmark.warmup = options.warmup;
+    benchmark.duration = options.duration;
+
+    VkPhysicalDeviceProperties properties{};
+    strncpy(properties.deviceName, label.c_str(),
+            sizeof(properties.deviceName) - 1);
+    benchmark.run(pass, properties);
+  }
+
+  struct BenchPosition {
+    double x = 0.0, y = 0.0, z = 0.0;
+  };
+
+  struct BenchVelocity {
+    double x = 1.0, y = 2.0, z = 3.0;
+  };
+
+  /** @brief Not trivially copyable, so boxed even with archetype storage */
+  struct BenchName {
+    std::string name = "body";
+  };
+
+  void BenchEcs(const Options& options) {
+#ifdef ECS_ARCHETYPE_STORAGE
+    const char* storage = "archetype";
+#else
+    const char* storage = "sparse";
+#endif
+    const int count = 100000;
+
+    auto world = ECS::World::createWorld();
+    for (int i = 0; i < count; i++) {
+      auto ent = world->create();
+      ent->assign<BenchPosition>();
+      ent->assign<BenchVelocity>();
+      // a second archetype, and entities each<> has to skip
+      if (i % 4 == 0)
+        ent->assign<BenchName>();
+      if (i % 8 == 0)
+        world->create()->assign<BenchName>();
+    }
+
+    double sum = 0.0;
+    Measure(options, std::string("ecs each, ") + storage + " storage", [&] {
+      world->each<BenchPosition, BenchVelocity>(
+          [&](ECS::Entity* ent, ECS::ComponentHandle<BenchPosition> p,
+              ECS::ComponentHandle<BenchVelocity> v) {
+            p->x += v->x * 0.001;
+            p->y += v->y * 0.001;
+            p->z += v->z * 0.001;
+          });
+    });
+
+    Measure(options, std::string("ecs readOnlyEach, ") + storage + " storage",
+            [&] {
+              world->readOnlyEach<BenchPosition>(
+                  [&](const ECS::Entity* const ent,
+                      ECS::ConstComponentHandle<BenchPosition> p) {
+                    sum += p->x;
+                  });
+            });
+
+    world->destroyWorld();
+    std::cout << "(checksum " << sum << ")" << std::endl;
+  }
+
+  void BenchParallelEach(const Options& options) {
+    const int count = 1000000;
+
+    auto world = ECS::World::createWorld();
+    world->setTickMode(ECS::TickMode::Parallel);
+    for (int i = 0; i < count; i++) {
+      auto ent = world->create();
+      ent->assign<BenchPosition>();
+      ent->assign<BenchVelocity>();
+    }
+
+    auto step = [](ECS::Entity* ent, ECS::ComponentHandle<BenchPosition> p,
+                   ECS::ComponentHandle<BenchVelocity> v) {
+      double d = std::sqrt(p->x * p->x + p->y * p->y + p->z * p->z + 1.0);
+      p->x += v->x / d;
+      p->y += v->y / d;
+      p->z += v->z / d;
+    };
+
+    Measure(options, "ecs parallelEach, 1M entities",
+            [&] { world->parallelEach<BenchPosition, BenchVelocity>(step); });
+    // a capture keeps the lambda from converting to the bool overload
+    Measure(options, "ecs each, 1M entities (reference)", [&] {
+      world->each<BenchPosition, BenchVelocity>(
+          [&](ECS::Entity* ent, ECS::ComponentHandle<BenchPosition> p,
+              ECS::ComponentHandle<BenchVelocity> v) { step(ent, p, v); });
+    });
+
+    world->destroyWorld();
+  }
+
+  void BenchGravity(const Options& options) {
+    const double minDistance = 1.0;
+
+    for (uint32_t count : {1000u, 10000u, 100000u}) {
+      // A dense core inside a sparse halo, roughly a star cluster 1e9 m across
+      std::mt19937 random(count);
+      std::uniform_real_distribution<double> unit(0.0, 1.0);
+      std::normal_distribution<double> normal;
+      std::vector<GravityOctree::Body> bodies(count);
+      for (auto& body : bodies) {
+        glm::dvec3 direction = glm::normalize(
+            glm::dvec3(normal(random), normal(random), normal(random)));
+        body.position = direction * 1e9 * std::pow(unit(random), 3.0);
+        body.mass = 1e20 * std::pow(10.0, 4.0 * unit(random));
+      }
+      auto label = std::to_string(count) + " bodies";
+
+      // The reference the approximations are checked against, too slow to bother with at 100k
+      std::vector<glm::dvec3> exact;
+      if (count <= 10000) {
+        exact.resize(count);
+        Measure(options, "gravity direct sum, " + label + " (reference)", [&] {
+          for (uint32_t i = 0; i < count; i++) {
+            glm::dvec3 sum(0.0);
+            for (uint32_t j = 0; j < count; j++) {
+              glm::dvec3 delta = bodies[j].position - bodies[i].position;
+              double distance2 = glm::dot(delta, delta);
+              if (distance2 <= minDistance * minDistance)
+                continue;
+              sum += delta * (GravityOctree::G * bodies[j].mass /
+                              (distance2 * std::sqrt(distance2)));
+            }
+            exact[i] = sum;
+          }
+        });
+      }
+
+      for (double openingAngle : {0.5, 0.7}) {
+        GravityOctree octree;
+        std::vector<glm::dvec3> accelerations(count);
+        std::ostringstream name;
+        name << "gravity Barnes-Hut build + forces, " << label
+             << ", opening angle " << openingAngle;
+        Measure(options, name.str(), [&] {
+          octree.Build(bodies);
+          for (size_t group = 0; group < octree.GroupCount(); group++)
+            octree.GroupAccelerations(group, openingAngle, minDistance,
+                                      accelerations);
+        });
+
+        if (exact.empty())
+          continue;
+
+        double worst = 0.0, total = 0.0;
+        for (uint32_t i = 0; i < count; i++) {
+          double error = glm::length(accelerations[i] - exact[i]) /
+                         glm::length(exact[i]);
+          worst = std::max(worst, error);
+          total += error;
+        }
+        std::cout << "(relative error: mean " << total / count << ", worst "
+                  << worst << ")" << std::endl;
+      }
+    }
+  }
+
+  /**
+  * Camera relative precision 1e8 m from the origin: objects within 10 m of the camera have to land within a
+  * millimetre of where they are while the camera creeps along in 0.1 mm steps, and after the origin is rebased.
+  */
+  void BenchOrigin(const Options& options) {
+    using namespace uni::components;
+    const glm::dvec3 start(1e8 + 0.37, 2.5e7, -3e7);
+    const double tolerance = 1e-3;
+    const int count = 10000;
+
+    auto world = ECS::World::createWorld();
+    auto* origin = new FloatingOriginSystem();
+    world->registerSystem(origin);
+
+    auto cameraEntity = world->create();
+    auto cameraTransform = cameraEntity->assign<TransformComponent>();
+    cameraTransform->m_dPos = start;
+    cameraTransform->MarkDirty();
+    auto camera = cameraEntity->assign<CameraComponent>(cameraTransform);
+
+    std::mt19937 random(7);
+    std::uniform_real_distribution<double> around(-10.0, 10.0);
+    std::vector<ECS::ComponentHandle<TransformComponent>> objects;
+    std::vector<glm::dvec3> offsets;
+    for (int i = 0; i < count; i++) {
+      glm::dvec3 offset(around(random), around(random), around(random));
+      auto transform = world->create()->assign<TransformComponent>();
+      transform->m_dPos = start + offset;
+      transform->MarkDirty();
+      objects.push_back(transform);
+      offsets.push_back(offset);
+    }
+
+    // Worst distance between where each object is drawn and where it is, for a camera moved by cameraMove since
+    // the offsets were taken
+    auto worstError = [&](const glm::dvec3& cameraMove, bool floatWorldSpace) {
+      double worst = 0.0;
+      for (int i = 0; i < count; i++) {
+        glm::vec3 drawn =
+            floatWorldSpace
+                ? glm::vec3(objects[i]->GetModelMat()[3]) - camera->m_Position
+                : glm::vec3(camera->RelativeToCamera(
+                      objects[i]->GetModelMatDouble())[3]);
+        worst = std::max(worst, glm::length(glm::dvec3(drawn) -
+                                            (offsets[i] - cameraMove)));
+      }
+      return worst;
+    };
+
+    double floatError = worstError(glm::dvec3(0.0), true);
+    double relativeError = worstError(glm::dvec3(0.0), false);
+
+    // Creep 0.1 m in 0.1 mm steps, each should show up exactly
+    double creepError = 0.0;
+    for (int step = 1; step <= 1000; step++) {
+      cameraTransform->m_dPos.x += 1e-4;
+      cameraTransform->MarkDirty();
+      camera->CalculateView(cameraTransform);
+      if (step % 100 == 0)
+        creepError = std::max(
+            creepError, worstError(glm::dvec3(step * 1e-4, 0.0, 0.0), false));
+    }
+
+    // Then a tick moves everything back by the camera's position
+    world->tick(0.f);
+    double rebaseError = worstError(glm::dvec3(0.1, 0.0, 0.0), false);
+    bool rebased = glm::length(origin->GetOriginOffset() - start) < 1.0;
+
+    std::cout << "(worst error 1e8 m out: float world space " << floatError
+              << " m, camera relative " << relativeError
+              << " m, creeping camera " << creepError << " m, after rebase "
+              << rebaseError << " m)" << std::endl;
+    bool pass = rebased && relativeError < tolerance &&
+                rebaseError < tolerance && creepError < tolerance;
+    std::cout << (pass ? "PASS" : "FAIL") << ": sub-millimetre camera relative"
+              << " positions through a rebase" << std::endl;
+
+    Measure(options, "origin RelativeToCamera, 10k model matrices", [&] {
+      for (auto& transform : objects)
+        camera->RelativeToCamera(transform->GetModelMatDouble());
+    });
+
+    world->destroyWorld();
+  }
+
+  /**
+  * FastNoise batches against one GetNoise per point: GetNoiseSet has to give bit for bit the same values for every
+  * noise and fractal type, then the 3D simplex kernels are timed both ways over 1M points.
+  */
+  void BenchNoise(const Options& options) {
+    const size_t count = 1000000;
+    // enough for every lane count and remainder, the slow types are only checked on this many
+    const size_t checked = 20003;
+
+    std::mt19937 random(7);
+    std::uniform_real_distribution<float> coordinate(-500.f, 500.f);
+    std::vector<float> x(count), y(count), z(count), single(count), batch(count);
+    for (size_t i = 0; i < count; i++) {
+      x[i] = coordinate(random);
+      y[i] = coordinate(random);
+      z[i] = coordinate(random);
+    }
+    // whole and negative coordinates land exactly on lattice cells
+    for (int i = 0; i < 1000; i++) {
+      x[i] = float(i - 500);
+      y[i] = -float(i);
+      z[i] = 0.f;
+    }
+
+    const FastNoise::NoiseType types[] = {
+        FastNoise::Value,         FastNoise::ValueFractal,
+        FastNoise::Perlin,        FastNoise::PerlinFractal,
+        FastNoise::Simplex,       FastNoise::SimplexFractal,
+        FastNoise::Cellular,      FastNoise::WhiteNoise,
+        FastNoise::Cubic,         FastNoise::CubicFractal};
+    int mismatches = 0;
+    for (auto type : types) {
+      for (int fractal = FastNoise::FBM; fractal <= FastNoise::RigidMulti;
+           fractal++) {
+        FastNoise noise(1337 + fractal);
+        noise.SetNoiseType(type);
+        noise.SetFractalType((FastNoise::FractalType)fractal);
+        noise.SetFractalOctaves(3 + fractal);
+        noise.SetFrequency(fractal == FastNoise::RigidMulti ? 1.f : 0.01f);
+
+        noise.GetNoiseSet(x.data(), y.data(), z.data(), batch.data(), checked);
+        for (size_t i = 0; i < checked; i++)
+          single[i] = noise.GetNoise(x[i], y[i], z[i]);
+        if (memcmp(single.data(), batch.data(), checked * sizeof(float)))
+          mismatches++;
+
+        noise.GetNoiseSet(x.data(), y.data(), batch.data(), checked);
+        for (size_t i = 0; i < checked; i++)
+          single[i] = noise.GetNoise(x[i], y[i]);
+        if (memcmp(single.data(), batch.data(), checked * sizeof(float)))
+          mismatches++;
+      }
+    }
+
+    {
+      FastNoise noise;
+      noise.SetNoiseType(FastNoise::SimplexFractal);
+      const int sizeX = 37, sizeY = 11, sizeZ = 5;
+      const float step = 0.37f;
+      noise.GetNoiseSetGrid(batch.data(), -3.f, 2.f, 7.f, sizeX, sizeY, sizeZ,
+                            step);
+      size_t i = 0;
+      for (int k = 0; k < sizeZ; k++)
+        for (int j = 0; j < sizeY; j++)
+          for (int n = 0; n < sizeX; n++, i++)
+            single[i] = noise.GetNoise(-3.f + n * step, 2.f + j * step,
+                                       7.f + k * step);
+      if (memcmp(single.data(), batch.data(), i * sizeof(float)))
+        mismatches++;
+    }
+
+    std::cout << (mismatches == 0 ? "PASS" : "FAIL")
+              << ": GetNoiseSet matches GetNoise bit for bit (" << mismatches
+              << " mismatching sets)" << std::endl;
+
+    for (int octaves : {1, 3, 6}) {
+      FastNoise noise(1337);
+      noise.SetNoiseType(octaves == 1 ? FastNoise::Simplex
+                                      : FastNoise::SimplexFractal);
+      noise.SetFractalOctaves(octaves);
+      auto label = octaves == 1 ? std::string("simplex")
+                                : "simplex fractal x" + std::to_string(octaves);
+
+      Measure(options, "noise GetNoiseSet, 1M points, " + label, [&] {
+        noise.GetNoiseSet(x.data(), y.data(), z.data(), batch.data(), count);
+      });
+      Measure(options, "noise GetNoise, 1M points, " + label + " (reference)",
+              [&] {
+                for (size_t i = 0; i < count; i++)
+                  single[i] = noise.GetNoise(x[i], y[i], z[i]);
+              });
+    }
+  }
+
+  /**
+  * Volume refinement along a wandering camera, checked from scratch with VolumeRefiner::Validate every few updates,
+  * then a surface that has to be closed and consistently wound. Update and ExtractSurface are timed on their own.
+  */
+  void BenchVolume(const Options& options) {
+    using uni::planet::VolumeRefiner;
+    // a bumpy sphere, roughly the distance to its surface
+    auto density = [](const glm::vec3& p) {
+      return 0.6f - glm::length(p) +
+             0.08f * std::sin(p.x * 9.f) * std::sin(p.y * 11.f) *
+                 std::sin(p.z * 7.f);
+    };
+
+    VolumeRefiner::Settings settings;
+    settings.depth = 6;
+    settings.maxError = 0.3f;
+    settings.maxSplitsPerUpdate = 200;
+    settings.maxMergesPerUpdate = 300;
+    VolumeRefiner refiner(density, 1.f, settings);
+
+    std::string error;
+    bool valid = refiner.Validate(error);
+    std::mt19937 random(1);
+    std::uniform_real_distribution<float> unit(-1.f, 1.f);
+    auto wander = [&](glm::vec3& camera, int frame) {
+      if (frame % 40 == 0)
+        camera = glm::vec3(unit(random), unit(random), unit(random)) * 1.2f;
+      else
+        camera += glm::vec3(unit(random), unit(random), unit(random)) * 0.03f;
+    };
+
+    glm::vec3 camera(0.f, 0.f, 2.f);
+    for (int frame = 0; frame < 300 && valid; frame++) {
+      wander(camera, frame);
+      refiner.Update(camera);
+      if (frame % 5 == 0)
+        valid = refiner.Validate(error);
+    }
+    // let the budgets catch up
+    for (int i = 0; i < 100 && valid; i++)
+      refiner.Update(camera);
+    valid = valid && refiner.Validate(error);
+
+    // Every directed edge of a closed, consistently wound surface shows up
+    // once, and its reverse once
+    std::vector<glm::vec3> vertices;
+    std::vector<uint32_t> indices;
+    refiner.ExtractSurface(vertices, indices);
+    std::map<std::pair<uint32_t, uint32_t>, int> edges;
+    for (size_t i = 0; i < indices.size(); i += 3)
+      for (int e = 0; e < 3; e++)
+        edges[{indices[i + e], indices[i + (e + 1) % 3]}]++;
+    size_t badEdges = 0;
+    for (auto& edge : edges)
+      if (edge.second != 1 ||
+          edges.count({edge.first.second, edge.first.first}) != 1)
+        badEdges++;
+
+    // Everything split down to the finest level has to conform as well
+    VolumeRefiner::Settings fullSettings;
+    fullSettings.depth = 4;
+    fullSettings.maxError = 0.f;
+    fullSettings.slope = 1e9f;
+    fullSettings.maxSplitsPerUpdate = 1 << 20;
+    VolumeRefiner full([](const glm::vec3&) { return 0.f; }, 1.f,
+                       fullSettings);
+    full.Update(glm::vec3(0.f));
+    std::string fullError;
+    bool fullValid = full.Validate(fullError);
+
+    std::cout << "(" << refiner.Stats().diamonds << " diamonds, "
+              << refiner.Stats().tets << " tets, surface " << vertices.size()
+              << " vertices " << indices.size() / 3 << " triangles, "
+              << badEdges << " open or miswound edges; fully split "
+              << full.Stats().tets << " tets)" << std::endl;
+    if (!valid)
+      std::cout << "(refiner: " << error << ")" << std::endl;
+    if (!fullValid)
+      std::cout << "(fully split: " << fullError << ")" << std::endl;
+    bool pass = valid && fullValid && badEdges == 0 && !indices.empty();
+    std::cout << (pass ? "PASS" : "FAIL")
+              << ": conforming tets and a closed surface" << std::endl;
+
+    int frame = 0;
+    Measure(options, "volume Update, wandering camera, depth 6", [&] {
+      wander(camera, frame++);
+      refiner.Update(camera);
+    });
+    Measure(options, "volume ExtractSurface, depth 6", [&] {
+      refiner.ExtractSurface(vertices, indices);
+    });
+  }
+
+  const Case cases[] = {
+      {"ecs", BenchEcs},
+      {"parallel", BenchParallelEach},
+      {"gravity", BenchGravity},
+      {"origin", BenchOrigin},
+      {"noise", BenchNoise},
+      {"volume", BenchVolume},
+  };
+}
+
+bool bench::Run(const std::vector<const char*>& args) {
+  std::string name;
+  Options options;
+  for (size_t i = 0; i + 1 < args.size(); i++) {
+    std::string arg = args[i];
+    if (arg == "--cpubench")
+      name = args[i + 1];
+    else if (arg == "-bw" || arg == "--benchwarmup")
+      options.warmup = strtoul(args[i + 1], nullptr, 10);
+    else if (arg == "-br" || arg == "--benchruntime")
+      options.duration = strtoul(args[i + 1], nullptr, 10);
+  }
+  if (name.empty())
+    return false;
+
+  bool found = false;
+  for (auto& c : cases) {
+    if (name != "all" && name != c.name)
+      continue;
+    std::cout << "******** " << c.name << " ********" << std::endl;
+    c.run(options);
+    found = true;
+  }
+
+  if (!found) {
+    std::cerr << "Unknown benchmark " << name << ", pick all or one of:";
+    for (auto& c : cases)
+      std::cerr << " " << c.name;
+    std::cerr << std::endl;
+  }
+  return true;
+}
@@ -0,0 +1,21 @@
+#pragma once
+
+#include <vector>
+
+namespace uni
+{
+	namespace bench
+	{
+		/**
+		* @brief CPU benchmarks of engine subsystems, timed with vks::Benchmark instead of the render loop
+		*
+		* Start the engine with --cpubench <name> to run one of them, or --cpubench all, before any window or device is
+		* made. -bw and -br set the warmup and runtime of each case in seconds the same as they do for --benchmark.
+		* Every case reports its passes per second as "fps", cases that have a scalar or brute force reference run it
+		* right after so the two can be compared. Cases that check results as well print PASS or FAIL.
+		*
+		* @return True if benchmarks were asked for and ran, the engine should exit
+		*/
+		bool Run(const std::vector<const char*>& args);
+	}
+}
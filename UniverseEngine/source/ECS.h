@@ -25,9 +25,17 @@ SOFTWARE.
 #include <unordered_map>
 #include <functional>
 #include <vector>
+#include <map>
+#include <tuple>
 #include <algorithm>
 #include <stdint.h>
 #include <type_traits>
+#include <memory>
+#include <deque>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <atomic>
 
 //////////////////////////////////////////////////////////////////////////
 // SETTINGS //
@@ -54,6 +62,17 @@ SOFTWARE.
 // leaks.
 //#define ECS_TICK_NO_CLEANUP
 
+// Define ECS_ARCHETYPE_STORAGE to group entities by their exact set of components (their archetype). Components of
+// entities that share an archetype live in shared contiguous arrays, and each()/readOnlyEach() walk only the archetypes
+// that match instead of probing every entity's component map. See ECS::IsPackedComponent for which components are
+// stored inline. The entity each() is visiting may gain or lose components, but do not add or remove components on
+// other entities while iterating with each() in this mode.
+//#define ECS_ARCHETYPE_STORAGE
+
+// World::tick runs systems one after another in registration order by default. Call World::setTickMode(TickMode::Parallel)
+// to let systems whose declared component access does not conflict run at the same time on a worker pool, see
+// EntitySystem::reads()/writes().
+
 // Define ECS_NO_RTTI to turn off RTTI. This requires using the ECS_DEFINE_TYPE and ECS_DECLARE_TYPE macros on all types
 // that you wish to use as components or events. If you use ECS_NO_RTTI, also place ECS_TYPE_IMPLEMENTATION in a single cpp file.
 //#define ECS_NO_RTTI
@@ -133,9 +152,30 @@ namespace ECS
 	typedef float DefaultTickData;
 	typedef ECS_ALLOCATOR_TYPE Allocator;
 
+	/**
+	* With ECS_ARCHETYPE_STORAGE, components for which this is true are stored by value in their archetype's arrays.
+	* Those arrays are moved around when entities change archetype or an archetype grows, so only types that can be
+	* moved without side effects (no destructor releasing resources, no pointers into themselves) should be packed.
+	* Everything else is allocated on its own as before and the archetype stores a pointer to it.
+	*
+	* Trivially copyable types are packed automatically. Use ECS_PACKED_COMPONENT(Type) at global scope, next to the
+	* component's definition, to opt in other types.
+	*/
+	template<typename T>
+	struct IsPackedComponent : std::integral_constant<bool, std::is_trivially_copyable<T>::value>
+	{
+	};
+
+#define ECS_PACKED_COMPONENT(name) template<> struct ECS::IsPackedComponent<name> : std::true_type {}
+
 	// Do not use anything in the Internal namespace yourself.
 	namespace Internal
 	{
+		class Archetype;
+
+		template<typename T>
+		struct ComponentContainer;
+
 		template<typename... Types>
 		class EntityComponentView;
 
@@ -345,9 +385,20 @@ namespace ECS
 		{
 		}
 
+#ifdef ECS_ARCHETYPE_STORAGE
+		/**
+		* Handles handed out by an entity remember it, so the component can be found again after the archetype
+		* arrays it lives in have been resized or the entity has moved to another archetype.
+		*/
+		ComponentHandle(T* component, Entity* entity, uint32_t version)
+			: component(component), entity(entity), version(version)
+		{
+		}
+#endif
+
 		T* operator->() const
 		{
-			return component;
+			return resolve();
 		}
 
 		operator bool() const
@@ -357,16 +408,29 @@ namespace ECS
 
 		T& get()
 		{
-			return *component;
+			return *resolve();
 		}
 
 		bool isValid() const
 		{
-			return component != nullptr;
+			return resolve() != nullptr;
 		}
 
 	private:
+#ifdef ECS_ARCHETYPE_STORAGE
+		T* resolve() const;
+
+		T* component;
+		Entity* entity = nullptr;
+		uint32_t version = 0;
+#else
+		T* resolve() const
+		{
+			return component;
+		}
+
 		T * component;
+#endif
 	};
 
 	/**
@@ -445,6 +509,80 @@ namespace ECS
 #endif
 		{
 		}
+
+		/**
+		* Does this system have to wait for (or hold back) the other one? Systems that never declared their access
+		* conflict with everything, so they always run on their own.
+		*/
+		bool conflictsWith(const EntitySystem& other) const
+		{
+			if (!bAccessDeclared || !other.bAccessDeclared)
+				return true;
+
+			for (auto type : writeSet)
+			{
+				if (other.accesses(type))
+					return true;
+			}
+
+			for (auto type : other.writeSet)
+			{
+				if (accesses(type))
+					return true;
+			}
+
+			return false;
+		}
+
+		bool isMainThreadOnly() const
+		{
+			return bMainThreadOnly;
+		}
+
+	protected:
+		/**
+		* Declare components this system only reads during tick(). Call reads<>() with no types for a system that
+		* touches no components at all. Declarations are used by the parallel scheduler in World::tick.
+		*/
+		template<typename... Types>
+		void reads()
+		{
+			bAccessDeclared = true;
+			std::initializer_list<TypeIndex> types = { getTypeIndex<Types>()... };
+			readSet.insert(readSet.end(), types);
+		}
+
+		/**
+		* Declare components this system modifies during tick().
+		*/
+		template<typename... Types>
+		void writes()
+		{
+			bAccessDeclared = true;
+			std::initializer_list<TypeIndex> types = { getTypeIndex<Types>()... };
+			writeSet.insert(writeSet.end(), types);
+		}
+
+		/**
+		* Always tick this system on the thread calling World::tick, for systems talking to the GPU, audio or
+		* anything else that isn't thread safe.
+		*/
+		void runsOnMainThread()
+		{
+			bMainThreadOnly = true;
+		}
+
+	private:
+		bool accesses(TypeIndex type) const
+		{
+			return std::find(readSet.begin(), readSet.end(), type) != readSet.end()
+				|| std::find(writeSet.begin(), writeSet.end(), type) != writeSet.end();
+		}
+
+		std::vector<TypeIndex> readSet;
+		std::vector<TypeIndex> writeSet;
+		bool bAccessDeclared = false;
+		bool bMainThreadOnly = false;
 	};
 
 	/**
@@ -509,6 +647,171 @@ namespace ECS
 #endif
 	}
 
+	namespace Internal
+	{
+		/**
+		* Small work-stealing pool used by the world's parallel scheduler. Each worker takes jobs from the back of its own
+		* queue and steals from the front of the others once it runs dry. A thread waiting on work it submitted should
+		* help out with tryRunOne() rather than block, so nested waits can't starve the pool.
+		*/
+		class JobPool
+		{
+		public:
+			using Job = std::function<void()>;
+
+			JobPool(unsigned threadCount)
+			{
+				// The extra queue at the end takes jobs submitted from threads outside the pool.
+				for (unsigned i = 0; i <= threadCount; ++i)
+				{
+					queues.emplace_back(new Queue());
+				}
+
+				for (unsigned i = 0; i < threadCount; ++i)
+				{
+					threads.emplace_back(&JobPool::workerLoop, this, i);
+				}
+			}
+
+			~JobPool()
+			{
+				{
+					std::lock_guard<std::mutex> lock(sleepMutex);
+					bStopping = true;
+				}
+				sleepCondition.notify_all();
+
+				for (auto& thread : threads)
+				{
+					thread.join();
+				}
+			}
+
+			unsigned getThreadCount() const
+			{
+				return static_cast<unsigned>(threads.size());
+			}
+
+			void submit(Job job)
+			{
+				Queue& queue = *queues[localQueueIndex()];
+				{
+					std::lock_guard<std::mutex> lock(queue.mutex);
+					queue.jobs.push_back(std::move(job));
+				}
+				{
+					std::lock_guard<std::mutex> lock(sleepMutex);
+					++queued;
+				}
+				sleepCondition.notify_one();
+			}
+
+			/**
+			* Run one queued job on the calling thread. Returns false if there was nothing to do.
+			*/
+			bool tryRunOne()
+			{
+				Job job;
+				if (!take(localQueueIndex(), job))
+					return false;
+
+				job();
+				return true;
+			}
+
+		private:
+			struct Queue
+			{
+				std::mutex mutex;
+				std::deque<Job> jobs;
+			};
+
+			struct Worker
+			{
+				const JobPool* pool = nullptr;
+				size_t index = 0;
+			};
+
+			static Worker& currentWorker()
+			{
+				thread_local Worker worker;
+				return worker;
+			}
+
+			size_t localQueueIndex() const
+			{
+				const Worker& worker = currentWorker();
+				return worker.pool == this ? worker.index : queues.size() - 1;
+			}
+
+			bool take(size_t index, Job& job)
+			{
+				for (size_t i = 0; i < queues.size(); ++i)
+				{
+					Queue& queue = *queues[(index + i) % queues.size()];
+					std::lock_guard<std::mutex> lock(queue.mutex);
+					if (queue.jobs.empty())
+						continue;
+
+					// Own queue LIFO for locality, stolen work FIFO so the oldest (usually biggest) jobs move.
+					if (i == 0)
+					{
+						job = std::move(queue.jobs.back());
+						queue.jobs.pop_back();
+					}
+					else
+					{
+						job = std::move(queue.jobs.front());
+						queue.jobs.pop_front();
+					}
+
+					--queued;
+					return true;
+				}
+
+				return false;
+			}
+
+			void workerLoop(size_t index)
+			{
+				currentWorker() = { this, index };
+
+				while (true)
+				{
+					Job job;
+					if (take(index, job))
+					{
+						job();
+						continue;
+					}
+
+					std::unique_lock<std::mutex> lock(sleepMutex);
+					sleepCondition.wait(lock, [this]() { return bStopping || queued > 0; });
+					if (bStopping && queued == 0)
+						return;
+				}
+			}
+
+			std::vector<std::unique_ptr<Queue>> queues;
+			std::vector<std::thread> threads;
+
+			std::mutex sleepMutex;
+			std::condition_variable sleepCondition;
+			std::atomic<size_t> queued{ 0 };
+			bool bStopping = false;
+		};
+	}
+
+	enum class TickMode
+	{
+		// Tick every system on the calling thread in registration order. Deterministic, use this when debugging.
+		Serial,
+
+		// Tick systems whose declared component access doesn't conflict at the same time. Systems still run after
+		// every conflicting system registered before them, so results match Serial as long as declarations are honest.
+		Parallel
+	};
+
 	/**
 	* The world creates, destroys, and manages entities. The lifetime of entities and _registered_ systems are handled by the world
 	* (don't delete a system without unregistering it from the world first!), while event subscribers have their own lifetimes
@@ -578,6 +881,9 @@ namespace ECS
 			Entity* ent = std::allocator_traits<EntityAllocator>::allocate(entAlloc, 1);
 			std::allocator_traits<EntityAllocator>::construct(entAlloc, ent, this, lastEntityId);
 			entities.push_back(ent);
+#ifdef ECS_ARCHETYPE_STORAGE
+			addToRootArchetype(ent);
+#endif
 
 			emit<Events::OnEntityCreated>({ ent });
 
@@ -618,6 +924,7 @@ namespace ECS
 		{
 			systems.push_back(system);
 			system->configure(this);
+			bScheduleDirty = true;
 		}
 
 		/**
@@ -627,6 +934,39 @@ namespace ECS
 		{
 			systems.erase(std::remove(systems.begin(), systems.end(), system), systems.end());
 			system->unconfigure(this);
+			bScheduleDirty = true;
+		}
+
+		/**
+		* Choose how tick() runs systems. threadCount is the number of worker threads for TickMode::Parallel, 0 picks
+		* one less than the number of hardware threads (the calling thread works too).
+		*
+		* Multithreading: Systems may run on worker threads in parallel mode, and so may any events they emit.
+		*/
+		void setTickMode(TickMode mode, unsigned threadCount = 0)
+		{
+			tickMode = mode;
+
+			if (mode == TickMode::Parallel)
+			{
+				if (threadCount == 0)
+					threadCount = std::max(1u, std::thread::hardware_concurrency()) - 1;
+
+				if (threadCount == 0)
+				{
+					tickMode = TickMode::Serial;
+					jobPool.reset();
+				}
+				else if (!jobPool || jobPool->getThreadCount() != threadCount)
+				{
+					jobPool.reset(new Internal::JobPool(threadCount));
+				}
+			}
+		}
+
+		TickMode getTickMode() const
+		{
+			return tickMode;
 		}
 
 		/**
@@ -717,6 +1057,25 @@ namespace ECS
 		template<typename... Types>
 		void readOnlyEach(typename std::common_type<std::function<void(const Entity* const, ConstComponentHandle<Types>...)>>::type viewFunc, bool bIncludePendingDestroy = false) const;
 
+		/**
+		* Like each(), but splits the matching entities into chunks of chunkSize and runs them on the worker pool. The
+		* calling thread works through chunks too and returns once all of them are done.
+		*
+		* viewFunc is called concurrently, so it may only write to the components it is given (and thread safe state).
+		* Don't create or destroy entities or add/remove components until parallelEach returns. Without a worker pool
+		* (TickMode::Serial) everything runs on the calling thread.
+		*/
+		template<typename... Types, typename Func>
+		void parallelEach(Func&& viewFunc, size_t chunkSize = 256, bool bIncludePendingDestroy = false);
+
+		/**
+		* Split [0, count) into ranges of up to chunkSize and call rangeFunc(first, last) for each of them on the worker
+		* pool, the same way parallelEach splits entities. For work that isn't laid out by entity, like a pass over an
+		* array a system built earlier in its tick.
+		*/
+		template<typename Func>
+		void parallelFor(size_t count, Func&& rangeFunc, size_t chunkSize = 256);
+
 		/**
 		* Run a function on all entities.
 		*/
@@ -783,13 +1142,24 @@ namespace ECS
 #ifndef ECS_TICK_NO_CLEANUP
 			cleanup();
 #endif
-			for (auto* system : systems)
-			{
+			auto tickSystem = [&](EntitySystem* system) {
 #ifdef ECS_TICK_TYPE_VOID
 				system->tick(this);
 #else
 				system->tick(this, data);
 #endif
+			};
+
+			if (tickMode == TickMode::Serial || !jobPool)
+			{
+				for (auto* system : systems)
+				{
+					tickSystem(system);
+				}
+			}
+			else
+			{
+				tickScheduled(tickSystem);
 			}
 		}
 
@@ -799,6 +1169,41 @@ namespace ECS
 		}
 
 	private:
+		// Work out which systems each system has to wait for. Only conflicts with systems registered earlier count,
+		// so the order of conflicting systems is always the registration order.
+		void rebuildSchedule();
+
+		template<typename F>
+		void tickScheduled(F& tickSystem);
+
+		TickMode tickMode = TickMode::Serial;
+		std::unique_ptr<Internal::JobPool> jobPool;
+
+		/** @brief call runChunk(i) for every i in [0, chunkCount) on the worker pool and the calling thread */
+		template<typename Func>
+		void runChunks(size_t chunkCount, Func&& runChunk);
+
+		bool bScheduleDirty = true;
+		std::vector<std::vector<size_t>> scheduleDependents;
+		std::vector<size_t> scheduleDependencyCount;
+
+#ifdef ECS_ARCHETYPE_STORAGE
+		friend class Entity;
+
+		void addToRootArchetype(Entity* ent);
+
+		Internal::Archetype* findArchetype(const std::vector<TypeIndex>& signature) const;
+
+		template<typename T>
+		Internal::Archetype* getArchetypeWith(Internal::Archetype* from);
+
+		Internal::Archetype* getArchetypeWithout(Internal::Archetype* from, TypeIndex type);
+
+		// archetypes[0] is the empty archetype every entity starts in
+		std::vector<Internal::Archetype*> archetypes;
+		std::map<std::vector<TypeIndex>, Internal::Archetype*> archetypesBySignature;
+#endif
+
 		EntityAllocator entAlloc;
 		SystemAllocator systemAlloc;
 
@@ -813,6 +1218,109 @@ namespace ECS
 		size_t lastEntityId = 0;
 	};
 
+#ifdef ECS_ARCHETYPE_STORAGE
+	namespace Internal
+	{
+		/**
+		* Type-erased array holding one component type for every entity of an archetype. Rows line up with
+		* Archetype::entities.
+		*/
+		struct BaseColumn
+		{
+		public:
+			BaseColumn(World* world, TypeIndex type)
+				: world(world), type(type)
+			{
+			}
+
+			virtual ~BaseColumn() { }
+
+			// Release this column and anything it still owns.
+			virtual void destroy() = 0;
+
+			// Create an empty column for the same component type.
+			virtual BaseColumn* cloneEmpty() const = 0;
+
+			virtual void reserve(size_t capacity) = 0;
+
+			// Append the component at row to dst, which holds the same component type. The row itself is left in place.
+			virtual void moveTo(size_t row, BaseColumn* dst) = 0;
+
+			// Remove a row by moving the last row into its place. When bDestroy is false the component was handed
+			// to another column with moveTo() and only the slot is released.
+			virtual void swapRemove(size_t row, bool bDestroy) = 0;
+
+			// Emit OnComponentRemoved for the component at row.
+			virtual void removed(Entity* ent, size_t row) = 0;
+
+			World* world;
+			TypeIndex type;
+		};
+
+		/**
+		* All entities with exactly the same set of components. Columns are kept in the same (sorted) order as the signature.
+		*/
+		class Archetype
+		{
+		public:
+			Archetype(const std::vector<TypeIndex>& signature)
+				: signature(signature)
+			{
+			}
+
+			~Archetype()
+			{
+				for (auto* column : columns)
+				{
+					column->destroy();
+				}
+			}
+
+			/**
+			* Index of the column holding a component type, or -1. Signatures are short, so this is a linear scan.
+			*/
+			int find(TypeIndex type) const
+			{
+				for (size_t i = 0; i < signature.size(); ++i)
+				{
+					if (signature[i] == type)
+						return static_cast<int>(i);
+				}
+
+				return -1;
+			}
+
+			template<typename... Types>
+			bool matches() const
+			{
+				return ((find(getTypeIndex<Types>()) >= 0) && ...);
+			}
+
+			size_t size() const
+			{
+				return entities.size();
+			}
+
+			// Make room for count rows up front so that columns never reallocate behind an outstanding handle's back.
+			void reserve(size_t count);
+
+			// Append an entity whose components have already been pushed onto every column.
+			void push(Entity* ent);
+
+			// Remove a row from every column and patch up the entity moved into its place.
+			void swapRemove(size_t row, const Archetype* movedTo);
+
+			std::vector<TypeIndex> signature;
+			std::vector<BaseColumn*> columns;
+			std::vector<Entity*> entities;
+
+			// Cached archetype graph edges, keyed by the component type added or removed.
+			std::unordered_map<TypeIndex, Archetype*> addEdges;
+			std::unordered_map<TypeIndex, Archetype*> removeEdges;
+		};
+	}
+#endif
+
 	/**
 	* A container for components. Entities do not have any logic of their own, except of that which to manage
 	* components. Components themselves are generally structs that contain data with which EntitySystems can
@@ -823,6 +1331,12 @@ namespace ECS
 	{
 	public:
 		friend class World;
+#ifdef ECS_ARCHETYPE_STORAGE
+		friend class Internal::Archetype;
+
+		template<typename T>
+		friend class ComponentHandle;
+#endif
 
 		const static size_t InvalidEntityId = 0;
 
@@ -835,7 +1349,11 @@ namespace ECS
 		// Do not delete entities yourself, use World::destroy().
 		~Entity()
 		{
+#ifdef ECS_ARCHETYPE_STORAGE
+			detach();
+#else
 			removeAll();
+#endif
 		}
 
 		/**
@@ -853,7 +1371,11 @@ namespace ECS
 		bool has() const
 		{
 			auto index = getTypeIndex<T>();
+#ifdef ECS_ARCHETYPE_STORAGE
+			return archetype != nullptr && archetype->find(index) >= 0;
+#else
 			return components.find(index) != components.end();
+#endif
 		}
 
 		/**
@@ -880,6 +1402,9 @@ namespace ECS
 		*/
 		template<typename T>
 		bool remove()
+#ifdef ECS_ARCHETYPE_STORAGE
+			;
+#else
 		{
 			auto found = components.find(getTypeIndex<T>());
 			if (found != components.end())
@@ -894,11 +1419,15 @@ namespace ECS
 
 			return false;
 		}
+#endif
 
 		/**
 		* Remove all components from this entity.
 		*/
 		void removeAll()
+#ifdef ECS_ARCHETYPE_STORAGE
+			;
+#else
 		{
 			for (auto pair : components)
 			{
@@ -908,6 +1437,7 @@ namespace ECS
 
 			components.clear();
 		}
+#endif
 
 		/**
 		* Get a component from this entity.
@@ -949,7 +1479,24 @@ namespace ECS
 		}
 
 	private:
+#ifdef ECS_ARCHETYPE_STORAGE
+		template<typename T>
+		T* getPtr() const;
+
+		// Move this entity's components into target, destroying any that target has no column for.
+		void migrate(Internal::Archetype* target);
+
+		// Remove every component and leave no archetype at all. Only the destructor should need this.
+		void detach();
+
+		Internal::Archetype* archetype = nullptr;
+		size_t row = 0;
+
+		// Bumped whenever this entity's components move in memory, see ComponentHandle.
+		uint32_t storageVersion = 0;
+#else
 		std::unordered_map<TypeIndex, Internal::BaseComponentContainer*> components;
+#endif
 		World* world;
 
 		size_t id;
@@ -1069,6 +1616,213 @@ namespace ECS
 				ent->getWorld()->emit<Events::OnComponentRemoved<T>>({ ent, handle });
 			}
 		};
+
+#ifdef ECS_ARCHETYPE_STORAGE
+		/**
+		* Column storing components by value, used for types where IsPackedComponent is true.
+		*/
+		template<typename T>
+		struct PackedColumn : public BaseColumn
+		{
+			using ValueAllocator = typename std::allocator_traits<World::EntityAllocator>::template rebind_alloc<T>;
+			using ColumnAllocator = typename std::allocator_traits<World::EntityAllocator>::template rebind_alloc<PackedColumn<T>>;
+
+			static PackedColumn<T>* create(World* world)
+			{
+				ColumnAllocator alloc(world->getPrimaryAllocator());
+				PackedColumn<T>* column = std::allocator_traits<ColumnAllocator>::allocate(alloc, 1);
+				std::allocator_traits<ColumnAllocator>::construct(alloc, column, world);
+				return column;
+			}
+
+			PackedColumn(World* world)
+				: BaseColumn(world, getTypeIndex<T>()), data(ValueAllocator(world->getPrimaryAllocator()))
+			{
+			}
+
+			T* get(size_t row) const
+			{
+				return const_cast<T*>(&data[row]);
+			}
+
+			void push(T&& value)
+			{
+				data.push_back(std::move(value));
+			}
+
+			virtual void destroy() override
+			{
+				ColumnAllocator alloc(world->getPrimaryAllocator());
+				std::allocator_traits<ColumnAllocator>::destroy(alloc, this);
+				std::allocator_traits<ColumnAllocator>::deallocate(alloc, this, 1);
+			}
+
+			virtual BaseColumn* cloneEmpty() const override
+			{
+				return create(world);
+			}
+
+			virtual void reserve(size_t capacity) override
+			{
+				data.reserve(capacity);
+			}
+
+			virtual void moveTo(size_t row, BaseColumn* dst) override
+			{
+				static_cast<PackedColumn<T>*>(dst)->data.push_back(std::move(data[row]));
+			}
+
+			virtual void swapRemove(size_t row, bool bDestroy) override
+			{
+				// A moved-from value is destroyed just the same, so bDestroy makes no difference here.
+				if (row + 1 < data.size())
+				{
+					data[row] = std::move(data.back());
+				}
+				data.pop_back();
+			}
+
+			virtual void removed(Entity* ent, size_t row) override
+			{
+				auto handle = ComponentHandle<T>(get(row));
+				world->emit<Events::OnComponentRemoved<T>>({ ent, handle });
+			}
+
+			std::vector<T, ValueAllocator> data;
+		};
+
+		/**
+		* Column storing pointers to individually allocated components, used for everything that isn't packed. The
+		* components never move, only the pointers do.
+		*/
+		template<typename T>
+		struct BoxedColumn : public BaseColumn
+		{
+			using PtrAllocator = typename std::allocator_traits<World::EntityAllocator>::template rebind_alloc<ComponentContainer<T>*>;
+			using ComponentAllocator = typename std::allocator_traits<World::EntityAllocator>::template rebind_alloc<ComponentContainer<T>>;
+			using ColumnAllocator = typename std::allocator_traits<World::EntityAllocator>::template rebind_alloc<BoxedColumn<T>>;
+
+			static BoxedColumn<T>* create(World* world)
+			{
+				ColumnAllocator alloc(world->getPrimaryAllocator());
+				BoxedColumn<T>* column = std::allocator_traits<ColumnAllocator>::allocate(alloc, 1);
+				std::allocator_traits<ColumnAllocator>::construct(alloc, column, world);
+				return column;
+			}
+
+			BoxedColumn(World* world)
+				: BaseColumn(world, getTypeIndex<T>()), data(PtrAllocator(world->getPrimaryAllocator()))
+			{
+			}
+
+			T* get(size_t row) const
+			{
+				return &data[row]->data;
+			}
+
+			void push(T&& value)
+			{
+				ComponentAllocator alloc(world->getPrimaryAllocator());
+
+				ComponentContainer<T>* container = std::allocator_traits<ComponentAllocator>::allocate(alloc, 1);
+				std::allocator_traits<ComponentAllocator>::construct(alloc, container, value);
+				data.push_back(container);
+			}
+
+			virtual void destroy() override
+			{
+				for (auto* container : data)
+				{
+					static_cast<BaseComponentContainer*>(container)->destroy(world);
+				}
+				data.clear();
+
+				ColumnAllocator alloc(world->getPrimaryAllocator());
+				std::allocator_traits<ColumnAllocator>::destroy(alloc, this);
+				std::allocator_traits<ColumnAllocator>::deallocate(alloc, this, 1);
+			}
+
+			virtual BaseColumn* cloneEmpty() const override
+			{
+				return create(world);
+			}
+
+			virtual void reserve(size_t capacity) override
+			{
+				data.reserve(capacity);
+			}
+
+			virtual void moveTo(size_t row, BaseColumn* dst) override
+			{
+				static_cast<BoxedColumn<T>*>(dst)->data.push_back(data[row]);
+			}
+
+			virtual void swapRemove(size_t row, bool bDestroy) override
+			{
+				if (bDestroy)
+				{
+					static_cast<BaseComponentContainer*>(data[row])->destroy(world);
+				}
+				data[row] = data.back();
+				data.pop_back();
+			}
+
+			virtual void removed(Entity* ent, size_t row) override
+			{
+				static_cast<BaseComponentContainer*>(data[row])->removed(ent);
+			}
+
+			std::vector<ComponentContainer<T>*, PtrAllocator> data;
+		};
+
+		template<typename T>
+		using ColumnFor = typename std::conditional<IsPackedComponent<T>::value, PackedColumn<T>, BoxedColumn<T>>::type;
+
+		inline void Archetype::reserve(size_t count)
+		{
+			if (count <= entities.capacity())
+				return;
+
+			size_t capacity = std::max<size_t>(std::max<size_t>(count, entities.capacity() * 2), 16);
+			for (auto* column : columns)
+			{
+				column->reserve(capacity);
+			}
+			entities.reserve(capacity);
+
+			// Packed columns may have moved, make outstanding handles look their component up again.
+			for (auto* ent : entities)
+			{
+				++ent->storageVersion;
+			}
+		}
+
+		inline void Archetype::push(Entity* ent)
+		{
+			ent->archetype = this;
+			ent->row = entities.size();
+			++ent->storageVersion;
+			entities.push_back(ent);
+		}
+
+		inline void Archetype::swapRemove(size_t row, const Archetype* movedTo)
+		{
+			for (auto* column : columns)
+			{
+				bool bMoved = movedTo != nullptr && movedTo->find(column->type) >= 0;
+				column->swapRemove(row, !bMoved);
+			}
+
+			if (row + 1 < entities.size())
+			{
+				Entity* last = entities.back();
+				entities[row] = last;
+				last->row = row;
+				++last->storageVersion;
+			}
+			entities.pop_back();
+		}
+#endif
 	}
 
 	inline World::~World()
@@ -1091,8 +1845,203 @@ namespace ECS
 			std::allocator_traits<SystemAllocator>::destroy(systemAlloc, system);
 			std::allocator_traits<SystemAllocator>::deallocate(systemAlloc, system, 1);
 		}
+
+#ifdef ECS_ARCHETYPE_STORAGE
+		for (auto* archetype : archetypes)
+		{
+			delete archetype;
+		}
+#endif
+	}
+
+	inline void World::rebuildSchedule()
+	{
+		scheduleDependents.assign(systems.size(), {});
+		scheduleDependencyCount.assign(systems.size(), 0);
+
+		for (size_t i = 0; i < systems.size(); ++i)
+		{
+			for (size_t j = i + 1; j < systems.size(); ++j)
+			{
+				if (systems[i]->conflictsWith(*systems[j]))
+				{
+					scheduleDependents[i].push_back(j);
+					++scheduleDependencyCount[j];
+				}
+			}
+		}
+
+		bScheduleDirty = false;
+	}
+
+	template<typename F>
+	void World::tickScheduled(F& tickSystem)
+	{
+		if (bScheduleDirty)
+			rebuildSchedule();
+
+		std::mutex mutex;
+		std::condition_variable finishedCondition;
+		std::vector<size_t> remaining = scheduleDependencyCount;
+		std::deque<size_t> mainThreadReady;
+		size_t finished = 0;
+
+		std::function<void(size_t)> launch;
+
+		auto finish = [&](size_t index) {
+			std::vector<size_t> ready;
+			{
+				std::lock_guard<std::mutex> lock(mutex);
+				for (auto dependent : scheduleDependents[index])
+				{
+					if (--remaining[dependent] == 0)
+						ready.push_back(dependent);
+				}
+			}
+
+			for (auto dependent : ready)
+			{
+				launch(dependent);
+			}
+
+			// Notify with the lock held: once finished reaches the system count the waiting thread returns and the
+			// condition variable goes out of scope.
+			std::lock_guard<std::mutex> lock(mutex);
+			++finished;
+			finishedCondition.notify_all();
+		};
+
+		launch = [&](size_t index) {
+			if (systems[index]->isMainThreadOnly())
+			{
+				std::lock_guard<std::mutex> lock(mutex);
+				mainThreadReady.push_back(index);
+				finishedCondition.notify_all();
+			}
+			else
+			{
+				jobPool->submit([&, index]() {
+					tickSystem(systems[index]);
+					finish(index);
+				});
+			}
+		};
+
+		for (size_t i = 0; i < systems.size(); ++i)
+		{
+			if (scheduleDependencyCount[i] == 0)
+				launch(i);
+		}
+
+		// The calling thread ticks main thread systems and otherwise helps the pool until everything is done.
+		std::unique_lock<std::mutex> lock(mutex);
+		while (finished < systems.size())
+		{
+			if (!mainThreadReady.empty())
+			{
+				size_t index = mainThreadReady.front();
+				mainThreadReady.pop_front();
+
+				lock.unlock();
+				tickSystem(systems[index]);
+				finish(index);
+				lock.lock();
+				continue;
+			}
+
+			lock.unlock();
+			bool bRan = jobPool->tryRunOne();
+			lock.lock();
+
+			if (!bRan && finished < systems.size() && mainThreadReady.empty())
+				finishedCondition.wait(lock);
+		}
 	}
 
+#ifdef ECS_ARCHETYPE_STORAGE
+	inline void World::addToRootArchetype(Entity* ent)
+	{
+		if (archetypes.empty())
+		{
+			auto* root = new Internal::Archetype({});
+			archetypes.push_back(root);
+			archetypesBySignature.insert({ root->signature, root });
+		}
+
+		Internal::Archetype* root = archetypes[0];
+		root->reserve(root->size() + 1);
+		root->push(ent);
+	}
+
+	inline Internal::Archetype* World::findArchetype(const std::vector<TypeIndex>& signature) const
+	{
+		auto found = archetypesBySignature.find(signature);
+		if (found != archetypesBySignature.end())
+			return found->second;
+
+		return nullptr;
+	}
+
+	template<typename T>
+	Internal::Archetype* World::getArchetypeWith(Internal::Archetype* from)
+	{
+		auto index = getTypeIndex<T>();
+		auto edge = from->addEdges.find(index);
+		if (edge != from->addEdges.end())
+			return edge->second;
+
+		std::vector<TypeIndex> signature = from->signature;
+		signature.insert(std::upper_bound(signature.begin(), signature.end(), index), index);
+
+		Internal::Archetype* to = findArchetype(signature);
+		if (to == nullptr)
+		{
+			to = new Internal::Archetype(signature);
+			for (auto type : signature)
+			{
+				if (type == index)
+					to->columns.push_back(Internal::ColumnFor<T>::create(this));
+				else
+					to->columns.push_back(from->columns[from->find(type)]->cloneEmpty());
+			}
+
+			archetypes.push_back(to);
+			archetypesBySignature.insert({ signature, to });
+		}
+
+		from->addEdges[index] = to;
+		to->removeEdges[index] = from;
+		return to;
+	}
+
+	inline Internal::Archetype* World::getArchetypeWithout(Internal::Archetype* from, TypeIndex index)
+	{
+		auto edge = from->removeEdges.find(index);
+		if (edge != from->removeEdges.end())
+			return edge->second;
+
+		std::vector<TypeIndex> signature = from->signature;
+		signature.erase(std::remove(signature.begin(), signature.end(), index), signature.end());
+
+		Internal::Archetype* to = findArchetype(signature);
+		if (to == nullptr)
+		{
+			to = new Internal::Archetype(signature);
+			for (auto type : signature)
+			{
+				to->columns.push_back(from->columns[from->find(type)]->cloneEmpty());
+			}
+
+			archetypes.push_back(to);
+			archetypesBySignature.insert({ signature, to });
+		}
+
+		from->removeEdges[index] = to;
+		to->addEdges[index] = from;
+		return to;
+	}
+#endif
+
 	inline void World::destroy(Entity* ent, bool immediate)
 	{
 		if (ent == nullptr)
@@ -1190,21 +2139,330 @@ namespace ECS
 	template<typename... Types>
 	void World::each(typename std::common_type<std::function<void(Entity*, ComponentHandle<Types>...)>>::type viewFunc, bool bIncludePendingDestroy)
 	{
+#ifdef ECS_ARCHETYPE_STORAGE
+		// Indexed on purpose: viewFunc may create new archetypes or grow the one being walked.
+		for (size_t a = 0; a < archetypes.size(); ++a)
+		{
+			Internal::Archetype* archetype = archetypes[a];
+			if (!archetype->template matches<Types...>())
+				continue;
+
+			std::tuple<Internal::ColumnFor<Types>*...> columns(static_cast<Internal::ColumnFor<Types>*>(archetype->columns[archetype->find(getTypeIndex<Types>())])...);
+			for (size_t row = 0; row < archetype->size();)
+			{
+				Entity* ent = archetype->entities[row];
+				if (!ent->isPendingDestroy() || bIncludePendingDestroy)
+				{
+					viewFunc(ent, ComponentHandle<Types>(std::get<Internal::ColumnFor<Types>*>(columns)->get(row), ent, ent->storageVersion)...);
+				}
+
+				// If viewFunc moved ent to another archetype, the last entity was swapped into its row and is next.
+				if (row < archetype->size() && archetype->entities[row] == ent)
+				{
+					++row;
+				}
+			}
+		}
+#else
 		for (auto* ent : each<Types...>(bIncludePendingDestroy))
 		{
 			viewFunc(ent, ent->template get<Types>()...);
 		}
+#endif
+	}
+
+	template<typename... Types, typename Func>
+	void World::parallelEach(Func&& viewFunc, size_t chunkSize, bool bIncludePendingDestroy)
+	{
+		if (chunkSize == 0)
+			chunkSize = 1;
+
+#ifdef ECS_ARCHETYPE_STORAGE
+		struct Chunk
+		{
+			Internal::Archetype* archetype;
+			std::tuple<Internal::ColumnFor<Types>*...> columns;
+			size_t first;
+			size_t last;
+		};
+
+		std::vector<Chunk> chunks;
+		for (auto* archetype : archetypes)
+		{
+			if (!archetype->template matches<Types...>() || archetype->size() == 0)
+				continue;
+
+			std::tuple<Internal::ColumnFor<Types>*...> columns(static_cast<Internal::ColumnFor<Types>*>(archetype->columns[archetype->find(getTypeIndex<Types>())])...);
+			for (size_t first = 0; first < archetype->size(); first += chunkSize)
+			{
+				chunks.push_back({ archetype, columns, first, std::min(first + chunkSize, archetype->size()) });
+			}
+		}
+
+		auto runChunk = [&](const Chunk& chunk) {
+			for (size_t row = chunk.first; row < chunk.last; ++row)
+			{
+				Entity* ent = chunk.archetype->entities[row];
+				if (ent->isPendingDestroy() && !bIncludePendingDestroy)
+					continue;
+
+				viewFunc(ent, ComponentHandle<Types>(std::get<Internal::ColumnFor<Types>*>(chunk.columns)->get(row), ent, ent->storageVersion)...);
+			}
+		};
+#else
+		struct Chunk
+		{
+			size_t first;
+			size_t last;
+		};
+
+		std::vector<Chunk> chunks;
+		for (size_t first = 0; first < entities.size(); first += chunkSize)
+		{
+			chunks.push_back({ first, std::min(first + chunkSize, entities.size()) });
+		}
+
+		auto runChunk = [&](const Chunk& chunk) {
+			for (size_t index = chunk.first; index < chunk.last; ++index)
+			{
+				Entity* ent = entities[index];
+				if (!ent->template has<Types...>() || (ent->isPendingDestroy() && !bIncludePendingDestroy))
+					continue;
+
+				viewFunc(ent, ent->template get<Types>()...);
+			}
+		};
+#endif
+
+		runChunks(chunks.size(), [&](size_t i) { runChunk(chunks[i]); });
+	}
+
+	template<typename Func>
+	void World::parallelFor(size_t count, Func&& rangeFunc, size_t chunkSize)
+	{
+		if (chunkSize == 0)
+			chunkSize = 1;
+
+		runChunks((count + chunkSize - 1) / chunkSize, [&](size_t i) {
+			rangeFunc(i * chunkSize, std::min(i * chunkSize + chunkSize, count));
+		});
+	}
+
+	template<typename Func>
+	void World::runChunks(size_t chunkCount, Func&& runChunk)
+	{
+		// Everyone claims chunks from one counter, so a single job per worker is queued however many chunks there are.
+		std::atomic<size_t> nextChunk{ 0 };
+		auto claimChunks = [&]() {
+			for (size_t i = nextChunk++; i < chunkCount; i = nextChunk++)
+			{
+				runChunk(i);
+			}
+		};
+
+		size_t helpers = 0;
+		if (jobPool && chunkCount > 1)
+			helpers = std::min<size_t>(jobPool->getThreadCount(), chunkCount - 1);
+
+		if (helpers == 0)
+		{
+			claimChunks();
+			return;
+		}
+
+		struct
+		{
+			std::mutex mutex;
+			std::condition_variable condition;
+			size_t done = 0;
+		} sync;
+
+		for (size_t i = 0; i < helpers; ++i)
+		{
+			jobPool->submit(Internal::JobPool::Job([&claimChunks, &sync]() {
+				claimChunks();
+
+				// Notify with the lock held: the waiting thread returns once done reaches helpers and sync goes away.
+				std::lock_guard<std::mutex> lock(sync.mutex);
+				++sync.done;
+				sync.condition.notify_all();
+			}));
+		}
+
+		claimChunks();
+
+		// Like tick, help with queued jobs (ours included, if no worker got to them) instead of spinning.
+		std::unique_lock<std::mutex> lock(sync.mutex);
+		while (sync.done < helpers)
+		{
+			lock.unlock();
+			bool bRan = jobPool->tryRunOne();
+			lock.lock();
+
+			if (!bRan && sync.done < helpers)
+				sync.condition.wait(lock);
+		}
 	}
 
 	template<typename... Types>
 	void World::readOnlyEach(typename std::common_type<std::function<void(const Entity* const, ConstComponentHandle<Types>...)>>::type viewFunc, bool bIncludePendingDestroy) const
 	{
+#ifdef ECS_ARCHETYPE_STORAGE
+		for (const Internal::Archetype* archetype : archetypes)
+		{
+			if (!archetype->template matches<Types...>())
+				continue;
+
+			std::tuple<const Internal::ColumnFor<Types>*...> columns(static_cast<const Internal::ColumnFor<Types>*>(archetype->columns[archetype->find(getTypeIndex<Types>())])...);
+			for (size_t row = 0; row < archetype->size(); ++row)
+			{
+				const Entity* const ent = archetype->entities[row];
+				if (ent->isPendingDestroy() && !bIncludePendingDestroy)
+					continue;
+
+				viewFunc(ent, ConstComponentHandle<Types>(std::get<const Internal::ColumnFor<Types>*>(columns)->get(row))...);
+			}
+		}
+#else
 		for (const Entity* const ent : readOnlyEach<Types...>(bIncludePendingDestroy))
 		{
 			viewFunc(ent, ent->template getConst<Types>()...);
 		}
+#endif
 	}
 
+#ifdef ECS_ARCHETYPE_STORAGE
+	template<typename T, typename... Args>
+	ComponentHandle<T> Entity::assign(Args&&... args)
+	{
+		using Column = Internal::ColumnFor<T>;
+
+		int found = archetype->find(getTypeIndex<T>());
+		if (found >= 0)
+		{
+			T* data = static_cast<Column*>(archetype->columns[found])->get(row);
+			*data = T(args...);
+
+			auto handle = ComponentHandle<T>(data, this, storageVersion);
+			world->emit<Events::OnComponentAssigned<T>>({ this, handle });
+			return handle;
+		}
+		else
+		{
+			Internal::Archetype* target = world->template getArchetypeWith<T>(archetype);
+			migrate(target);
+
+			Column* column = static_cast<Column*>(target->columns[target->find(getTypeIndex<T>())]);
+			column->push(T(args...));
+
+			auto handle = ComponentHandle<T>(column->get(row), this, storageVersion);
+			world->emit<Events::OnComponentAssigned<T>>({ this, handle });
+			return handle;
+		}
+	}
+
+	template<typename T>
+	bool Entity::remove()
+	{
+		auto index = getTypeIndex<T>();
+		int found = archetype->find(index);
+		if (found < 0)
+			return false;
+
+		archetype->columns[found]->removed(this, row);
+		migrate(world->getArchetypeWithout(archetype, index));
+
+		return true;
+	}
+
+	inline void Entity::removeAll()
+	{
+		if (archetype == world->archetypes[0])
+			return;
+
+		for (auto* column : archetype->columns)
+		{
+			column->removed(this, row);
+		}
+		migrate(world->archetypes[0]);
+	}
+
+	inline void Entity::migrate(Internal::Archetype* target)
+	{
+		Internal::Archetype* source = archetype;
+		size_t sourceRow = row;
+
+		target->reserve(target->size() + 1);
+		for (auto* column : source->columns)
+		{
+			int dst = target->find(column->type);
+			if (dst >= 0)
+			{
+				column->moveTo(sourceRow, target->columns[dst]);
+			}
+		}
+
+		source->swapRemove(sourceRow, target);
+		target->push(this);
+	}
+
+	inline void Entity::detach()
+	{
+		if (archetype == nullptr)
+			return;
+
+		for (auto* column : archetype->columns)
+		{
+			column->removed(this, row);
+		}
+		archetype->swapRemove(row, nullptr);
+		archetype = nullptr;
+		++storageVersion;
+	}
+
+	template<typename T>
+	T* Entity::getPtr() const
+	{
+		if (archetype == nullptr)
+			return nullptr;
+
+		int found = archetype->find(getTypeIndex<T>());
+		if (found < 0)
+			return nullptr;
+
+		return static_cast<Internal::ColumnFor<T>*>(archetype->columns[found])->get(row);
+	}
+
+	template<typename T>
+	ComponentHandle<T> Entity::get()
+	{
+		T* component = getPtr<T>();
+		if (component != nullptr)
+		{
+			return ComponentHandle<T>(component, this, storageVersion);
+		}
+
+		return ComponentHandle<T>();
+	}
+
+	template<typename T>
+	ConstComponentHandle<T> Entity::getConst() const
+	{
+		return ConstComponentHandle<T>(getPtr<T>());
+	}
+
+	template<typename T>
+	T* ComponentHandle<T>::resolve() const
+	{
+		// Nothing is written back: one handle may be resolved from several systems ticking in parallel.
+		if (entity != nullptr && entity->storageVersion != version)
+		{
+			return entity->template getPtr<T>();
+		}
+
+		return component;
+	}
+#else
 	template<typename T, typename... Args>
 	ComponentHandle<T> Entity::assign(Args&&... args)
 	{
@@ -1258,6 +2516,7 @@ namespace ECS
 
 		return ConstComponentHandle<T>();
 	}
+#endif
 
 	namespace Internal
 	{
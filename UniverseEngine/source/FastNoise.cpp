@@ -33,6 +33,13 @@
 
 #include <algorithm>
 #include <random>
+#include <vector>
+
+// SSE2 is always there on x64, 32 bit builds need /arch:SSE2 or higher
+#if !defined(FN_USE_DOUBLES) && (defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2))
+#define FN_SSE2
+#include <emmintrin.h>
+#endif
 
 const FN_DECIMAL GRAD_X[] =
 {
@@ -479,6 +486,203 @@ FN_DECIMAL FastNoise::GetNoise(FN_DECIMAL x, FN_DECIMAL y) const
 }
 
 // White Noise
+// Batch
+
+template <typename Kernel>
+static void NoiseLoop(FN_DECIMAL frequency, const FN_DECIMAL* x, const FN_DECIMAL* y, FN_DECIMAL* out, size_t count, Kernel kernel)
+{
+	for (size_t i = 0; i < count; i++)
+		out[i] = kernel(x[i] * frequency, y[i] * frequency);
+}
+
+template <typename Kernel>
+static void NoiseLoop(FN_DECIMAL frequency, const FN_DECIMAL* x, const FN_DECIMAL* y, const FN_DECIMAL* z, FN_DECIMAL* out, size_t count, Kernel kernel)
+{
+	for (size_t i = 0; i < count; i++)
+		out[i] = kernel(x[i] * frequency, y[i] * frequency, z[i] * frequency);
+}
+
+void FastNoise::GetNoiseSet(const FN_DECIMAL* x, const FN_DECIMAL* y, FN_DECIMAL* out, size_t count) const
+{
+	switch (m_noiseType)
+	{
+	case Value:
+		return NoiseLoop(m_frequency, x, y, out, count, [this](FN_DECIMAL x, FN_DECIMAL y) { return SingleValue(0, x, y); });
+	case ValueFractal:
+		switch (m_fractalType)
+		{
+		case FBM:
+			return NoiseLoop(m_frequency, x, y, out, count, [this](FN_DECIMAL x, FN_DECIMAL y) { return SingleValueFractalFBM(x, y); });
+		case Billow:
+			return NoiseLoop(m_frequency, x, y, out, count, [this](FN_DECIMAL x, FN_DECIMAL y) { return SingleValueFractalBillow(x, y); });
+		case RigidMulti:
+			return NoiseLoop(m_frequency, x, y, out, count, [this](FN_DECIMAL x, FN_DECIMAL y) { return SingleValueFractalRigidMulti(x, y); });
+		}
+		break;
+	case Perlin:
+		return NoiseLoop(m_frequency, x, y, out, count, [this](FN_DECIMAL x, FN_DECIMAL y) { return SinglePerlin(0, x, y); });
+	case PerlinFractal:
+		switch (m_fractalType)
+		{
+		case FBM:
+			return NoiseLoop(m_frequency, x, y, out, count, [this](FN_DECIMAL x, FN_DECIMAL y) { return SinglePerlinFractalFBM(x, y); });
+		case Billow:
+			return NoiseLoop(m_frequency, x, y, out, count, [this](FN_DECIMAL x, FN_DECIMAL y) { return SinglePerlinFractalBillow(x, y); });
+		case RigidMulti:
+			return NoiseLoop(m_frequency, x, y, out, count, [this](FN_DECIMAL x, FN_DECIMAL y) { return SinglePerlinFractalRigidMulti(x, y); });
+		}
+		break;
+	case Simplex:
+		return NoiseLoop(m_frequency, x, y, out, count, [this](FN_DECIMAL x, FN_DECIMAL y) { return SingleSimplex(0, x, y); });
+	case SimplexFractal:
+		switch (m_fractalType)
+		{
+		case FBM:
+			return NoiseLoop(m_frequency, x, y, out, count, [this](FN_DECIMAL x, FN_DECIMAL y) { return SingleSimplexFractalFBM(x, y); });
+		case Billow:
+			return NoiseLoop(m_frequency, x, y, out, count, [this](FN_DECIMAL x, FN_DECIMAL y) { return SingleSimplexFractalBillow(x, y); });
+		case RigidMulti:
+			return NoiseLoop(m_frequency, x, y, out, count, [this](FN_DECIMAL x, FN_DECIMAL y) { return SingleSimplexFractalRigidMulti(x, y); });
+		}
+		break;
+	case Cellular:
+		switch (m_cellularReturnType)
+		{
+		case CellValue:
+		case NoiseLookup:
+		case Distance:
+			return NoiseLoop(m_frequency, x, y, out, count, [this](FN_DECIMAL x, FN_DECIMAL y) { return SingleCellular(x, y); });
+		default:
+			return NoiseLoop(m_frequency, x, y, out, count, [this](FN_DECIMAL x, FN_DECIMAL y) { return SingleCellular2Edge(x, y); });
+		}
+	case WhiteNoise:
+		return NoiseLoop(m_frequency, x, y, out, count, [this](FN_DECIMAL x, FN_DECIMAL y) { return GetWhiteNoise(x, y); });
+	case Cubic:
+		return NoiseLoop(m_frequency, x, y, out, count, [this](FN_DECIMAL x, FN_DECIMAL y) { return SingleCubic(0, x, y); });
+	case CubicFractal:
+		switch (m_fractalType)
+		{
+		case FBM:
+			return NoiseLoop(m_frequency, x, y, out, count, [this](FN_DECIMAL x, FN_DECIMAL y) { return SingleCubicFractalFBM(x, y); });
+		case Billow:
+			return NoiseLoop(m_frequency, x, y, out, count, [this](FN_DECIMAL x, FN_DECIMAL y) { return SingleCubicFractalBillow(x, y); });
+		case RigidMulti:
+			return NoiseLoop(m_frequency, x, y, out, count, [this](FN_DECIMAL x, FN_DECIMAL y) { return SingleCubicFractalRigidMulti(x, y); });
+		}
+		break;
+	}
+	std::fill(out, out + count, FN_DECIMAL(0));
+}
+
+void FastNoise::GetNoiseSet(const FN_DECIMAL* x, const FN_DECIMAL* y, const FN_DECIMAL* z, FN_DECIMAL* out, size_t count) const
+{
+	size_t done;
+
+	switch (m_noiseType)
+	{
+	case Value:
+		return NoiseLoop(m_frequency, x, y, z, out, count, [this](FN_DECIMAL x, FN_DECIMAL y, FN_DECIMAL z) { return SingleValue(0, x, y, z); });
+	case ValueFractal:
+		switch (m_fractalType)
+		{
+		case FBM:
+			return NoiseLoop(m_frequency, x, y, z, out, count, [this](FN_DECIMAL x, FN_DECIMAL y, FN_DECIMAL z) { return SingleValueFractalFBM(x, y, z); });
+		case Billow:
+			return NoiseLoop(m_frequency, x, y, z, out, count, [this](FN_DECIMAL x, FN_DECIMAL y, FN_DECIMAL z) { return SingleValueFractalBillow(x, y, z); });
+		case RigidMulti:
+			return NoiseLoop(m_frequency, x, y, z, out, count, [this](FN_DECIMAL x, FN_DECIMAL y, FN_DECIMAL z) { return SingleValueFractalRigidMulti(x, y, z); });
+		}
+		break;
+	case Perlin:
+		return NoiseLoop(m_frequency, x, y, z, out, count, [this](FN_DECIMAL x, FN_DECIMAL y, FN_DECIMAL z) { return SinglePerlin(0, x, y, z); });
+	case PerlinFractal:
+		switch (m_fractalType)
+		{
+		case FBM:
+			return NoiseLoop(m_frequency, x, y, z, out, count, [this](FN_DECIMAL x, FN_DECIMAL y, FN_DECIMAL z) { return SinglePerlinFractalFBM(x, y, z); });
+		case Billow:
+			return NoiseLoop(m_frequency, x, y, z, out, count, [this](FN_DECIMAL x, FN_DECIMAL y, FN_DECIMAL z) { return SinglePerlinFractalBillow(x, y, z); });
+		case RigidMulti:
+			return NoiseLoop(m_frequency, x, y, z, out, count, [this](FN_DECIMAL x, FN_DECIMAL y, FN_DECIMAL z) { return SinglePerlinFractalRigidMulti(x, y, z); });
+		}
+		break;
+	case Simplex:
+		// SSE2 takes whole groups of 4, the scalar kernel the rest
+		done = SimplexSetSSE2(x, y, z, out, count);
+		return NoiseLoop(m_frequency, x + done, y + done, z + done, out + done, count - done, [this](FN_DECIMAL x, FN_DECIMAL y, FN_DECIMAL z) { return SingleSimplex(0, x, y, z); });
+	case SimplexFractal:
+		switch (m_fractalType)
+		{
+		case FBM:
+			done = SimplexSetSSE2(x, y, z, out, count);
+			return NoiseLoop(m_frequency, x + done, y + done, z + done, out + done, count - done, [this](FN_DECIMAL x, FN_DECIMAL y, FN_DECIMAL z) { return SingleSimplexFractalFBM(x, y, z); });
+		case Billow:
+			done = SimplexSetSSE2(x, y, z, out, count);
+			return NoiseLoop(m_frequency, x + done, y + done, z + done, out + done, count - done, [this](FN_DECIMAL x, FN_DECIMAL y, FN_DECIMAL z) { return SingleSimplexFractalBillow(x, y, z); });
+		case RigidMulti:
+			done = SimplexSetSSE2(x, y, z, out, count);
+			return NoiseLoop(m_frequency, x + done, y + done, z + done, out + done, count - done, [this](FN_DECIMAL x, FN_DECIMAL y, FN_DECIMAL z) { return SingleSimplexFractalRigidMulti(x, y, z); });
+		}
+		break;
+	case Cellular:
+		switch (m_cellularReturnType)
+		{
+		case CellValue:
+		case NoiseLookup:
+		case Distance:
+			return NoiseLoop(m_frequency, x, y, z, out, count, [this](FN_DECIMAL x, FN_DECIMAL y, FN_DECIMAL z) { return SingleCellular(x, y, z); });
+		default:
+			return NoiseLoop(m_frequency, x, y, z, out, count, [this](FN_DECIMAL x, FN_DECIMAL y, FN_DECIMAL z) { return SingleCellular2Edge(x, y, z); });
+		}
+	case WhiteNoise:
+		return NoiseLoop(m_frequency, x, y, z, out, count, [this](FN_DECIMAL x, FN_DECIMAL y, FN_DECIMAL z) { return GetWhiteNoise(x, y, z); });
+	case Cubic:
+		return NoiseLoop(m_frequency, x, y, z, out, count, [this](FN_DECIMAL x, FN_DECIMAL y, FN_DECIMAL z) { return SingleCubic(0, x, y, z); });
+	case CubicFractal:
+		switch (m_fractalType)
+		{
+		case FBM:
+			return NoiseLoop(m_frequency, x, y, z, out, count, [this](FN_DECIMAL x, FN_DECIMAL y, FN_DECIMAL z) { return SingleCubicFractalFBM(x, y, z); });
+		case Billow:
+			return NoiseLoop(m_frequency, x, y, z, out, count, [this](FN_DECIMAL x, FN_DECIMAL y, FN_DECIMAL z) { return SingleCubicFractalBillow(x, y, z); });
+		case RigidMulti:
+			return NoiseLoop(m_frequency, x, y, z, out, count, [this](FN_DECIMAL x, FN_DECIMAL y, FN_DECIMAL z) { return SingleCubicFractalRigidMulti(x, y, z); });
+		}
+		break;
+	}
+	std::fill(out, out + count, FN_DECIMAL(0));
+}
+
+void FastNoise::GetNoiseSetGrid(FN_DECIMAL* out, FN_DECIMAL x, FN_DECIMAL y, int xSize, int ySize, FN_DECIMAL step) const
+{
+	std::vector<FN_DECIMAL> xs(xSize), ys(xSize);
+	for (int xi = 0; xi < xSize; xi++)
+		xs[xi] = x + xi * step;
+
+	for (int yi = 0; yi < ySize; yi++)
+	{
+		std::fill(ys.begin(), ys.end(), y + yi * step);
+		GetNoiseSet(xs.data(), ys.data(), out + (size_t)yi * xSize, xSize);
+	}
+}
+
+void FastNoise::GetNoiseSetGrid(FN_DECIMAL* out, FN_DECIMAL x, FN_DECIMAL y, FN_DECIMAL z, int xSize, int ySize, int zSize, FN_DECIMAL step) const
+{
+	std::vector<FN_DECIMAL> xs(xSize), ys(xSize), zs(xSize);
+	for (int xi = 0; xi < xSize; xi++)
+		xs[xi] = x + xi * step;
+
+	for (int zi = 0; zi < zSize; zi++)
+	{
+		std::fill(zs.begin(), zs.end(), z + zi * step);
+		for (int yi = 0; yi < ySize; yi++)
+		{
+			std::fill(ys.begin(), ys.end(), y + yi * step);
+			GetNoiseSet(xs.data(), ys.data(), zs.data(), out + ((size_t)zi * ySize + yi) * xSize, xSize);
+		}
+	}
+}
+
 FN_DECIMAL FastNoise::GetWhiteNoise(FN_DECIMAL x, FN_DECIMAL y, FN_DECIMAL z, FN_DECIMAL w) const
 {
 	return ValCoord4D(m_seed,
@@ -1170,6 +1374,188 @@ FN_DECIMAL FastNoise::SingleSimplex(unsigned char offset, FN_DECIMAL x, FN_DECIM
 	return 32 * (n0 + n1 + n2 + n3);
 }
 
+#ifdef FN_SSE2
+// 4 wide SingleSimplex, every step mirrors the scalar version's operations and their order so the results match it exactly
+
+static __m128i FastFloorSSE2(__m128 f)
+{
+	// (int)f, minus one where f < 0 (all ones mask is -1)
+	return _mm_add_epi32(_mm_cvttps_epi32(f), _mm_castps_si128(_mm_cmplt_ps(f, _mm_setzero_ps())));
+}
+
+static __m128 SimplexCornerSSE2(const unsigned char* perm, const unsigned char* perm12, unsigned char offset, __m128i i, __m128i j, __m128i k, __m128 xd, __m128 yd, __m128 zd)
+{
+	__m128 t = _mm_sub_ps(_mm_sub_ps(_mm_sub_ps(_mm_set1_ps(FN_DECIMAL(0.6)), _mm_mul_ps(xd, xd)), _mm_mul_ps(yd, yd)), _mm_mul_ps(zd, zd));
+	__m128 inside = _mm_cmpge_ps(t, _mm_setzero_ps());
+	if (_mm_movemask_ps(inside) == 0)
+		return _mm_setzero_ps();
+
+	// No gathers in SSE2, look the gradients up lane by lane
+	alignas(16) int il[4], jl[4], kl[4];
+	alignas(16) FN_DECIMAL gx[4], gy[4], gz[4];
+	_mm_store_si128((__m128i*)il, i);
+	_mm_store_si128((__m128i*)jl, j);
+	_mm_store_si128((__m128i*)kl, k);
+	for (int l = 0; l < 4; l++)
+	{
+		unsigned char lutPos = perm12[(il[l] & 0xff) + perm[(jl[l] & 0xff) + perm[(kl[l] & 0xff) + offset]]];
+		gx[l] = GRAD_X[lutPos];
+		gy[l] = GRAD_Y[lutPos];
+		gz[l] = GRAD_Z[lutPos];
+	}
+	__m128 grad = _mm_add_ps(_mm_add_ps(_mm_mul_ps(xd, _mm_load_ps(gx)), _mm_mul_ps(yd, _mm_load_ps(gy))), _mm_mul_ps(zd, _mm_load_ps(gz)));
+
+	t = _mm_mul_ps(t, t);
+	return _mm_and_ps(inside, _mm_mul_ps(_mm_mul_ps(t, t), grad));
+}
+
+static __m128 SingleSimplexSSE2(const unsigned char* perm, const unsigned char* perm12, unsigned char offset, __m128 x, __m128 y, __m128 z)
+{
+	const __m128 one = _mm_set1_ps(1);
+	const __m128 g3 = _mm_set1_ps(G3);
+
+	__m128 t = _mm_mul_ps(_mm_add_ps(_mm_add_ps(x, y), z), _mm_set1_ps(F3));
+	__m128i i = FastFloorSSE2(_mm_add_ps(x, t));
+	__m128i j = FastFloorSSE2(_mm_add_ps(y, t));
+	__m128i k = FastFloorSSE2(_mm_add_ps(z, t));
+
+	t = _mm_mul_ps(_mm_cvtepi32_ps(_mm_add_epi32(_mm_add_epi32(i, j), k)), g3);
+	__m128 x0 = _mm_sub_ps(x, _mm_sub_ps(_mm_cvtepi32_ps(i), t));
+	__m128 y0 = _mm_sub_ps(y, _mm_sub_ps(_mm_cvtepi32_ps(j), t));
+	__m128 z0 = _mm_sub_ps(z, _mm_sub_ps(_mm_cvtepi32_ps(k), t));
+
+	// The scalar if/else tree over x0 >= y0, y0 >= z0 and x0 >= z0 as masks
+	__m128 xy = _mm_cmpge_ps(x0, y0);
+	__m128 yz = _mm_cmpge_ps(y0, z0);
+	__m128 xz = _mm_cmpge_ps(x0, z0);
+	__m128 ones = _mm_castsi128_ps(_mm_set1_epi32(-1));
+
+	__m128 i1 = _mm_and_ps(xy, _mm_or_ps(yz, xz));
+	__m128 j1 = _mm_andnot_ps(xy, yz);
+	__m128 k1 = _mm_xor_ps(_mm_or_ps(i1, j1), ones);
+	__m128 i2 = _mm_or_ps(xy, _mm_and_ps(yz, xz));
+	__m128 j2 = _mm_or_ps(yz, _mm_xor_ps(xy, ones));
+	__m128 k2 = _mm_xor_ps(_mm_and_ps(i2, j2), ones);
+
+	__m128 x1 = _mm_add_ps(_mm_sub_ps(x0, _mm_and_ps(i1, one)), g3);
+	__m128 y1 = _mm_add_ps(_mm_sub_ps(y0, _mm_and_ps(j1, one)), g3);
+	__m128 z1 = _mm_add_ps(_mm_sub_ps(z0, _mm_and_ps(k1, one)), g3);
+	__m128 x2 = _mm_add_ps(_mm_sub_ps(x0, _mm_and_ps(i2, one)), _mm_set1_ps(2*G3));
+	__m128 y2 = _mm_add_ps(_mm_sub_ps(y0, _mm_and_ps(j2, one)), _mm_set1_ps(2*G3));
+	__m128 z2 = _mm_add_ps(_mm_sub_ps(z0, _mm_and_ps(k2, one)), _mm_set1_ps(2*G3));
+	__m128 x3 = _mm_add_ps(_mm_sub_ps(x0, one), _mm_set1_ps(3*G3));
+	__m128 y3 = _mm_add_ps(_mm_sub_ps(y0, one), _mm_set1_ps(3*G3));
+	__m128 z3 = _mm_add_ps(_mm_sub_ps(z0, one), _mm_set1_ps(3*G3));
+
+	// Masks are -1 where set, so subtracting them adds one
+	__m128 n0 = SimplexCornerSSE2(perm, perm12, offset, i, j, k, x0, y0, z0);
+	__m128 n1 = SimplexCornerSSE2(perm, perm12, offset,
+		_mm_sub_epi32(i, _mm_castps_si128(i1)), _mm_sub_epi32(j, _mm_castps_si128(j1)), _mm_sub_epi32(k, _mm_castps_si128(k1)), x1, y1, z1);
+	__m128 n2 = SimplexCornerSSE2(perm, perm12, offset,
+		_mm_sub_epi32(i, _mm_castps_si128(i2)), _mm_sub_epi32(j, _mm_castps_si128(j2)), _mm_sub_epi32(k, _mm_castps_si128(k2)), x2, y2, z2);
+	__m128i inc = _mm_set1_epi32(1);
+	__m128 n3 = SimplexCornerSSE2(perm, perm12, offset, _mm_add_epi32(i, inc), _mm_add_epi32(j, inc), _mm_add_epi32(k, inc), x3, y3, z3);
+
+	return _mm_mul_ps(_mm_set1_ps(32), _mm_add_ps(_mm_add_ps(_mm_add_ps(n0, n1), n2), n3));
+}
+
+static __m128 AbsSSE2(__m128 f)
+{
+	return _mm_andnot_ps(_mm_set1_ps(-0.0f), f);
+}
+
+template <typename Kernel>
+static size_t SimplexLoopSSE2(FN_DECIMAL frequency, const FN_DECIMAL* x, const FN_DECIMAL* y, const FN_DECIMAL* z, FN_DECIMAL* out, size_t count, Kernel kernel)
+{
+	__m128 f = _mm_set1_ps(frequency);
+	size_t i = 0;
+	for (; i + 4 <= count; i += 4)
+		_mm_storeu_ps(out + i, kernel(_mm_mul_ps(_mm_loadu_ps(x + i), f), _mm_mul_ps(_mm_loadu_ps(y + i), f), _mm_mul_ps(_mm_loadu_ps(z + i), f)));
+	return i;
+}
+#endif
+
+size_t FastNoise::SimplexSetSSE2(const FN_DECIMAL* x, const FN_DECIMAL* y, const FN_DECIMAL* z, FN_DECIMAL* out, size_t count) const
+{
+#ifdef FN_SSE2
+	if (m_noiseType == Simplex)
+		return SimplexLoopSSE2(m_frequency, x, y, z, out, count, [this](__m128 x, __m128 y, __m128 z)
+		{
+			return SingleSimplexSSE2(m_perm, m_perm12, 0, x, y, z);
+		});
+
+	switch (m_fractalType)
+	{
+	case FBM:
+		return SimplexLoopSSE2(m_frequency, x, y, z, out, count, [this](__m128 x, __m128 y, __m128 z)
+		{
+			__m128 lacunarity = _mm_set1_ps(m_lacunarity);
+			__m128 sum = SingleSimplexSSE2(m_perm, m_perm12, m_perm[0], x, y, z);
+			FN_DECIMAL amp = 1;
+			int i = 0;
+
+			while (++i < m_octaves)
+			{
+				x = _mm_mul_ps(x, lacunarity);
+				y = _mm_mul_ps(y, lacunarity);
+				z = _mm_mul_ps(z, lacunarity);
+
+				amp *= m_gain;
+				sum = _mm_add_ps(sum, _mm_mul_ps(SingleSimplexSSE2(m_perm, m_perm12, m_perm[i], x, y, z), _mm_set1_ps(amp)));
+			}
+
+			return _mm_mul_ps(sum, _mm_set1_ps(m_fractalBounding));
+		});
+	case Billow:
+		return SimplexLoopSSE2(m_frequency, x, y, z, out, count, [this](__m128 x, __m128 y, __m128 z)
+		{
+			__m128 lacunarity = _mm_set1_ps(m_lacunarity);
+			__m128 two = _mm_set1_ps(2);
+			__m128 one = _mm_set1_ps(1);
+			__m128 sum = _mm_sub_ps(_mm_mul_ps(AbsSSE2(SingleSimplexSSE2(m_perm, m_perm12, m_perm[0], x, y, z)), two), one);
+			FN_DECIMAL amp = 1;
+			int i = 0;
+
+			while (++i < m_octaves)
+			{
+				x = _mm_mul_ps(x, lacunarity);
+				y = _mm_mul_ps(y, lacunarity);
+				z = _mm_mul_ps(z, lacunarity);
+
+				amp *= m_gain;
+				__m128 n = _mm_sub_ps(_mm_mul_ps(AbsSSE2(SingleSimplexSSE2(m_perm, m_perm12, m_perm[i], x, y, z)), two), one);
+				sum = _mm_add_ps(sum, _mm_mul_ps(n, _mm_set1_ps(amp)));
+			}
+
+			return _mm_mul_ps(sum, _mm_set1_ps(m_fractalBounding));
+		});
+	case RigidMulti:
+		return SimplexLoopSSE2(m_frequency, x, y, z, out, count, [this](__m128 x, __m128 y, __m128 z)
+		{
+			__m128 lacunarity = _mm_set1_ps(m_lacunarity);
+			__m128 one = _mm_set1_ps(1);
+			__m128 sum = _mm_sub_ps(one, AbsSSE2(SingleSimplexSSE2(m_perm, m_perm12, m_perm[0], x, y, z)));
+			FN_DECIMAL amp = 1;
+			int i = 0;
+
+			while (++i < m_octaves)
+			{
+				x = _mm_mul_ps(x, lacunarity);
+				y = _mm_mul_ps(y, lacunarity);
+				z = _mm_mul_ps(z, lacunarity);
+
+				amp *= m_gain;
+				__m128 n = _mm_sub_ps(one, AbsSSE2(SingleSimplexSSE2(m_perm, m_perm12, m_perm[i], x, y, z)));
+				sum = _mm_sub_ps(sum, _mm_mul_ps(n, _mm_set1_ps(amp)));
+			}
+
+			return sum;
+		});
+	}
+#endif
+	return 0;
+}
+
 FN_DECIMAL FastNoise::GetSimplexFractal(FN_DECIMAL x, FN_DECIMAL y) const
 {
 	x *= m_frequency;
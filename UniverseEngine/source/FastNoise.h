@@ -31,6 +31,8 @@
 #ifndef FASTNOISE_H
 #define FASTNOISE_H
 
+#include <stddef.h>
+
 // Uncomment the line below to use doubles throughout FastNoise instead of floats
 //#define FN_USE_DOUBLES
 
@@ -213,6 +215,17 @@ public:
 	FN_DECIMAL GetWhiteNoise(FN_DECIMAL x, FN_DECIMAL y, FN_DECIMAL z, FN_DECIMAL w) const;
 	FN_DECIMAL GetWhiteNoiseInt(int x, int y, int z, int w) const;
 
+	//Batch
+	// Sets out[i] to GetNoise(x[i], y[i]{, z[i]}) for count points, bit for bit the same values
+	// The noise and fractal type are only looked at once per call, 3D Simplex{Fractal} runs 4 points at a time using SSE2
+	void GetNoiseSet(const FN_DECIMAL* x, const FN_DECIMAL* y, FN_DECIMAL* out, size_t count) const;
+	void GetNoiseSet(const FN_DECIMAL* x, const FN_DECIMAL* y, const FN_DECIMAL* z, FN_DECIMAL* out, size_t count) const;
+
+	// Sets out[yi * xSize + xi] to GetNoise(x + xi * step, y + yi * step)
+	void GetNoiseSetGrid(FN_DECIMAL* out, FN_DECIMAL x, FN_DECIMAL y, int xSize, int ySize, FN_DECIMAL step) const;
+	// Sets out[(zi * ySize + yi) * xSize + xi] to GetNoise(x + xi * step, y + yi * step, z + zi * step)
+	void GetNoiseSetGrid(FN_DECIMAL* out, FN_DECIMAL x, FN_DECIMAL y, FN_DECIMAL z, int xSize, int ySize, int zSize, FN_DECIMAL step) const;
+
 private:
 	unsigned char m_perm[512];
 	unsigned char m_perm12[512];
@@ -295,6 +308,10 @@ private:
 	//4D
 	FN_DECIMAL SingleSimplex(unsigned char offset, FN_DECIMAL x, FN_DECIMAL y, FN_DECIMAL z, FN_DECIMAL w) const;
 
+	//Batch
+	// Runs the leading multiple of 4 points of a 3D Simplex{Fractal} batch with SSE2, returns how many were done (0 without SSE2)
+	size_t SimplexSetSSE2(const FN_DECIMAL* x, const FN_DECIMAL* y, const FN_DECIMAL* z, FN_DECIMAL* out, size_t count) const;
+
 	inline unsigned char Index2D_12(unsigned char offset, int x, int y) const;
 	inline unsigned char Index3D_12(unsigned char offset, int x, int y, int z) const;
 	inline unsigned char Index4D_32(unsigned char offset, int x, int y, int z, int w) const;
@@ -1,5 +1,11 @@
 #include "Frustum.hpp"
 
+// SSE2 is always there on x64, 32 bit builds need /arch:SSE2 or higher
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define FRUSTUM_SSE2
+#include <emmintrin.h>
+#endif
+
 using namespace uni::components;
 
 Frustum::Frustum() {
@@ -73,7 +79,7 @@ void Frustum::Update() {
 	//m_Corners.fd = fCenter - farHH + farHW;
 	m_Corners.Transform(m_CullInverse);
 
-	m_PositionObject = m_CullInverse * glm::vec4(m_Position, 0);
+	m_PositionObject = m_CullInverse * glm::vec4(m_Position, 1);
 	m_RadInvFOV = 1.f / glm::radians(m_FOV);
 
 	//construct planes
@@ -85,6 +91,55 @@ void Frustum::Update() {
 	m_Planes.emplace_back(m_Corners.nb, m_Corners.fb, m_Corners.nd);//Right
 	m_Planes.emplace_back(m_Corners.fa, m_Corners.fb, m_Corners.na);//Top
 	m_Planes.emplace_back(m_Corners.nc, m_Corners.nd, m_Corners.fc);//Bottom
+
+	for(size_t i = 0; i < 8; i++) {
+		if(i < m_Planes.size()) {
+			m_PlaneX[i] = m_Planes[i].n.x;
+			m_PlaneY[i] = m_Planes[i].n.y;
+			m_PlaneZ[i] = m_Planes[i].n.z;
+			m_PlaneW[i] = -glm::dot(m_Planes[i].n, m_Planes[i].d);
+		} else {
+			m_PlaneX[i] = m_PlaneY[i] = m_PlaneZ[i] = 0.f;
+			m_PlaneW[i] = 1.f;
+		}
+	}
+}
+
+void Frustum::SetToViewProjection(const glm::mat4 &viewProjection) {
+	m_CullWorld = m_CullInverse = glm::mat4(1.f);
+
+	//rows of the matrix, clip space is -w <= x, y <= w and 0 <= z <= w
+	glm::vec4 rows[4];
+	for(int i = 0; i < 4; i++)
+		rows[i] = glm::vec4(viewProjection[0][i], viewProjection[1][i], viewProjection[2][i], viewProjection[3][i]);
+	glm::vec4 planes[6] = {
+		rows[3] - rows[2],//Near, z <= w with the reversed depth
+		rows[2],//Far
+		rows[3] + rows[0],//Left
+		rows[3] - rows[0],//Right
+		rows[3] - rows[1],//Top
+		rows[3] + rows[1],//Bottom
+	};
+
+	m_Planes.clear();
+	for(auto &plane : planes) {
+		float length = glm::length(glm::vec3(plane));
+		if(length < 1e-6f) continue;
+		plane /= length;
+		m_Planes.emplace_back(glm::vec3(plane), -glm::vec3(plane) * plane.w);
+	}
+
+	for(size_t i = 0; i < 8; i++) {
+		if(i < m_Planes.size()) {
+			m_PlaneX[i] = m_Planes[i].n.x;
+			m_PlaneY[i] = m_Planes[i].n.y;
+			m_PlaneZ[i] = m_Planes[i].n.z;
+			m_PlaneW[i] = -glm::dot(m_Planes[i].n, m_Planes[i].d);
+		} else {
+			m_PlaneX[i] = m_PlaneY[i] = m_PlaneZ[i] = 0.f;
+			m_PlaneW[i] = 1.f;
+		}
+	}
 }
 
 VolumeCheck Frustum::ContainsPoint(const glm::vec3 &point) const {
@@ -102,41 +157,84 @@ VolumeCheck Frustum::ContainsSphere(const Sphere &sphere) const {
 	}
 	return ret;
 }
+void Frustum::ContainsSpheres(const float *x, const float *y, const float *z, const float *radius, uint32_t count, uint8_t *inside) const {
+	uint32_t i = 0;
+#ifdef FRUSTUM_SSE2
+	//four spheres against one plane per step
+	const __m128 zero = _mm_setzero_ps();
+	for(; i + 4 <= count; i += 4) {
+		__m128 px = _mm_loadu_ps(x + i);
+		__m128 py = _mm_loadu_ps(y + i);
+		__m128 pz = _mm_loadu_ps(z + i);
+		__m128 negRadius = _mm_sub_ps(zero, _mm_loadu_ps(radius + i));
+		__m128 outside = zero;
+		for(int plane = 0; plane < 8; plane++) {
+			__m128 dist = _mm_add_ps(_mm_add_ps(_mm_mul_ps(_mm_set1_ps(m_PlaneX[plane]), px), _mm_mul_ps(_mm_set1_ps(m_PlaneY[plane]), py)),
+				_mm_add_ps(_mm_mul_ps(_mm_set1_ps(m_PlaneZ[plane]), pz), _mm_set1_ps(m_PlaneW[plane])));
+			outside = _mm_or_ps(outside, _mm_cmplt_ps(dist, negRadius));
+		}
+		int mask = _mm_movemask_ps(outside);
+		for(int k = 0; k < 4; k++)
+			inside[i + k] = (mask >> k) & 1 ? 0 : 1;
+	}
+#endif
+	for(; i < count; i++) {
+		uint8_t in = 1;
+		for(int plane = 0; plane < 8; plane++) {
+			float dist = m_PlaneX[plane] * x[i] + m_PlaneY[plane] * y[i] + m_PlaneZ[plane] * z[i] + m_PlaneW[plane];
+			if(dist < -radius[i]) in = 0;
+		}
+		inside[i] = in;
+	}
+}
+
+VolumeCheck Frustum::ContainsPoints(const glm::vec3 *points, int count) const {
+	int allOutside = 0;
+	int anyOutside = 0;
+#ifdef FRUSTUM_SSE2
+	//four planes against one point per step
+	const __m128 zero = _mm_setzero_ps();
+	for(int group = 0; group < 8; group += 4) {
+		__m128 nx = _mm_loadu_ps(m_PlaneX + group);
+		__m128 ny = _mm_loadu_ps(m_PlaneY + group);
+		__m128 nz = _mm_loadu_ps(m_PlaneZ + group);
+		__m128 nw = _mm_loadu_ps(m_PlaneW + group);
+		__m128 all = _mm_castsi128_ps(_mm_set1_epi32(-1));
+		__m128 any = zero;
+		for(int i = 0; i < count; i++) {
+			__m128 dist = _mm_add_ps(_mm_add_ps(_mm_mul_ps(nx, _mm_set1_ps(points[i].x)), _mm_mul_ps(ny, _mm_set1_ps(points[i].y))),
+				_mm_add_ps(_mm_mul_ps(nz, _mm_set1_ps(points[i].z)), nw));
+			__m128 outside = _mm_cmplt_ps(dist, zero);
+			all = _mm_and_ps(all, outside);
+			any = _mm_or_ps(any, outside);
+		}
+		allOutside |= _mm_movemask_ps(all);
+		anyOutside |= _mm_movemask_ps(any);
+	}
+#else
+	for(int plane = 0; plane < 8; plane++) {
+		int rejects = 0;
+		for(int i = 0; i < count; i++) {
+			float dist = m_PlaneX[plane] * points[i].x + m_PlaneY[plane] * points[i].y + m_PlaneZ[plane] * points[i].z + m_PlaneW[plane];
+			if(dist < 0) rejects++;
+		}
+		if(rejects == count) allOutside = 1;
+		if(rejects > 0) anyOutside = 1;
+	}
+#endif
+	if(allOutside) return VolumeCheck::OUTSIDE;
+	if(anyOutside) return VolumeCheck::INTERSECT;
+	return VolumeCheck::CONTAINS;
+}
 //this method will treat triangles as intersecting even though they may be outside
 //but it is faster then performing a proper intersection test with every plane
 //and it does not reject triangles that are inside but with all corners outside
-VolumeCheck Frustum::ContainsTriangle(glm::vec3 &a, glm::vec3 &b, glm::vec3 &c) {
-	VolumeCheck ret = VolumeCheck::CONTAINS;
-	for(auto plane : m_Planes) {
-		char rejects = 0;
-		if(glm::dot(plane.n, a - plane.d) < 0)rejects++;
-		if(glm::dot(plane.n, b - plane.d) < 0)rejects++;
-		if(glm::dot(plane.n, c - plane.d) < 0)rejects++;
-		// if all three are outside a plane the triangle is outside the frustrum
-		if(rejects >= 3)return VolumeCheck::OUTSIDE;
-		// if at least one is outside the triangle intersects at least one plane
-		else if(rejects > 0)ret = VolumeCheck::INTERSECT;
-	}
-	return ret;
+VolumeCheck Frustum::ContainsTriangle(const glm::vec3 &a, const glm::vec3 &b, const glm::vec3 &c) const {
+	glm::vec3 points[3] = { a, b, c };
+	return ContainsPoints(points, 3);
 }
 //same as above but with a volume generated above the triangle
-VolumeCheck Frustum::ContainsTriVolume(glm::vec3 &a, glm::vec3 &b, glm::vec3 &c, float height) {
-	VolumeCheck ret = VolumeCheck::CONTAINS;
-	for(auto plane : m_Planes) {
-		char rejects = 0;
-		if(glm::dot(plane.n, a - plane.d) < 0)rejects++;
-		if(glm::dot(plane.n, b - plane.d) < 0)rejects++;
-		if(glm::dot(plane.n, c - plane.d) < 0)rejects++;
-		// if all three are outside a plane the triangle is outside the frustrum
-		if(rejects >= 3) {
-			if(glm::dot(plane.n, (a*height) - plane.d) < 0)rejects++;
-			if(glm::dot(plane.n, (b*height) - plane.d) < 0)rejects++;
-			if(glm::dot(plane.n, (c*height) - plane.d) < 0)rejects++;
-			if(rejects >= 6)return VolumeCheck::OUTSIDE;
-			else ret = VolumeCheck::INTERSECT;
-		}
-		// if at least one is outside the triangle intersects at least one plane
-		else if(rejects > 0)ret = VolumeCheck::INTERSECT;
-	}
-	return ret;
-}
\ No newline at end of file
+VolumeCheck Frustum::ContainsTriVolume(const glm::vec3 &a, const glm::vec3 &b, const glm::vec3 &c, float height) const {
+	glm::vec3 points[6] = { a, b, c, a * height, b * height, c * height };
+	return ContainsPoints(points, 6);
+}
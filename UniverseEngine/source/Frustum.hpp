@@ -36,15 +36,15 @@ struct FrustumCorners {
 
 	void Transform(glm::mat4 space) {
 		//move corners of the near plane
-		na = (space*glm::vec4(na, 0));
-		nb = (space*glm::vec4(nb, 0));
-		nc = (space*glm::vec4(nc, 0));
-		nd = (space*glm::vec4(nd, 0));
+		na = (space*glm::vec4(na, 1));
+		nb = (space*glm::vec4(nb, 1));
+		nc = (space*glm::vec4(nc, 1));
+		nd = (space*glm::vec4(nd, 1));
 		//move corners of the far plane
-		fa = (space*glm::vec4(fa, 0));
-		fb = (space*glm::vec4(fb, 0));
-		fc = (space*glm::vec4(fc, 0));
-		fd = (space*glm::vec4(fd, 0));
+		fa = (space*glm::vec4(fa, 1));
+		fb = (space*glm::vec4(fb, 1));
+		fc = (space*glm::vec4(fc, 1));
+		fd = (space*glm::vec4(fd, 1));
 	}
 
 };
@@ -60,10 +60,16 @@ public:
 	void SetCullTransform(glm::mat4 objectWorld);
 
 	void SetToCamera(ECS::ComponentHandle<CameraComponent> camera);
+	//planes straight from a projection * view matrix instead of SetToCamera and Update, no corners or cull transform
+	//planes that come out degenerate (the far plane of an infinite projection) never reject anything
+	void SetToViewProjection(const glm::mat4 &viewProjection);
 	VolumeCheck ContainsPoint(const glm::vec3 &point) const;
 	VolumeCheck ContainsSphere(const Sphere &sphere) const;
-	VolumeCheck ContainsTriangle(glm::vec3 &a, glm::vec3 &b, glm::vec3 &c);
-	VolumeCheck ContainsTriVolume(glm::vec3 &a, glm::vec3 &b, glm::vec3 &c, float height);
+	//inside[i] = 0 for spheres entirely behind a plane, 1 otherwise, for spheres packed as separate x, y, z and radius arrays
+	void ContainsSpheres(const float *x, const float *y, const float *z, const float *radius, uint32_t count, uint8_t *inside) const;
+	VolumeCheck ContainsTriangle(const glm::vec3 &a, const glm::vec3 &b, const glm::vec3 &c) const;
+	//the prism between triangle abc and the same triangle scaled from the origin by height, CONTAINS only if all of it is inside
+	VolumeCheck ContainsTriVolume(const glm::vec3 &a, const glm::vec3 &b, const glm::vec3 &c, float height) const;
 
 	const glm::vec3 &GetPositionOS() { return m_PositionObject; }
 	const float GetFOV() { return m_FOV; }
@@ -72,11 +78,16 @@ public:
 	FrustumCorners GetCorners() { return m_Corners; }
 
 private:
+	//OUTSIDE if every point is behind one plane, INTERSECT if any point is behind any plane
+	VolumeCheck ContainsPoints(const glm::vec3 *points, int count) const;
+
 	//transform to the culled objects object space and back to world space
 	glm::mat4 m_CullWorld, m_CullInverse;
 
 	//stuff in the culled objects object space
 	std::vector<Plane> m_Planes;
+	//the planes again as n.x, n.y, n.z and -dot(n, d) four at a time, padded with planes nothing is outside of
+	float m_PlaneX[8], m_PlaneY[8], m_PlaneZ[8], m_PlaneW[8];
 	FrustumCorners m_Corners;
 	glm::vec3 m_PositionObject;
 
@@ -129,7 +129,7 @@ std::shared_ptr<Asset> ModelImporter::Import(std::shared_ptr<Asset> asset, bool
     });
 
   model->loadFromFile(asset->m_sourceFile, vertexLayout,
-    &mci, engine->vulkanDevice, engine->GetQueue(), materials,
+    &mci, engine->vulkanDevice, &engine->GetUploadManager(), materials,
     testFlags);
 
   modelAsset->m_model = model;
@@ -60,6 +60,8 @@ void Material::SetupMaterial(
   4: Specular Map
   5: Emissive Map
   6: AO Map
+  7: Material properties
+  8: Dynamic uniform block, only if SetDynamicUniform was called
  */
 void Material::SetupDescriptorSetLayout(
   std::shared_ptr<uni::render::SceneRenderer> renderer) {
@@ -99,6 +101,12 @@ void Material::SetupDescriptorSetLayout(
         VK_SHADER_STAGE_VERTEX_BIT | VK_SHADER_STAGE_FRAGMENT_BIT, 7),
   };
 
+  // Binding 8 : per frame uniforms, bound with GetDynamicUniformOffset()
+  if (m_HasDynamicUniform)
+    m_setLayoutBindings.push_back(vks::initializers::descriptorSetLayoutBinding(
+        VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC,
+        VK_SHADER_STAGE_ALL_GRAPHICS, 8));
+
   auto device = UniEngine::GetInstance()->GetDevice();
 
   VkDescriptorSetLayoutCreateInfo descriptorLayout =
@@ -231,6 +239,11 @@ void Material::SetupDescriptorSets(
       &m_MaterialPropertyBuffer.descriptor)
   };
 
+  // Binding 8 : dynamic uniform block
+  if (m_HasDynamicUniform)
+    m_writeDescriptorSets.push_back(vks::initializers::writeDescriptorSet(
+        m_descriptorSet, VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC, 8,
+        &m_DynamicUniform));
 
   vkUpdateDescriptorSets(device,
     static_cast<uint32_t>(m_writeDescriptorSets.size()),
@@ -238,7 +251,7 @@ void Material::SetupDescriptorSets(
 }
 
 void Material::AddToCommandBuffer(
-  VkCommandBuffer & cmdBuffer,
+  VkCommandBuffer & cmdBuffer, uint32_t image,
   ECS::ComponentHandle<ModelComponent> model) {
   // std::cout << "Calling add to command buffer for model material." <<
   // std::endl;
@@ -258,12 +271,21 @@ void Material::AddToCommandBuffer(
     0, renderer->GetPushConstantSize(),
     &renderer->GetPushConstants());
 
-  uint32_t dynamicOffset = model->GetSceneObject()->GetRenderIndex() *
-    static_cast<uint32_t>(dynamicAlignment);
+  // the renderer's three with the per object offset, then the material's own
+  // if it has one
+  uint32_t dynamicOffsets[4];
+  renderer->GetGlobalOffsets(image,
+    model->GetSceneObject()->GetRenderIndex() *
+      static_cast<uint32_t>(dynamicAlignment),
+    dynamicOffsets);
+  dynamicOffsets[3] =
+    UniEngine::GetInstance()->GetUniformRing().frameOffset(image) +
+    m_DynamicUniformOffset;
 
   vkCmdBindDescriptorSets(
     cmdBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, m_pipelineLayout, 0,
-    static_cast<uint32_t>(dSets.size()), dSets.data(), 1, &dynamicOffset);
+    static_cast<uint32_t>(dSets.size()), dSets.data(),
+    m_HasDynamicUniform ? 4 : 3, dynamicOffsets);
   /*auto matIndices =
       model->m_Model->GetSubmeshIDsByMaterialID(
           model->GetMaterialIndex(m_Name));*/
@@ -52,10 +52,23 @@ namespace uni
       virtual void LoadTexture(std::string name, std::string texturePath);
       //virtual void AddToCommandBuffer(VkCommandBuffer& cmdBuffer);
 
-      virtual void AddToCommandBuffer(VkCommandBuffer& cmdBuffer,
+      /** @brief Draw a model with this material into the command buffer of a swapchain image */
+      virtual void AddToCommandBuffer(VkCommandBuffer& cmdBuffer, uint32_t image,
         ECS::ComponentHandle<uni::components::ModelComponent> model);
       VkDescriptorSet* GetDescriptorSet() { return &m_descriptorSet; }
 
+      /** @brief Add a UNIFORM_BUFFER_DYNAMIC at binding 8 of the material's set, e.g. from the engine's uniform ring. Call before SetupMaterial */
+      void SetDynamicUniform(const VkDescriptorBufferInfo& descriptor) {
+        m_DynamicUniform = descriptor;
+        m_HasDynamicUniform = true;
+      }
+      /** @brief Offset of binding 8 within a uniform ring slice, the slice of each image is added when recording */
+      void SetDynamicUniformOffset(uint32_t offset) { m_DynamicUniformOffset = offset; }
+      bool HasDynamicUniform() const { return m_HasDynamicUniform; }
+      uint32_t GetDynamicUniformOffset() const { return m_DynamicUniformOffset; }
+      VkPipeline GetPipeline() { return m_pipeline; }
+      VkPipelineLayout GetPipelineLayout() { return m_pipelineLayout; }
+
       std::shared_ptr<uni::render::SceneRenderer> GetSceneRenderer();
 
       std::string GetName() { return m_Name; }
@@ -146,6 +159,10 @@ namespace uni
       std::vector<VkWriteDescriptorSet> m_writeDescriptorSets;
       VkDescriptorPool m_descriptorPool = nullptr;
 
+      VkDescriptorBufferInfo m_DynamicUniform{};
+      bool m_HasDynamicUniform = false;
+      uint32_t m_DynamicUniformOffset = 0;
+
       bool m_setupPerformed = false;
     };
   }
@@ -27,6 +27,7 @@
 
 #include "vks/VulkanBuffer.hpp"
 #include "vks/VulkanDevice.hpp"
+#include "vks/VulkanUploadManager.hpp"
 
 #include "Material.h"
 
@@ -156,15 +157,14 @@ struct Model {
    * @param layout Vertex layout components (position, normals, tangents, etc.)
    * @param createInfo MeshCreateInfo structure for load time settings like
    * scale, center, etc.
-   * @param copyQueue Queue used for the memory staging copy commands (must
-   * support transfer)
+   * @param uploads Upload manager the vertex and index data is staged through
    * @param (Optional) flags ASSIMP model loading flags
    */
   bool loadFromFile(const std::string& filename,
                     uni::VertexLayout layout,
                     uni::ModelCreateInfo* createInfo,
                     vks::VulkanDevice* device,
-                    VkQueue copyQueue,
+                    vks::UploadManager* uploads,
                     std::vector<std::string>& materialIDs,
                     const int flags = defaultFlags) {
     this->device = device->logicalDevice;
@@ -352,24 +352,6 @@ struct Model {
         uint32_t iBufferSize =
             static_cast<uint32_t>(indexBuffer.size()) * sizeof(uint32_t);
 
-        // Use staging buffer to move vertex and index buffer to device local
-        // memory Create staging buffers
-        vks::Buffer vertexStaging, indexStaging;
-
-        // Vertex buffer
-        VK_CHECK_RESULT(device->createBuffer(
-            VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
-            VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT |
-                VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
-            &vertexStaging, vBufferSize, vertexBuffer.data()));
-
-        // Index buffer
-        VK_CHECK_RESULT(device->createBuffer(
-            VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
-            VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT |
-                VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
-            &indexStaging, iBufferSize, indexBuffer.data()));
-
         m_vertices.emplace(i, vks::Buffer());
         m_indices.emplace(i, vks::Buffer());
 
@@ -385,29 +367,14 @@ struct Model {
             VK_BUFFER_USAGE_INDEX_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT,
             VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, &m_indices[i], iBufferSize));
 
-        // Copy from staging buffers
-        VkCommandBuffer copyCmd =
-            device->createCommandBuffer(VK_COMMAND_BUFFER_LEVEL_PRIMARY, true);
-
-        VkBufferCopy copyRegion{};
-
-        copyRegion.size = m_vertices[i].size;
-        vkCmdCopyBuffer(copyCmd, vertexStaging.buffer, m_vertices[i].buffer, 1,
-                        &copyRegion);
-
-        copyRegion.size = m_indices[i].size;
-        vkCmdCopyBuffer(copyCmd, indexStaging.buffer, m_indices[i].buffer, 1,
-                        &copyRegion);
-
-        device->flushCommandBuffer(copyCmd, copyQueue);
-
-        // Destroy staging resources
-        vkDestroyBuffer(device->logicalDevice, vertexStaging.buffer, nullptr);
-        vkFreeMemory(device->logicalDevice, vertexStaging.memory, nullptr);
-        vkDestroyBuffer(device->logicalDevice, indexStaging.buffer, nullptr);
-        vkFreeMemory(device->logicalDevice, indexStaging.memory, nullptr);
+        // Staged for a copy to device local memory, submitted once every
+        // part is recorded and never waited on here
+        uploads->copy(vertexBuffer.data(), vBufferSize, m_vertices[i].buffer);
+        uploads->copy(indexBuffer.data(), iBufferSize, m_indices[i].buffer);
       }
 
+      uploads->submit();
+
       return true;
     } else {
       printf("Error parsing '%s': '%s'\n", filename.c_str(),
@@ -428,19 +395,18 @@ struct Model {
    * @param filename File to load (must be a model format supported by ASSIMP)
    * @param layout Vertex layout components (position, normals, tangents, etc.)
    * @param scale Load time scene scale
-   * @param copyQueue Queue used for the memory staging copy commands (must
-   * support transfer)
+   * @param uploads Upload manager the vertex and index data is staged through
    * @param (Optional) flags ASSIMP model loading flags
    */
   bool loadFromFile(const std::string& filename,
                     uni::VertexLayout layout,
                     float scale,
                     vks::VulkanDevice* device,
-                    VkQueue copyQueue,
+                    vks::UploadManager* uploads,
                     std::vector<std::string>& materialIDs,
                     const int flags = defaultFlags) {
     uni::ModelCreateInfo modelCreateInfo(scale, 1.0f, 0.0f);
-    return loadFromFile(filename, layout, &modelCreateInfo, device, copyQueue,
+    return loadFromFile(filename, layout, &modelCreateInfo, device, uploads,
                         materialIDs, flags);
   }
 
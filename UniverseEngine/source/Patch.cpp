@@ -4,7 +4,7 @@
 // #include "../Components/CameraComponent.hpp"
 #include "UniEngine.h"
 #include "UniBody.h"
-#include "UniFrustum.hpp"
+#include "Frustum.hpp"
 #include "Triangulator.hpp"
 #include "vks/VulkanTools.h"
 
@@ -289,6 +289,44 @@ void Patch::BindInstances(std::vector<PatchInstance> &instances) {
 
 }
 
+void Patch::UpdateInstances(std::vector<PatchInstance> &instances, std::vector<uint32_t> &dirtySlots) {
+	m_NumInstances = (uint32_t)instances.size();
+
+	if(m_NumInstances == 0) {
+		return;
+	}
+
+	auto device = UniEngine::GetInstance().vulkanDevice;
+	auto &uploads = UniEngine::GetInstance().GetUploadManager();
+	VkDeviceSize neededSize = m_NumInstances * sizeof(PatchInstance);
+
+	if(neededSize > m_instanceBuffer.size) {
+		// don't free anything a pending upload still writes to
+		uploads.wait();
+		m_instanceBuffer.destroy();
+
+		// Grow with room to spare so growing is rare, then everything goes up
+		VK_CHECK_RESULT(device->createBuffer(
+			VK_BUFFER_USAGE_VERTEX_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT,
+			VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT,
+			&m_instanceBuffer,
+			neededSize * 2));
+
+		uploads.copy(instances.data(), neededSize, m_instanceBuffer.buffer);
+	} else {
+		// Runs of neighbouring slots go up as one copy
+		for(size_t i = 0; i < dirtySlots.size();) {
+			uint32_t first = dirtySlots[i];
+			uint32_t last = first;
+			while(++i < dirtySlots.size() && dirtySlots[i] == last + 1)
+				last++;
+			uploads.copy(&instances[first], (last - first + 1) * sizeof(PatchInstance), m_instanceBuffer.buffer, first * sizeof(PatchInstance));
+		}
+	}
+
+	uploads.submit();
+}
+
 void Patch::UploadDistanceLUT(std::vector<float> &distances) {
 	for(size_t i = 0; i < distances.size(); i++) {
 		uniformBufferData.distanceLut[i*4] = distances[i]; // dumb uniform float array packing!
@@ -72,6 +72,8 @@ public:
 	void Init();
 	void GenerateGeometry(uint16_t levels);
 	void BindInstances(std::vector<PatchInstance> &instances);
+	//Uploads only the instances at dirtySlots (sorted), everything when the buffer has to grow
+	void UpdateInstances(std::vector<PatchInstance> &instances, std::vector<uint32_t> &dirtySlots);
 	void UploadDistanceLUT(std::vector<float> &distances);
 	void Draw();
 
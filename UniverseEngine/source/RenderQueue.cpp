@@ -0,0 +1,249 @@
+#include "RenderQueue.h"
+#include <algorithm>
+#include <tuple>
+#include "UniEngine.h"
+#include "Material.h"
+#include "ModelMesh.h"
+#include "SceneObject.h"
+
+using namespace uni::render;
+
+void RenderQueue::Clear() {
+  m_Items.clear();
+  m_Materials.clear();
+  m_Models.clear();
+  m_Objects.clear();
+}
+
+void RenderQueue::Add(std::shared_ptr<uni::materials::Material> material,
+                      std::shared_ptr<uni::Model> model, uint32_t mesh,
+                      std::shared_ptr<uni::scene::SceneObject> object) {
+  // A model's submeshes come in one after another, only keep each owner once
+  // per run
+  if (m_Materials.empty() || m_Materials.back() != material)
+    m_Materials.push_back(material);
+  if (m_Models.empty() || m_Models.back() != model)
+    m_Models.push_back(model);
+  if (m_Objects.empty() || m_Objects.back() != object)
+    m_Objects.push_back(object);
+
+  m_Items.push_back({material->GetPipeline(), material.get(), model.get(), mesh,
+                     static_cast<uint32_t>(m_Objects.size() - 1)});
+}
+
+void RenderQueue::Build() {
+  std::sort(m_Items.begin(), m_Items.end(), [](const Item& a, const Item& b) {
+    return std::tie(a.pipeline, a.material, a.model, a.mesh, a.object) <
+           std::tie(b.pipeline, b.material, b.model, b.mesh, b.object);
+  });
+
+  m_Batches.clear();
+  m_Instances.clear();
+  m_InstanceModels.clear();
+  for (auto& item : m_Items) {
+    bool sameMesh = !m_Batches.empty() &&
+                    m_Batches.back().pipeline == item.pipeline &&
+                    m_Batches.back().material == item.material &&
+                    m_Batches.back().model == item.model &&
+                    m_Batches.back().mesh == item.mesh;
+    if (sameMesh) {
+      m_Batches.back().instanceCount++;
+    } else {
+      m_Batches.push_back({item.pipeline, item.material, item.model, item.mesh,
+                           static_cast<uint32_t>(m_Instances.size()), 1});
+    }
+    m_Instances.push_back(m_Objects[item.object]);
+    m_InstanceModels.push_back(item.model);
+  }
+
+  auto engine = UniEngine::GetInstance();
+  m_FirstInstance =
+      engine->vulkanDevice->enabledFeatures.drawIndirectFirstInstance == VK_TRUE;
+
+  auto count = static_cast<uint32_t>(m_Instances.size());
+  auto batches = static_cast<uint32_t>(m_Batches.size());
+  auto frames = static_cast<uint32_t>(engine->GetCommandBuffers().size());
+  if (count > m_InstanceCapacity || batches > m_IndirectCapacity ||
+      frames != m_FrameCount) {
+    auto instanceCapacity = std::max(count, m_InstanceCapacity * 2);
+    auto indirectCapacity = std::max(batches, m_IndirectCapacity * 2);
+
+    // command buffers recorded against the old buffers may still be running
+    if (m_InstanceBuffer.buffer) {
+      std::lock_guard<std::mutex> guard(engine->m_QueueMutex);
+      vkQueueWaitIdle(engine->GetQueue());
+      Destroy();
+    }
+
+    m_FrameCount = frames;
+    m_InstanceCapacity = std::max(instanceCapacity, 1u);
+    VK_CHECK_RESULT(engine->vulkanDevice->createBuffer(
+        VK_BUFFER_USAGE_VERTEX_BUFFER_BIT,
+        VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT |
+            VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
+        &m_InstanceBuffer,
+        m_FrameCount * m_InstanceCapacity * sizeof(glm::mat4)));
+    VK_CHECK_RESULT(m_InstanceBuffer.map());
+
+    m_IndirectCapacity = std::max(indirectCapacity, 1u);
+    VK_CHECK_RESULT(engine->vulkanDevice->createBuffer(
+        VK_BUFFER_USAGE_INDIRECT_BUFFER_BIT,
+        VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT |
+            VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
+        &m_IndirectBuffer,
+        m_FrameCount * m_IndirectCapacity * sizeof(VkDrawIndexedIndirectCommand)));
+    VK_CHECK_RESULT(m_IndirectBuffer.map());
+
+    std::fill_n(Transforms(0), m_FrameCount * m_InstanceCapacity,
+                glm::mat4(1.f));
+  }
+
+  // Everything is drawn until the first Update, in every image
+  auto commands = Commands(0);
+  for (uint32_t b = 0; b < batches; b++) {
+    auto& batch = m_Batches[b];
+    commands[b].indexCount = batch.model->m_indexCount.at(batch.mesh);
+    commands[b].instanceCount = batch.instanceCount;
+    commands[b].firstIndex = 0;
+    commands[b].vertexOffset = 0;
+    commands[b].firstInstance = m_FirstInstance ? batch.firstInstance : 0;
+  }
+  for (uint32_t f = 1; f < m_FrameCount; f++)
+    std::copy_n(commands, batches, Commands(f));
+}
+
+RenderQueueStats RenderQueue::Record(VkCommandBuffer cmd, uint32_t frame,
+                                     VkDescriptorSet globalSet,
+                                     const uint32_t globalOffsets[3],
+                                     const void* pushConstants,
+                                     uint32_t pushConstantSize,
+                                     uint32_t firstBatch,
+                                     uint32_t batchCount) const {
+  RenderQueueStats stats;
+  auto end = std::min(firstBatch + batchCount,
+                      static_cast<uint32_t>(m_Batches.size()));
+  if (firstBatch >= end)
+    return stats;
+
+  VkDeviceSize offsets[1] = {0};
+  VkDeviceSize instanceSlice =
+      frame * m_InstanceCapacity * sizeof(glm::mat4);
+  VkDeviceSize indirectSlice =
+      frame * m_IndirectCapacity * sizeof(VkDrawIndexedIndirectCommand);
+  auto ringSlice = UniEngine::GetInstance()->GetUniformRing().frameOffset(frame);
+  if (m_FirstInstance)
+    vkCmdBindVertexBuffers(cmd, INSTANCE_BUFFER_BIND_ID, 1,
+                           &m_InstanceBuffer.buffer, &instanceSlice);
+
+  VkPipeline pipeline = VK_NULL_HANDLE;
+  VkPipelineLayout layout = VK_NULL_HANDLE;
+  uni::materials::Material* material = nullptr;
+  uni::Model* model = nullptr;
+  uint32_t mesh = 0;
+
+  for (auto b = firstBatch; b < end; b++) {
+    auto& batch = m_Batches[b];
+    if (batch.pipeline != pipeline) {
+      vkCmdBindPipeline(cmd, VK_PIPELINE_BIND_POINT_GRAPHICS, batch.pipeline);
+      pipeline = batch.pipeline;
+      stats.pipelineBinds++;
+    }
+
+    // Sets bound under another layout aren't guaranteed to carry over
+    auto batchLayout = batch.material->GetPipelineLayout();
+    if (batchLayout != layout) {
+      vkCmdPushConstants(cmd, batchLayout,
+                         VK_SHADER_STAGE_FRAGMENT_BIT |
+                             VK_SHADER_STAGE_VERTEX_BIT,
+                         0, pushConstantSize, pushConstants);
+      layout = batchLayout;
+      material = nullptr;
+    }
+
+    if (batch.material != material) {
+      VkDescriptorSet sets[2] = {globalSet, *batch.material->GetDescriptorSet()};
+      // set 0's three, then the material's own in this frame's ring slice
+      uint32_t dynamicOffsets[4] = {
+          globalOffsets[0], globalOffsets[1], globalOffsets[2],
+          ringSlice + batch.material->GetDynamicUniformOffset()};
+      vkCmdBindDescriptorSets(cmd, VK_PIPELINE_BIND_POINT_GRAPHICS, layout, 0,
+                              2, sets,
+                              batch.material->HasDynamicUniform() ? 4 : 3,
+                              dynamicOffsets);
+      material = batch.material;
+      stats.materialBinds++;
+    }
+
+    if (batch.model != model || batch.mesh != mesh) {
+      vkCmdBindVertexBuffers(cmd, VERTEX_BUFFER_BIND_ID, 1,
+                             &batch.model->m_vertices.at(batch.mesh).buffer,
+                             offsets);
+      vkCmdBindIndexBuffer(cmd, batch.model->m_indices.at(batch.mesh).buffer, 0,
+                           VK_INDEX_TYPE_UINT32);
+      model = batch.model;
+      mesh = batch.mesh;
+      stats.meshBinds++;
+    }
+
+    if (!m_FirstInstance) {
+      VkDeviceSize instanceOffset =
+          instanceSlice + batch.firstInstance * sizeof(glm::mat4);
+      vkCmdBindVertexBuffers(cmd, INSTANCE_BUFFER_BIND_ID, 1,
+                             &m_InstanceBuffer.buffer, &instanceOffset);
+    }
+
+    // Update decides how many instances the draw takes
+    vkCmdDrawIndexedIndirect(
+        cmd, m_IndirectBuffer.buffer,
+        indirectSlice + b * sizeof(VkDrawIndexedIndirectCommand), 1,
+        sizeof(VkDrawIndexedIndirectCommand));
+    stats.draws++;
+  }
+
+  return stats;
+}
+
+void RenderQueue::Destroy() {
+  m_InstanceBuffer.destroy();
+  m_InstanceBuffer.buffer = VK_NULL_HANDLE;
+  m_InstanceBuffer.memory = VK_NULL_HANDLE;
+  m_InstanceBuffer.mapped = nullptr;
+  m_InstanceCapacity = 0;
+  m_FrameCount = 0;
+
+  m_IndirectBuffer.destroy();
+  m_IndirectBuffer.buffer = VK_NULL_HANDLE;
+  m_IndirectBuffer.memory = VK_NULL_HANDLE;
+  m_IndirectBuffer.mapped = nullptr;
+  m_IndirectCapacity = 0;
+}
+
+void RenderQueue::Update(uint32_t frame,
+                         const std::vector<glm::mat4>& transforms,
+                         const std::vector<uint8_t>& visible) {
+  if (m_Batches.empty() || frame >= m_FrameCount)
+    return;
+
+  auto matrices = Transforms(frame);
+  auto commands = Commands(frame);
+  for (uint32_t b = 0; b < m_Batches.size(); b++) {
+    auto& batch = m_Batches[b];
+    uint32_t drawn = 0;
+    for (uint32_t i = 0; i < batch.instanceCount; i++) {
+      auto slot = batch.firstInstance + i;
+      if (visible[slot])
+        matrices[batch.firstInstance + drawn++] = transforms[slot];
+    }
+    commands[b].instanceCount = drawn;
+  }
+}
+
+glm::mat4* RenderQueue::Transforms(uint32_t frame) const {
+  return static_cast<glm::mat4*>(m_InstanceBuffer.mapped) +
+         frame * m_InstanceCapacity;
+}
+
+VkDrawIndexedIndirectCommand* RenderQueue::Commands(uint32_t frame) const {
+  return static_cast<VkDrawIndexedIndirectCommand*>(m_IndirectBuffer.mapped) +
+         frame * m_IndirectCapacity;
+}
@@ -0,0 +1,140 @@
+#pragma once
+
+#include <memory>
+#include <vector>
+#include <vulkan/vulkan.h>
+#include "3dmaths.h"
+#include "vks/VulkanBuffer.hpp"
+
+namespace uni
+{
+	struct Model;
+
+	namespace scene
+	{
+		class SceneObject;
+	}
+
+	namespace materials
+	{
+		class Material;
+	}
+
+	namespace render
+	{
+		/** @brief Draw calls and binds of a Record, to see how well a scene batches */
+		struct RenderQueueStats {
+			uint32_t draws = 0;
+			uint32_t pipelineBinds = 0;
+			uint32_t materialBinds = 0;
+			uint32_t meshBinds = 0;
+
+			RenderQueueStats& operator+=(const RenderQueueStats& rhs) {
+				draws += rhs.draws;
+				pipelineBinds += rhs.pipelineBinds;
+				materialBinds += rhs.materialBinds;
+				meshBinds += rhs.meshBinds;
+				return *this;
+			}
+		};
+
+		/**
+		* @brief Model draws sorted by pipeline, material and mesh, with identical meshes drawn instanced
+		*
+		* Fill it with Add, one item per submesh of every model, then Build sorts the items and merges runs of the same
+		* mesh and material into one instanced draw. Record binds a pipeline, a material's descriptor sets and a mesh's
+		* buffers only when they change from the draw before. Ranges of batches can be recorded into separate command buffers
+		* from separate threads, Record only reads the queue.
+		*
+		* Every instance has a slot in a host visible buffer of model matrices, bound as per instance vertex attributes
+		* (INSTANCE_BUFFER_BIND_ID, locations 6 to 9). Each batch is an indirect draw over its run of slots, the draw
+		* commands sit in a host visible buffer as well. Recorded command buffers stay valid until the next Build and
+		* Update refreshes the matrices each frame, packing the visible instances of a batch to the front of its run and
+		* drawing only those. Both buffers hold a slice per swapchain image, the command buffer of image i reads slice i
+		* only, so updating the image about to be drawn never writes what another image's commands read.
+		*/
+		class RenderQueue {
+		public:
+			RenderQueue() = default;
+			RenderQueue(const RenderQueue&) = delete;
+			RenderQueue& operator=(const RenderQueue&) = delete;
+			~RenderQueue() { Destroy(); }
+
+			void Clear();
+			void Add(std::shared_ptr<uni::materials::Material> material, std::shared_ptr<uni::Model> model, uint32_t mesh,
+				std::shared_ptr<uni::scene::SceneObject> object);
+			/** @brief Sort and batch what was added, the instance buffer only grows */
+			void Build();
+			/**
+			* Record batches [firstBatch, firstBatch + batchCount)
+			*
+			* @param cmd Command buffer inside the render pass
+			* @param frame Swapchain image cmd is drawn into, picks the slice of the instance and indirect buffers
+			* @param globalSet The renderer's descriptor set, set 0 of every material
+			* @param globalOffsets The dynamic offsets of globalSet for this frame, see SceneRenderer::GetGlobalOffsets
+			* @param pushConstants Bytes pushed at offset 0 whenever the pipeline layout changes
+			*/
+			RenderQueueStats Record(VkCommandBuffer cmd, uint32_t frame, VkDescriptorSet globalSet,
+				const uint32_t globalOffsets[3], const void* pushConstants, uint32_t pushConstantSize, uint32_t firstBatch,
+				uint32_t batchCount) const;
+			void Destroy();
+
+			/** @brief Scene object of every instance slot, in slot order */
+			const std::vector<std::shared_ptr<uni::scene::SceneObject>>& Instances() const { return m_Instances; }
+			/** @brief Model of every instance slot, for its bounds */
+			const std::vector<uni::Model*>& InstanceModels() const { return m_InstanceModels; }
+			/**
+			* Write this frame's instances, coherent memory so nothing to flush
+			*
+			* @param frame Swapchain image about to be drawn, its command buffer must not be executing
+			* @param transforms Camera relative model matrix of every instance slot, in slot order
+			* @param visible Non zero for the slots to draw, in slot order
+			*/
+			void Update(uint32_t frame, const std::vector<glm::mat4>& transforms, const std::vector<uint8_t>& visible);
+
+			uint32_t ItemCount() const { return static_cast<uint32_t>(m_Items.size()); }
+			/** @brief Instanced draws after Build */
+			uint32_t BatchCount() const { return static_cast<uint32_t>(m_Batches.size()); }
+
+		private:
+			struct Item {
+				VkPipeline pipeline;
+				uni::materials::Material* material;
+				uni::Model* model;
+				uint32_t mesh;
+				uint32_t object;
+			};
+
+			struct Batch {
+				VkPipeline pipeline;
+				uni::materials::Material* material;
+				uni::Model* model;
+				uint32_t mesh;
+				uint32_t firstInstance;
+				uint32_t instanceCount;
+			};
+
+			glm::mat4* Transforms(uint32_t frame) const;
+			VkDrawIndexedIndirectCommand* Commands(uint32_t frame) const;
+
+			std::vector<Item> m_Items;
+			std::vector<Batch> m_Batches;
+			/** @brief Keep what the items point to alive until the next Clear */
+			std::vector<std::shared_ptr<uni::materials::Material>> m_Materials;
+			std::vector<std::shared_ptr<uni::Model>> m_Models;
+			std::vector<std::shared_ptr<uni::scene::SceneObject>> m_Objects;
+			std::vector<std::shared_ptr<uni::scene::SceneObject>> m_Instances;
+			std::vector<uni::Model*> m_InstanceModels;
+
+			/** @brief Swapchain images, each has m_InstanceCapacity matrices and m_IndirectCapacity commands */
+			uint32_t m_FrameCount = 0;
+			vks::Buffer m_InstanceBuffer;
+			uint32_t m_InstanceCapacity = 0;
+			/** @brief A VkDrawIndexedIndirectCommand per batch */
+			vks::Buffer m_IndirectBuffer;
+			uint32_t m_IndirectCapacity = 0;
+			/** @brief Without drawIndirectFirstInstance every batch binds the instance buffer at its first slot instead */
+			bool m_FirstInstance = false;
+		};
+	}
+}
@@ -34,13 +34,17 @@ void Scene::Initialize() {
   auto engine = UniEngine::GetInstance();
   m_World = ECS::World::createWorld();
   m_World->registerSystem(new MovementSystem());
-  m_World->registerSystem(new CameraSystem());
-  m_World->registerSystem(new PlanetRenderSystem());
   m_World->registerSystem(new PlayerControlSystem());
   m_World->registerSystem(new GravitySystem());
   m_World->registerSystem(new PhysicsSystem());
+  m_World->registerSystem(new FloatingOriginSystem());
+  // Everything above moves transforms, everything below reads the world matrices TransformSystem caches
+  m_World->registerSystem(new TransformSystem());
+  m_World->registerSystem(new CameraSystem());
+  m_World->registerSystem(new PlanetRenderSystem());
   m_World->registerSystem(new ModelRenderSystem());
   m_World->registerSystem(new AudioSystem());
+  m_World->setTickMode(ECS::TickMode::Parallel);
 
   m_CurrentCamera = Make<SceneObject>(glm::vec3(0), "player camera");
   m_CurrentCamera->AddComponent<CameraComponent>(
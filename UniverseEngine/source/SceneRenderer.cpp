@@ -1,9 +1,13 @@
 #include <algorithm>
+#include <thread>
 
 #include "UniEngine.h"
+#include "Frustum.hpp"
 #include "SceneManager.h"
 #include "SceneRenderer.h"
+#include "components/Planet.h"
 #include "systems/events.h"
+#include "vks/threadpool.hpp"
 
 using namespace uni::render;
 using namespace uni::scene;
@@ -32,11 +36,14 @@ void alignedFree(void* data) {
 }
 
 SceneRenderer::SceneRenderer(std::string name)
+    : m_Frustum(std::make_unique<Frustum>())
 {
   m_name = name;
   std::cout << "******************** SCENERENDER!!! " << name << " ********************" << std::endl;
 }
 
+SceneRenderer::~SceneRenderer() = default;
+
 void SceneRenderer::Initialise() {
   std::cout << "Prepare vertex descriptions..." << std::endl;
   SetupVertexDescriptions();
@@ -57,6 +64,7 @@ void SceneRenderer::Initialise() {
   SetupDescriptorSets();
 
   std::cout << "Initialize command buffers..." << std::endl;
+  PrepareSecondaryCommandBuffers();
   BuildCommandBuffers();
 }
 
@@ -65,6 +73,15 @@ void SceneRenderer::ShutDown() {
   auto engine = UniEngine::GetInstance();
   auto device = engine->GetDevice();
 
+  m_RenderQueue.Destroy();
+
+  // The pools free their command buffers
+  m_ThreadPool.reset();
+  for (auto& frame : m_FrameCommands)
+    for (auto pool : frame.pools)
+      vkDestroyCommandPool(device, pool, nullptr);
+  m_FrameCommands.clear();
+
   std::cout << "Destroying Pipeline layout" << std::endl;
   vkDestroyPipelineLayout(device, m_pipelineLayouts.forward, nullptr);
   /*std::cout << "Destroying Pipeline" << std::endl;
@@ -75,9 +92,7 @@ void SceneRenderer::ShutDown() {
   vkDestroyDescriptorPool(device, m_descriptorPool, nullptr);
 
   // Uniform buffers
-  m_uniformBuffers.vsForward.destroy();
   m_uniformBuffers.modelViews.destroy();
-  m_uniformBuffers.fsLights.destroy();
 
 }
 
@@ -86,7 +101,11 @@ void SceneRenderer::SetupVertexDescriptions() {
   m_vertices.bindingDescriptions = {
       vks::initializers::vertexInputBindingDescription(
           VERTEX_BUFFER_BIND_ID, m_vertexLayout.stride(),
-          VK_VERTEX_INPUT_RATE_VERTEX)};
+          VK_VERTEX_INPUT_RATE_VERTEX),
+      // Model matrix of each instance, see RenderQueue
+      vks::initializers::vertexInputBindingDescription(
+          INSTANCE_BUFFER_BIND_ID, sizeof(glm::mat4),
+          VK_VERTEX_INPUT_RATE_INSTANCE)};
 
   // Attribute descriptions
   m_vertices.attributeDescriptions = {
@@ -111,6 +130,18 @@ void SceneRenderer::SetupVertexDescriptions() {
       vks::initializers::vertexInputAttributeDescription(
           VERTEX_BUFFER_BIND_ID, 5, VK_FORMAT_R32_SFLOAT,
           sizeof(float) * 14),
+      // Location 6 - 9: Instance model matrix, a column each
+      vks::initializers::vertexInputAttributeDescription(
+          INSTANCE_BUFFER_BIND_ID, 6, VK_FORMAT_R32G32B32A32_SFLOAT, 0),
+      vks::initializers::vertexInputAttributeDescription(
+          INSTANCE_BUFFER_BIND_ID, 7, VK_FORMAT_R32G32B32A32_SFLOAT,
+          sizeof(float) * 4),
+      vks::initializers::vertexInputAttributeDescription(
+          INSTANCE_BUFFER_BIND_ID, 8, VK_FORMAT_R32G32B32A32_SFLOAT,
+          sizeof(float) * 8),
+      vks::initializers::vertexInputAttributeDescription(
+          INSTANCE_BUFFER_BIND_ID, 9, VK_FORMAT_R32G32B32A32_SFLOAT,
+          sizeof(float) * 12),
   };
 
   m_vertices.inputState =
@@ -129,12 +160,8 @@ void SceneRenderer::SetupVertexDescriptions() {
 void SceneRenderer::PrepareUniformBuffers() {
   auto engine = UniEngine::GetInstance();
 
-  // Fullscreen vertex shader
-  VK_CHECK_RESULT(engine->vulkanDevice->createBuffer(
-      VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT,
-      VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT |
-          VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
-      &m_uniformBuffers.vsForward, sizeof(m_uboForward)));
+  // View/projection and lights are pushed into the engine's uniform ring every
+  // frame, see PushUniforms
 
   auto models = engine->GetSceneManager()->CurrentScene()->GetRenderedObjects();
   auto dynamicAlignment = engine->getDynamicAlignment();
@@ -149,17 +176,8 @@ void SceneRenderer::PrepareUniformBuffers() {
       VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT,
       &m_uniformBuffers.modelViews, bufferSize));
 
-  // fragment shader
-  VK_CHECK_RESULT(engine->vulkanDevice->createBuffer(
-      VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT,
-      VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT |
-          VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
-      &m_uniformBuffers.fsLights, sizeof(uboLights)));
-
   // Map persistent
-  VK_CHECK_RESULT(m_uniformBuffers.vsForward.map());
   VK_CHECK_RESULT(m_uniformBuffers.modelViews.map());
-  VK_CHECK_RESULT(m_uniformBuffers.fsLights.map());
 
   // Update
   updateUniformBuffersScreen();
@@ -170,13 +188,13 @@ void SceneRenderer::PrepareUniformBuffers() {
 void SceneRenderer::SetupDescriptorSetLayout() {
   // Deferred shading layout
   m_setLayoutBindings = {
-      // Binding 0 : uniform buffer
+      // Binding 0 : uniform buffer, in the uniform ring
       vks::initializers::descriptorSetLayoutBinding(
-          VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER,
+          VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC,
           VK_SHADER_STAGE_VERTEX_BIT | VK_SHADER_STAGE_FRAGMENT_BIT, 0),
-      // Binding 1 : lights uniform buffer
+      // Binding 1 : lights uniform buffer, in the uniform ring
       vks::initializers::descriptorSetLayoutBinding(
-          VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER,
+          VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC,
           VK_SHADER_STAGE_VERTEX_BIT | VK_SHADER_STAGE_FRAGMENT_BIT, 1),
       // Binding 2 : dynamic buffer for models
       vks::initializers::descriptorSetLayoutBinding(
@@ -301,12 +319,9 @@ void SceneRenderer::SetupDescriptorPool() {
   auto drawCmdBufferCount = static_cast<uint32_t>(drawCmdBuffers.size());
 
   std::vector<VkDescriptorPoolSize> poolSizes = {
-      vks::initializers::descriptorPoolSize(
-          VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER,
-          2 * modelCount * drawCmdBufferCount),
       vks::initializers::descriptorPoolSize(
           VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC,
-          modelCount * drawCmdBufferCount)};
+          3 * modelCount * drawCmdBufferCount)};
 
   VkDescriptorPoolCreateInfo descriptorPoolInfo =
       vks::initializers::descriptorPoolCreateInfo(
@@ -327,15 +342,19 @@ void SceneRenderer::SetupDescriptorSets() {
   VK_CHECK_RESULT(
       vkAllocateDescriptorSets(device, &allocInfo, &m_descriptorSet));
 
+  auto& ring = UniEngine::GetInstance()->GetUniformRing();
+  auto forwardDescriptor = ring.descriptor(sizeof(m_uboForward));
+  auto lightsDescriptor = ring.descriptor(sizeof(uboLights));
+
   m_writeDescriptorSets = {
       // Binding 0 : view/proj buffer
       vks::initializers::writeDescriptorSet(
-          m_descriptorSet, VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER, 0,
-          &m_uniformBuffers.vsForward.descriptor),
+          m_descriptorSet, VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC, 0,
+          &forwardDescriptor),
       // Binding 1 : lights buffer
       vks::initializers::writeDescriptorSet(
-          m_descriptorSet, VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER, 1,
-          &m_uniformBuffers.fsLights.descriptor),
+          m_descriptorSet, VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC, 1,
+          &lightsDescriptor),
       // Binding 2 : modelviews
       vks::initializers::writeDescriptorSet(
           m_descriptorSet, VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC, 2,
@@ -349,8 +368,61 @@ void SceneRenderer::SetupDescriptorSets() {
                          m_writeDescriptorSets.data(), 0, nullptr);
 }
 
+void SceneRenderer::PrepareSecondaryCommandBuffers() {
+  auto engine = UniEngine::GetInstance();
+  auto device = engine->GetDevice();
+
+  // The calling thread records too, so leave it a core
+  auto workers = std::max(std::thread::hardware_concurrency(), 2u) - 1;
+  m_ThreadPool = std::make_unique<vks::ThreadPool>();
+  m_ThreadPool->setThreadCount(workers);
+  std::cout << "Recording command buffers on " << workers << " worker threads" << std::endl;
+
+  m_FrameCommands.resize(engine->GetCommandBuffers().size());
+  for (auto& frame : m_FrameCommands) {
+    frame.pools.resize(workers + 1);
+    frame.buffers.resize(workers + 1);
+    for (uint32_t t = 0; t <= workers; t++) {
+      // Reset a whole pool at a time, not each buffer
+      frame.pools[t] = engine->vulkanDevice->createCommandPool(
+          engine->vulkanDevice->queueFamilyIndices.graphics, 0);
+      auto allocInfo = vks::initializers::commandBufferAllocateInfo(
+          frame.pools[t], VK_COMMAND_BUFFER_LEVEL_SECONDARY, 1);
+      VK_CHECK_RESULT(
+          vkAllocateCommandBuffers(device, &allocInfo, &frame.buffers[t]));
+    }
+  }
+}
+
+void SceneRenderer::BeginSecondary(VkCommandBuffer cmd,
+                                   VkFramebuffer framebuffer) {
+  auto engine = UniEngine::GetInstance();
+
+  VkCommandBufferInheritanceInfo inheritanceInfo{};
+  inheritanceInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_INHERITANCE_INFO;
+  inheritanceInfo.renderPass = engine->GetRenderPass();
+  inheritanceInfo.subpass = 0;
+  inheritanceInfo.framebuffer = framebuffer;
+
+  VkCommandBufferBeginInfo beginInfo =
+      vks::initializers::commandBufferBeginInfo();
+  beginInfo.flags = VK_COMMAND_BUFFER_USAGE_RENDER_PASS_CONTINUE_BIT;
+  beginInfo.pInheritanceInfo = &inheritanceInfo;
+  VK_CHECK_RESULT(vkBeginCommandBuffer(cmd, &beginInfo));
+
+  // Dynamic state isn't inherited from the primary
+  VkViewport viewport = vks::initializers::viewport(
+      (float)engine->width, (float)engine->height, 0.0f, 1.0f);
+  vkCmdSetViewport(cmd, 0, 1, &viewport);
+
+  VkRect2D scissor =
+      vks::initializers::rect2D(engine->width, engine->height, 0, 0);
+  vkCmdSetScissor(cmd, 0, 1, &scissor);
+}
+
 void SceneRenderer::BuildCommandBuffers() {
   auto engine = UniEngine::GetInstance();
+  m_CommandBuffersDirty = false;
 
   VkCommandBufferBeginInfo cmdBufInfo =
       vks::initializers::commandBufferBeginInfo();
@@ -371,61 +443,69 @@ void SceneRenderer::BuildCommandBuffers() {
 
   auto& drawCmdBuffers = engine->GetCommandBuffers();
 
+  UpdateCamera((float)engine->width, (float)engine->height);
+
+  // Every image draws the same batches, so the queue is filled and built once
+  SceneManager()->EmitEvent<RenderQueueEvent>({m_RenderQueue});
+
+  // Contiguous runs of batches per worker, so the state only changes at the
+  // seams as often as it would on one thread
+  auto batches = m_RenderQueue.BatchCount();
+  auto workers = static_cast<uint32_t>(m_ThreadPool->threads.size());
+  workers = std::max(
+      std::min(workers, (batches + MinBatchesPerThread - 1) / MinBatchesPerThread),
+      1u);
+  auto perWorker = (batches + workers - 1) / workers;
+
   for (int32_t i = 0; i < drawCmdBuffers.size(); ++i) {
     // Set target frame buffer
     renderPassBeginInfo.framebuffer = engine->GetFrameBuffers()[i];
 
     VK_CHECK_RESULT(vkBeginCommandBuffer(drawCmdBuffers[i], &cmdBufInfo));
 
+    // Everything in the pass comes from secondary command buffers
     vkCmdBeginRenderPass(drawCmdBuffers[i], &renderPassBeginInfo,
-                         VK_SUBPASS_CONTENTS_INLINE);
-
-    VkViewport viewport = vks::initializers::viewport(
-        (float)engine->width, (float)engine->height, 0.0f, 1.0f);
-    vkCmdSetViewport(drawCmdBuffers[i], 0, 1, &viewport);
-
-    VkRect2D scissor =
-        vks::initializers::rect2D(engine->width, engine->height, 0, 0);
-    vkCmdSetScissor(drawCmdBuffers[i], 0, 1, &scissor);
-
-    // uint32_t dummy = 0;
-    // vkCmdBindDescriptorSets(drawCmdBuffers[i],
-    // VK_PIPELINE_BIND_POINT_GRAPHICS,
-    //                        pipelineLayouts.forward, 0, 1, &m_descriptorSet,
-    //                        0, nullptr);
-
-    // if(m_debugDisplay) {
-    //	vkCmdBindPipeline(drawCmdBuffers[i], VK_PIPELINE_BIND_POINT_GRAPHICS,
-    // pipelines.debug); 	vkCmdDraw(drawCmdBuffers[i], 3, 1, 0, 0);
-    //	// Move viewport to display final composition in lower right corner
-    //	viewport.x = viewport.width * 0.5f;
-    //	viewport.y = viewport.height * 0.5f;
-    //	viewport.width = (float)width * 0.5f;
-    //	viewport.height = (float)height * 0.5f;
-    //	vkCmdSetViewport(drawCmdBuffers[i], 0, 1, &viewport);
-    //}
-
-    UpdateCamera((float)viewport.width, (float)viewport.height);
-
-    // Final composition as full screen quad
-    // vkCmdBindPipeline(drawCmdBuffers[i], VK_PIPELINE_BIND_POINT_GRAPHICS,
-    //                  m_pipelines.forward);
-    // vkCmdDraw(drawCmdBuffers[i], 3, 1, 0, 0);
-
-    auto dynamicAlignment = engine->getDynamicAlignment();
-    
+                         VK_SUBPASS_CONTENTS_SECONDARY_COMMAND_BUFFERS);
+
+    auto& frame = m_FrameCommands[i];
+    for (auto pool : frame.pools)
+      VK_CHECK_RESULT(vkResetCommandPool(engine->GetDevice(), pool, 0));
+
+    // Anything drawn outside the render queue goes in the first secondary
+    BeginSecondary(frame.buffers[0], renderPassBeginInfo.framebuffer);
     vkCmdPushConstants(
-        drawCmdBuffers[i], m_pipelineLayouts.forward,
+        frame.buffers[0], m_pipelineLayouts.forward,
         VK_SHADER_STAGE_FRAGMENT_BIT | VK_SHADER_STAGE_VERTEX_BIT, 0,
         sizeof(m_TimeConstants), &m_TimeConstants);
-
-    //for (const auto& material : m_materialInstances) {
-    //  // std::cout << "Building command buffer for material: "
-    //  //          << material->GetName() << std::endl;
-    //  index = material.second->AddToCommandBuffer(drawCmdBuffers[i], index);
-    //}
-
-    SceneManager()->EmitEvent<RenderEvent>({drawCmdBuffers[i]});
+    SceneManager()->EmitEvent<RenderEvent>({frame.buffers[0]});
+    VK_CHECK_RESULT(vkEndCommandBuffer(frame.buffers[0]));
+
+    // the instances don't read the per object buffer
+    uint32_t globalOffsets[3];
+    GetGlobalOffsets(i, 0, globalOffsets);
+
+    std::vector<RenderQueueStats> stats(workers);
+    for (uint32_t t = 0; t < workers; t++) {
+      auto cmd = frame.buffers[t + 1];
+      auto framebuffer = renderPassBeginInfo.framebuffer;
+      m_ThreadPool->threads[t]->addJob([=, &stats] {
+        BeginSecondary(cmd, framebuffer);
+        stats[t] = m_RenderQueue.Record(cmd, i, m_descriptorSet, globalOffsets,
+                                        &m_TimeConstants,
+                                        sizeof(m_TimeConstants),
+                                        t * perWorker, perWorker);
+        VK_CHECK_RESULT(vkEndCommandBuffer(cmd));
+      });
+    }
+    m_ThreadPool->wait();
+
+    vkCmdExecuteCommands(drawCmdBuffers[i], workers + 1, frame.buffers.data());
+
+    // Every image records the same batches, the last one's stats stand for all
+    m_RecordStats = RenderQueueStats();
+    for (auto& s : stats)
+      m_RecordStats += s;
+    m_RecordThreads = workers;
 
     vkCmdEndRenderPass(drawCmdBuffers[i]);
 
@@ -433,6 +513,14 @@ void SceneRenderer::BuildCommandBuffers() {
   }
 }
 
+void SceneRenderer::UpdateCommandBuffers() {
+  if (!m_CommandBuffersDirty || m_FrameCommands.empty())
+    return;
+  BuildCommandBuffers();
+  // Build left identity matrices in the queue, fill in the real ones
+  UpdateDynamicUniformBuffers();
+}
+
 void SceneRenderer::Render() {
   UpdateUniformBufferDeferredLights();
   UpdateDynamicUniformBuffers();
@@ -451,14 +539,41 @@ void SceneRenderer::updateUniformBuffersScreen() {
       SceneManager()->CurrentScene()->GetCameraComponent()->matrices.projection;
   m_uboForward.view =
       SceneManager()->CurrentScene()->GetCameraComponent()->matrices.view;
-  memcpy(m_uniformBuffers.vsForward.mapped, &m_uboForward,
-         sizeof(m_uboForward));
+}
+
+void SceneRenderer::PushUniforms() {
+  auto& ring = UniEngine::GetInstance()->GetUniformRing();
+
+  // Pushed in the same order every frame, so the offsets only change when
+  // what is pushed does and the command buffers have to bind the new ones
+  auto forwardOffset = ring.push(&m_uboForward, sizeof(m_uboForward));
+  auto lightsOffset = ring.push(&uboLights, sizeof(uboLights));
+  if (forwardOffset != m_ForwardOffset || lightsOffset != m_LightsOffset)
+    MarkCommandBuffersDirty();
+  m_ForwardOffset = forwardOffset;
+  m_LightsOffset = lightsOffset;
+
+  SceneManager()->CurrentScene()->m_World->each<uni::components::Planet>(
+      [&](ECS::Entity* ent,
+          ECS::ComponentHandle<uni::components::Planet> planet) {
+        planet->PushUniforms();
+      });
+}
+
+void SceneRenderer::GetGlobalOffsets(uint32_t image, uint32_t objectOffset,
+                                     uint32_t offsets[3]) const {
+  auto frameOffset =
+      UniEngine::GetInstance()->GetUniformRing().frameOffset(image);
+  offsets[0] = frameOffset + m_ForwardOffset;
+  offsets[1] = frameOffset + m_LightsOffset;
+  offsets[2] = objectOffset;
 }
 
 // Update light position uniform block
 void SceneRenderer::UpdateUniformBufferDeferredLights() {
   // each scene light into uboFragmentLights.lights
   uint32_t lightCount = 0;
+  auto camera = SceneManager()->CurrentScene()->GetCameraComponent();
   SceneManager()
       ->CurrentScene()
       ->m_World->each<TransformComponent, LightComponent>(
@@ -467,7 +582,7 @@ void SceneRenderer::UpdateUniformBufferDeferredLights() {
               ECS::ComponentHandle<LightComponent> light) {
             // std::cout << "Found a light! " << lightCount;
             if (light->enabled && lightCount < MAX_LIGHT_COUNT) {
-              glm::vec4 lPos = glm::vec4(transform->m_dPos, 0);
+              glm::vec4 lPos = glm::vec4(camera->RelativeToCamera(transform->GetWorldPosition()), 0);
               glm::vec3 lCol = glm::vec3(light->color);
               uboLights.lights[lightCount].color = lCol;
               uboLights.lights[lightCount].radius = light->radius;
@@ -484,14 +599,11 @@ void SceneRenderer::UpdateUniformBufferDeferredLights() {
             lightCount++;
           });
 
-  uboLights.viewPos = glm::vec4(
-      SceneManager()->CurrentScene()->GetCameraComponent()->GetPosition(),
-      0.0f);
+  // lighting happens in camera relative space, so the viewer is at the origin
+  uboLights.viewPos = glm::vec4(0.0f);
   uboLights.numLights = lightCount;
 
   // std::cout << "Enabled lights: " << lightCount << std::endl;
-
-  memcpy(m_uniformBuffers.fsLights.mapped, &uboLights, sizeof(uboLights));
 }
 
 void SceneRenderer::UpdateDynamicUniformBuffers() {
@@ -499,18 +611,36 @@ void SceneRenderer::UpdateDynamicUniformBuffers() {
   uint32_t index = 0;
   auto dynamicAlignment = engine->getDynamicAlignment();
   auto models = SceneManager()->CurrentScene()->GetRenderedObjects();
+  auto camera = SceneManager()->CurrentScene()->GetCameraComponent();
   for_each(models.begin(), models.end(),
-           [this, &index, dynamicAlignment](std::shared_ptr<SceneObject> model) {
+           [this, &index, dynamicAlignment, &camera](std::shared_ptr<SceneObject> model) {
              glm::mat4* modelMat =
                  (glm::mat4*)(((uint64_t)m_uboModelMatDynamic.model +
                                (index * dynamicAlignment)));
-             *modelMat = model->GetTransform()->GetModelMat();
+             *modelMat = camera->RelativeToCamera(model->GetTransform()->GetModelMatDouble());
              // std::cout << "Updating model matrix index: " << index <<
              // std::endl;
              model->SetRenderIndex(index);
              index++;
            });
 
+  // Instanced draws read their matrices from the queue's slots instead, only
+  // the ones in view and big enough on screen go there
+  auto& instances = m_RenderQueue.Instances();
+  auto& instanceModels = m_RenderQueue.InstanceModels();
+  m_InstanceTransforms.resize(instances.size());
+  m_Visibility.Clear();
+  for (uint32_t i = 0; i < instances.size(); i++) {
+    m_InstanceTransforms[i] = camera->RelativeToCamera(
+        instances[i]->GetTransform()->GetModelMatDouble());
+    m_Visibility.Add(*instanceModels[i], m_InstanceTransforms[i]);
+  }
+
+  m_Frustum->SetToViewProjection(camera->matrices.projection *
+                                 camera->matrices.view);
+  float pixelScale = camera->matrices.projection[1][1] * engine->height * 0.5f;
+  m_Visibility.Cull(*m_Frustum, pixelScale, m_CullPixels);
+
   memcpy(m_uniformBuffers.modelViews.mapped, m_uboModelMatDynamic.model,
          m_uniformBuffers.modelViews.size);
   // Flush to make changes visible to the host
@@ -520,6 +650,13 @@ void SceneRenderer::UpdateDynamicUniformBuffers() {
   vkFlushMappedMemoryRanges(engine->GetDevice(), 1, &memoryRange);
 }
 
+void SceneRenderer::UpdateRenderQueue(uint32_t image) {
+  // Nothing culled yet, the queue still draws everything from its Build
+  if (m_InstanceTransforms.size() != m_RenderQueue.Instances().size())
+    return;
+  m_RenderQueue.Update(image, m_InstanceTransforms, m_Visibility.Visible());
+}
+
 void SceneRenderer::UpdateCamera(float width, float height) {
   SceneManager()->CurrentScene()->GetCameraComponent()->aspect = width / height;
   SceneManager()->CurrentScene()->GetCameraComponent()->CalculateProjection();
@@ -5,6 +5,8 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <atomic>
+#include <memory>
 #include <vector>
 
 #include "3dmaths.h"
@@ -12,11 +14,20 @@
 #include <vulkan/vulkan.h>
 #include "vks/VulkanBuffer.hpp"
 #include "ModelMesh.h"
+#include "RenderQueue.h"
+#include "Visibility.h"
 #include "vks/VulkanTexture.hpp"
 #include "vks/vulkanexamplebase.h"
 
 #define MAX_LIGHT_COUNT 1000
 
+namespace vks
+{
+	class ThreadPool;
+}
+
+class Frustum;
+
 namespace uni
 {
 	namespace scene
@@ -54,10 +65,12 @@ namespace uni
 		  } uboLights;
 		
 		  struct {
-		    vks::Buffer vsForward;
-		    vks::Buffer fsLights;
 		    vks::Buffer modelViews;
 		  } m_uniformBuffers;
+
+		  /** @brief Where PushUniforms put m_uboForward and uboLights in each slice of the engine's uniform ring */
+		  uint32_t m_ForwardOffset = 0;
+		  uint32_t m_LightsOffset = 0;
 		
 		  using PushConstantStruct = struct {
 		    uint32_t time_seconds = 0;
@@ -104,10 +117,40 @@ namespace uni
 		  } m_vertices;
 		
 		  std::string m_name = "";
+
+		  RenderQueue m_RenderQueue;
+
+		  /**
+		  * @brief Secondary command buffers of one swapchain image, each from a pool of its own so threads never share one
+		  *
+		  * The first is recorded on the calling thread with the RenderEvent, the rest by the workers, one each.
+		  */
+		  struct FrameCommands {
+		    std::vector<VkCommandPool> pools;
+		    std::vector<VkCommandBuffer> buffers;
+		  };
+		  std::vector<FrameCommands> m_FrameCommands;
+		  std::unique_ptr<vks::ThreadPool> m_ThreadPool;
+		  /** @brief Fewer batches than this per worker aren't worth handing to another thread */
+		  static const uint32_t MinBatchesPerThread = 32;
+		  RenderQueueStats m_RecordStats;
+		  uint32_t m_RecordThreads = 0;
+		  /** @brief Set from any thread when the recorded command buffers no longer match the scene */
+		  std::atomic<bool> m_CommandBuffersDirty{ false };
+
+		  /** @brief Instances culled on the CPU each frame before their matrices go to the render queue */
+		  Visibility m_Visibility;
+		  std::unique_ptr<Frustum> m_Frustum;
+		  std::vector<glm::mat4> m_InstanceTransforms;
+		  /** @brief Models with a smaller radius on screen in pixels aren't drawn */
+		  float m_CullPixels = 0.5f;
+
+		  void PrepareSecondaryCommandBuffers();
+		  void BeginSecondary(VkCommandBuffer cmd, VkFramebuffer framebuffer);
 		
 		 public:
 		   SceneRenderer(std::string name);
-		  ~SceneRenderer() = default;
+		  ~SceneRenderer();
 		
 		  void Initialise();
 		  void ShutDown();
@@ -120,10 +163,22 @@ namespace uni
 		  void Render();
 		  void ViewChanged();
 		  void updateUniformBuffersScreen();
+		  /** @brief Copy this frame's uniform blocks into the uniform ring, after its beginFrame and before recording */
+		  void PushUniforms();
+		  /**
+		  * Dynamic offsets of set 0 for a command buffer of a swapchain image
+		  *
+		  * @param image Swapchain image the command buffer draws into
+		  * @param objectOffset Offset into the per object buffer, binding 2
+		  * @param offsets Receives the offsets of bindings 0, 1 and 2
+		  */
+		  void GetGlobalOffsets(uint32_t image, uint32_t objectOffset, uint32_t offsets[3]) const;
 		
 		  std::shared_ptr<uni::scene::SceneManager> SceneManager();
 		  void UpdateUniformBufferDeferredLights();
 		  void UpdateDynamicUniformBuffers();
+		  /** @brief Write the instances culled by the last Render to the slice of the swapchain image about to be drawn */
+		  void UpdateRenderQueue(uint32_t image);
 		
 		  void UpdateCamera(float width, float height);
 		  void SetupDescriptorSetLayout();
@@ -131,6 +186,10 @@ namespace uni
 		  void SetupDescriptorPool();
 		  void SetupDescriptorSets();
 		  void BuildCommandBuffers();
+		  /** @brief Record the command buffers again on the next UpdateCommandBuffers, e.g. once models come or go */
+		  void MarkCommandBuffersDirty() { m_CommandBuffersDirty = true; }
+		  /** @brief Re-record if marked dirty, only while no command buffer of the renderer is executing */
+		  void UpdateCommandBuffers();
 		  void RegisterMaterial(std::string materialID, std::shared_ptr<uni::materials::Material> mat);
 		  void UnRegisterMaterial(std::string materialID);
 		  void UnRegisterMaterials();
@@ -140,6 +199,18 @@ namespace uni
 		  std::shared_ptr<T> GetMaterialByID(std::string materialID);
 		
 		
+		  /**
+		  * @brief Sorted and instanced model draws, filled and built once by ModelRenderSystem on the RenderQueueEvent, then
+		  * recorded for every swapchain image by the worker threads
+		  */
+		  RenderQueue& GetRenderQueue() { return m_RenderQueue; }
+		  /** @brief Draws and binds of the render queue when the command buffers were last recorded */
+		  const RenderQueueStats& GetRecordStats() const { return m_RecordStats; }
+		  uint32_t GetRecordThreads() const { return m_RecordThreads; }
+		  /** @brief Model instances tested, drawn and culled this frame */
+		  const VisibilityStats& GetVisibilityStats() const { return m_Visibility.Stats(); }
+		  void SetCullPixels(float pixels) { m_CullPixels = pixels; }
+
 		  uni::VertexLayout GetVertexLayout() { return m_vertexLayout; }
 		  VkDescriptorSetLayout GetDescriptorSetLayout() { return m_descriptorSetLayout;}
 		  VkDescriptorSetLayoutCreateInfo GetDescriptorLayout() {
@@ -1,10 +1,15 @@
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <iostream>
+#include <ppl.h>
 #include "UniEngine.h"
 #include "UniBody.h"
 #include "Components.h"
 
 #include "Triangulator.hpp"
 
-#include "UniFrustum.hpp"
+#include "Frustum.hpp"
 
 
 
@@ -97,7 +102,7 @@ std::vector<uint32_t> GetIcosahedronIndicesBFC() {
 
 Triangulator::Triangulator(UniBody* pPlanet)
 	: m_pPlanet(pPlanet) {
-	m_pFrustum = new UniFrustum();
+	m_pFrustum = new Frustum();
 }
 Triangulator::~Triangulator() {
 	delete m_pFrustum;
@@ -109,10 +114,11 @@ void Triangulator::Init() {
 	for(size_t i = 0; i < indices.size(); i += 3) {
 		m_Icosahedron.emplace_back(ico[indices[i]], ico[indices[i + 1]], ico[indices[i + 2]], nullptr, 0);
 	}
+	m_Faces.resize(m_Icosahedron.size());
+	m_Radius = (float)m_pPlanet->GetRadius();
 
-	Precalculate();
-
-	//First geometry generation
+	//First geometry generation, Update sets up the LUTs and the frustum
+	Update();
 	GenerateGeometry();
 }
 
@@ -140,6 +146,7 @@ bool Triangulator::Update() {
 	// 
 	auto camera = UniEngine::GetInstance().GetScene()->GetCameraComponent();
 
+	m_Radius = (float)m_pPlanet->GetRadius();
 	m_CameraObjectSpacePos = glm::vec3(glm::inverse(m_pPlanet->GetTransform()->GetModelMat()) * glm::vec4(camera->GetPosition(), 1.f));
 
 	m_pFrustum->SetCullTransform(m_pPlanet->GetTransform()->GetModelMat());
@@ -148,119 +155,399 @@ bool Triangulator::Update() {
 	
 	m_pFrustum->Update();
 
+	CalculateDotLUT();
+
 	return true;
 }
 
 void Triangulator::Precalculate() {
 	//determine culling angle behind planet based on max height
 	float cullingAngle = acosf((float)(m_pPlanet->GetRadius() / (m_pPlanet->GetRadius() + m_pPlanet->GetMaxHeight())));
-	//Dot Product LUT
-	m_TriLevelDotLUT.clear();
-	m_TriLevelDotLUT.push_back(0.5f + sinf(cullingAngle));
-	float angle = acosf(0.5f);
-	for(uint32_t i = 1; i <= m_MaxLevel; i++) {
-		angle *= 0.5f;
-		m_TriLevelDotLUT.push_back(sinf(angle + cullingAngle));
-	}
-	//height multipliers
+	float normMaxHeight = (float)(m_pPlanet->GetMaxHeight() / m_pPlanet->GetRadius());
+
+	//Follow the middle triangle down the levels, it is the widest one of its level seen from the planet's centre.
+	//Its corners' angle to the centre bounds how far any surface normal under a triangle is turned from the centre's,
+	//and 1 / cos of it how far the sphere bulges above the flat triangle.
+	m_TriLevelAngleLUT.clear();
 	m_HeightMultLUT.clear();
 	glm::vec3 a = m_Icosahedron[0].a;
 	glm::vec3 b = m_Icosahedron[0].b;
 	glm::vec3 c = m_Icosahedron[0].c;
-	glm::vec3 center = (a + b + c) / 3.f;
-	center = center * (float)m_pPlanet->GetRadius() / glm::length(center);//+maxHeight
-	m_HeightMultLUT.push_back(1 / glm::dot(glm::normalize(a), glm::normalize(center)));
-	float normMaxHeight = (float)(m_pPlanet->GetMaxHeight() / m_pPlanet->GetRadius());
-	for(uint32_t i = 1; i <= m_MaxLevel; i++) {
-		glm::vec3 A = b + ((c - b)*0.5f);
-		glm::vec3 B = c + ((a - c)*0.5f);
-		c = a + ((b - a)*0.5f);
-		a = A * (float)m_pPlanet->GetRadius() / glm::length(A);
-		b = B * (float)m_pPlanet->GetRadius() / glm::length(B);
-		c = c * (float)m_pPlanet->GetRadius() / glm::length(c);
-		m_HeightMultLUT.push_back(1 / glm::dot(glm::normalize(a), glm::normalize(center)) + normMaxHeight);
+	glm::vec3 center = glm::normalize(a + b + c);
+	for(uint32_t i = 0; i <= m_MaxLevel; i++) {
+		if(i > 0) {
+			glm::vec3 A = b + ((c - b)*0.5f);
+			glm::vec3 B = c + ((a - c)*0.5f);
+			c = a + ((b - a)*0.5f);
+			a = A * (float)m_pPlanet->GetRadius() / glm::length(A);
+			b = B * (float)m_pPlanet->GetRadius() / glm::length(B);
+			c = c * (float)m_pPlanet->GetRadius() / glm::length(c);
+		}
+		float cosCorner = glm::clamp(glm::dot(glm::normalize(a), center), 0.f, 1.f);
+		m_TriLevelAngleLUT.push_back(acosf(cosCorner) + cullingAngle);
+		//the highest terrain over the bulge, so triangles and everything they subdivide into fit between 1 and this
+		m_HeightMultLUT.push_back((1.f + normMaxHeight) / cosCorner * 1.001f);
 	}
 }
 
-void Triangulator::GenerateGeometry() {
-	//Precalculate Distance LUT
+void Triangulator::CalculateDotLUT() {
+	//Terrain at angle phi from the point under the camera can be seen while phi < horizon + cullingAngle, a triangle
+	//may hold such terrain while its centre is within its corner angle of that
+	float camDist = glm::length(m_CameraObjectSpacePos);
+	m_Horizon = camDist > m_Radius ? acosf(m_Radius / camDist) : 0.f;
+	m_CameraAltitude = camDist - m_Radius;
+	m_CameraDirection = camDist > 0.f ? m_CameraObjectSpacePos / camDist : glm::vec3(0, 1, 0);
+
+	m_TriLevelDotLUT.clear();
+	for(auto angle : m_TriLevelAngleLUT) {
+		float limit = m_Horizon + angle;
+		//-2 never culls
+		m_TriLevelDotLUT.push_back(limit < glm::pi<float>() ? cosf(limit) : -2.f);
+	}
+}
+
+bool Triangulator::CalculateDistanceLUT() {
 	//The distances generated should keep the triangles smaller than m_AllowedTriPx at any level
-	//In future only recalculate on FOV or triangle density change
-	m_DistanceLUT.clear();
 	float sizeL = glm::length(m_Icosahedron[0].a - m_Icosahedron[0].b);
 	float frac = tanf((m_AllowedTriPx * glm::radians(m_pFrustum->GetFOV())) / UniEngine::GetInstance().width);
+	bool changed = m_DistanceLUT.size() != m_MaxLevel + 5;
+	m_DistanceLUT.resize(m_MaxLevel + 5);
 	for(uint32_t level = 0; level < m_MaxLevel + 5; level++) {
-		m_DistanceLUT.push_back(sizeL / frac);
+		float distance = sizeL / frac;
+		changed |= m_DistanceLUT[level] != distance;
+		m_DistanceLUT[level] = distance;
 		sizeL *= 0.5f;
 	}
+	return changed;
+}
+
+void Triangulator::GenerateGeometry() {
+	m_DirtySlots.clear();
+
+	//Decisions made against other distances or levels are no good, start over and build it all at once
+	bool reset = CalculateDistanceLUT() || m_TreeLevel != m_MaxLevel;
+	if(reset)
+		ResetTree();
+
+	UpdateTree(true, reset);
+}
+
+void Triangulator::ResetTree() {
+	for(size_t i = 0; i < m_Faces.size(); i++) {
+		TriFace &face = m_Faces[i];
+		face.nodes.clear();
+		face.freeGroups.clear();
+		face.pendingFree.clear();
+
+		TriNode root;
+		root.a = m_Icosahedron[i].a;
+		root.b = m_Icosahedron[i].b;
+		root.c = m_Icosahedron[i].c;
+		root.evalPos = m_CameraObjectSpacePos;
+		face.nodes.push_back(root);
+	}
 
-	//Recursion start
 	m_Positions.clear();
+	m_SlotOwner.clear();
+	m_DirtySlots.clear();
+	m_TreeLevel = m_MaxLevel;
+}
 
-	for(auto t : m_Icosahedron) {
-		RecursiveTriangle(t.a, t.b, t.c, t.level, true);
+void Triangulator::UpdateTree(bool parallel, bool unlimited) {
+	//Faces are independent, each gets an equal share of the budget
+	uint32_t faces = (uint32_t)m_Faces.size();
+	uint32_t splitBudget = unlimited ? UINT32_MAX : (m_SplitBudget + faces - 1) / faces;
+	uint32_t mergeBudget = unlimited ? UINT32_MAX : (m_MergeBudget + faces - 1) / faces;
+	auto face = [&](size_t i) {
+		UpdateFace(m_Faces[i], splitBudget, mergeBudget);
+	};
+	if(parallel)
+		concurrency::parallel_for(size_t(0), m_Faces.size(), face);
+	else
+		for(size_t i = 0; i < m_Faces.size(); i++)
+			face(i);
+
+	//Instances go first so the slots they free can be filled
+	m_FrameSplits = 0;
+	m_FrameMerges = 0;
+	for(auto &face : m_Faces) {
+		for(auto node : face.hide) {
+			TriNode &n = face.nodes[node];
+			if(n.slot < 0) continue;
+			RemoveSlot(n.slot);
+			n.slot = -1;
+		}
+		m_FrameSplits += face.splits;
+		m_FrameMerges += face.merges;
+	}
+	for(uint32_t f = 0; f < faces; f++) {
+		TriFace &face = m_Faces[f];
+		for(auto node : face.show) {
+			TriNode &n = face.nodes[node];
+			if(n.slot >= 0) continue;
+			n.slot = (int32_t)m_Positions.size();
+			m_DirtySlots.push_back((uint32_t)n.slot);
+			m_Positions.emplace_back(n.level, n.a, n.b - n.a, n.c - n.a);
+			m_SlotOwner.push_back((uint64_t)f << 32 | node);
+		}
+		face.freeGroups.insert(face.freeGroups.end(), face.pendingFree.begin(), face.pendingFree.end());
+		face.pendingFree.clear();
 	}
+
+	//Slots past the end were moved away and don't need uploading
+	std::sort(m_DirtySlots.begin(), m_DirtySlots.end());
+	m_DirtySlots.erase(std::unique(m_DirtySlots.begin(), m_DirtySlots.end()), m_DirtySlots.end());
+	m_DirtySlots.erase(std::lower_bound(m_DirtySlots.begin(), m_DirtySlots.end(), (uint32_t)m_Positions.size()), m_DirtySlots.end());
 }
 
-TriNext Triangulator::SplitHeuristic(glm::vec3 &a, glm::vec3 &b, glm::vec3 &c, uint16_t level, bool frustumCull) {
-	auto camPosWorld = UniEngine::GetInstance().GetScene()->GetCameraComponent()->GetPosition();
-	glm::vec3 center = (a + b + c) / 3.f;
-	//Perform backface culling
-	float dotNV = glm::dot(glm::normalize(center), glm::normalize(center - m_CameraObjectSpacePos));
-	if(dotNV >= m_TriLevelDotLUT[level]) { // TODO: DotLUTS are wrong!!!
-		return TriNext::CULL;
+void Triangulator::RemoveSlot(int32_t slot) {
+	size_t last = m_Positions.size() - 1;
+	if((size_t)slot != last) {
+		m_Positions[slot] = m_Positions[last];
+		m_SlotOwner[slot] = m_SlotOwner[last];
+		uint64_t owner = m_SlotOwner[slot];
+		m_Faces[owner >> 32].nodes[owner & 0xffffffff].slot = slot;
+		m_DirtySlots.push_back((uint32_t)slot);
 	}
+	m_Positions.pop_back();
+	m_SlotOwner.pop_back();
+}
 
-	//Perform Frustum culling
-	//if(frustumCull) {
-	if(false){
-		auto intersect = m_pFrustum->ContainsTriVolume(a, b, c, m_HeightMultLUT[level]);
-		//auto intersect = m_pFrustum->ContainsTriangle(a, b, c);
-		if(intersect == VolumeCheck::OUTSIDE) return TriNext::CULL;
-		if(intersect == VolumeCheck::CONTAINS)//stop frustum culling -> all children are also inside the frustum
-		{
-			//check if new splits are allowed
-			if(level >= m_MaxLevel)return TriNext::LEAF;
-			//split according to distance
-			float aDist = glm::length(a - m_CameraObjectSpacePos);
-			float bDist = glm::length(b - m_CameraObjectSpacePos);
-			float cDist = glm::length(c - m_CameraObjectSpacePos);
-			if(std::fminf(aDist, std::fminf(bDist, cDist)) < m_DistanceLUT[level])return TriNext::SPLIT;
-			return TriNext::LEAF;
+void Triangulator::Benchmark(uint32_t minLevel, uint32_t maxLevel, uint32_t runs) {
+	using Clock = std::chrono::high_resolution_clock;
+	uint32_t savedLevel = m_MaxLevel;
+
+	for(uint32_t level = minLevel; level <= maxLevel; level++) {
+		m_MaxLevel = level;
+		Precalculate();
+		CalculateDotLUT();
+		CalculateDistanceLUT();
+
+		//Building from nothing, on one thread and on all of them
+		double ms[2];
+		for(int parallel = 0; parallel < 2; parallel++) {
+			double total = 0.0;
+			for(uint32_t run = 0; run < runs; run++) {
+				ResetTree();
+				auto start = Clock::now();
+				UpdateTree(parallel != 0, true);
+				total += std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+			}
+			ms[parallel] = total / runs;
 		}
+
+		//Nothing moved, which is what most frames are close to
+		auto start = Clock::now();
+		for(uint32_t run = 0; run < runs; run++)
+			UpdateTree(true, false);
+		double still = std::chrono::duration<double, std::milli>(Clock::now() - start).count() / runs;
+
+		std::cout << "Triangulator level " << level << ": " << m_Positions.size() << " patches, built in "
+			<< ms[0] << " ms on one thread, " << ms[1] << " ms parallel (" << ms[0] / ms[1] << "x), "
+			<< still << " ms per still frame" << std::endl;
 	}
+
+	m_MaxLevel = savedLevel;
+	Precalculate();
+	CalculateDotLUT();
+	GenerateGeometry();
+}
+
+TriNext Triangulator::Decide(const TriNode &node, float &slack) const {
+	//Horizon culling. Moving the camera by d turns its direction and the horizon by at most d / altitude between
+	//them while d < altitude / 2 (and by d / radius higher up), so half the angle left to the limit times the
+	//altitude is far enough that the answer can't change.
+	float dotNC = glm::dot(glm::normalize(node.a + node.b + node.c), m_CameraDirection);
+	float gap = fabsf(acosf(glm::clamp(dotNC, -1.f, 1.f)) - (m_Horizon + m_TriLevelAngleLUT[node.level]));
+	slack = 0.5f * std::min(gap, 1.f) * glm::clamp(m_CameraAltitude, 0.f, m_Radius);
+	if(dotNC < m_TriLevelDotLUT[node.level]) {
+		return TriNext::CULL;
+	}
+
 	//check if new splits are allowed
-	if(level >= m_MaxLevel)return TriNext::LEAF;
-	//split according to distance
-	float aDist = glm::length(a - m_CameraObjectSpacePos);
-	float bDist = glm::length(b - m_CameraObjectSpacePos);
-	float cDist = glm::length(c - m_CameraObjectSpacePos);
-	if(std::fminf(aDist, std::fminf(bDist, cDist)) < m_DistanceLUT[level])return TriNext::SPLITCULL;
+	if(node.level >= m_MaxLevel)return TriNext::LEAF;
+	//split according to distance, which moves no faster than the camera
+	float aDist = glm::length(node.a - m_CameraObjectSpacePos);
+	float bDist = glm::length(node.b - m_CameraObjectSpacePos);
+	float cDist = glm::length(node.c - m_CameraObjectSpacePos);
+	float dist = std::fminf(aDist, std::fminf(bDist, cDist));
+	slack = std::min(slack, fabsf(dist - m_DistanceLUT[node.level]));
+	if(dist < m_DistanceLUT[node.level])return TriNext::SPLIT;
 	return TriNext::LEAF;
 }
 
-void Triangulator::RecursiveTriangle(glm::vec3 a, glm::vec3 b, glm::vec3 c, uint16_t level, bool frustumCull) {
-	TriNext next = SplitHeuristic(a, b, c, level, frustumCull);
-	if(next == CULL) return;
-	//check if subdivision is needed based on camera distance
-	else if(next == SPLIT || next == SPLITCULL) {
-		//find midpoints
-		glm::vec3 A = b + ((c - b)*0.5f);
-		glm::vec3 B = c + ((a - c)*0.5f);
-		glm::vec3 C = a + ((b - a)*0.5f);
-		//make the distance from center larger according to planet radius
-		A = A * (float)m_pPlanet->GetRadius() / glm::length(A);
-		B = B * (float)m_pPlanet->GetRadius() / glm::length(B);
-		C = C * (float)m_pPlanet->GetRadius() / glm::length(C);
-		//Make 4 new triangles
-		uint16_t nLevel = level + 1;
-		RecursiveTriangle(a, C, B, nLevel, next == SPLITCULL);//Winding is inverted
-		RecursiveTriangle(A, C, b, nLevel, next == SPLITCULL);//Winding is inverted
-		RecursiveTriangle(A, c, B, nLevel, next == SPLITCULL);//Winding is inverted
-		RecursiveTriangle(A, B, C, nLevel, next == SPLITCULL);
-	} else //put the triangle in the buffer
-	{
-		m_Positions.emplace_back((uint16_t)level, a, b - a, c - a);
+void Triangulator::UpdateFace(TriFace &face, uint32_t splitBudget, uint32_t mergeBudget) const {
+	face.hide.clear();
+	face.show.clear();
+	face.splits = 0;
+	face.merges = 0;
+
+	face.stack.clear();
+	face.stack.push_back({ 0, true, false });
+
+	while(!face.stack.empty()) {
+		TriVisit v = face.stack.back();
+		face.stack.pop_back();
+		if(v.exit) {
+			FinishNode(face, v.node);
+			continue;
+		}
+
+		TriNode *n = &face.nodes[v.node];
+		//Children of a triangle that is fully inside skip the frustum test
+		VolumeCheck intersect = VolumeCheck::CONTAINS;
+		if(v.frustumCull)
+			intersect = m_pFrustum->ContainsTriVolume(n->a, n->b, n->c, m_HeightMultLUT[n->level]);
+
+		float moved = glm::length(m_CameraObjectSpacePos - n->evalPos);
+		if(intersect == VolumeCheck::OUTSIDE) {
+			HideNode(face, v.node);
+			//Off screen detail goes once its decision runs out, nothing splits until it is back in view
+			if(moved >= n->slack && n->children != TriNode::NoNode && face.merges < mergeBudget)
+				MergeNode(face, v.node);
+			continue;
+		}
+
+		//Same camera band, fully in view as before: nothing below can have changed
+		bool wasHidden = n->hidden || n->partHidden;
+		n->hidden = false;
+		if(moved < n->subtreeSlack && intersect == VolumeCheck::CONTAINS && !wasHidden)
+			continue;
+
+		TriNext next = n->state;
+		if(moved >= n->slack) {
+			next = Decide(*n, n->slack);
+			n->state = next;
+			n->evalPos = m_CameraObjectSpacePos;
+		}
+
+		if(next == TriNext::SPLIT && n->children == TriNode::NoNode) {
+			if(face.splits < splitBudget) {
+				SplitNode(face, v.node);
+			} else {
+				//try again next frame
+				n->slack = 0.f;
+			}
+		} else if(next != TriNext::SPLIT && n->children != TriNode::NoNode) {
+			if(face.merges < mergeBudget)
+				MergeNode(face, v.node);
+			else
+				n->slack = 0.f;
+		}
+
+		//splitting may have grown the pool
+		n = &face.nodes[v.node];
+		if(n->children != TriNode::NoNode) {
+			if(n->slot >= 0)
+				face.hide.push_back(v.node);
+			face.stack.push_back({ v.node, false, true });
+			for(uint32_t i = 4; i-- > 0;)
+				face.stack.push_back({ n->children + i, intersect != VolumeCheck::CONTAINS, false });
+		} else {
+			if(next == TriNext::CULL) {
+				if(n->slot >= 0)
+					face.hide.push_back(v.node);
+			} else if(n->slot < 0) {
+				face.show.push_back(v.node);
+			}
+			n->subtreeSlack = n->slack;
+			n->partHidden = false;
+		}
+	}
+}
+
+void Triangulator::SplitNode(TriFace &face, uint32_t node) const {
+	uint32_t group;
+	if(!face.freeGroups.empty()) {
+		group = face.freeGroups.back();
+		face.freeGroups.pop_back();
+	} else {
+		group = (uint32_t)face.nodes.size();
+		face.nodes.resize(face.nodes.size() + 4);
+	}
+
+	TriNode &n = face.nodes[node];
+	glm::vec3 a = n.a, b = n.b, c = n.c;
+	//find midpoints
+	glm::vec3 A = b + ((c - b)*0.5f);
+	glm::vec3 B = c + ((a - c)*0.5f);
+	glm::vec3 C = a + ((b - a)*0.5f);
+	//make the distance from center larger according to planet radius
+	A = A * m_Radius / glm::length(A);
+	B = B * m_Radius / glm::length(B);
+	C = C * m_Radius / glm::length(C);
+	//Make 4 new triangles
+	glm::vec3 corners[4][3] = {
+		{ a, C, B },//Winding is inverted
+		{ A, C, b },//Winding is inverted
+		{ A, c, B },//Winding is inverted
+		{ A, B, C }
+	};
+	for(uint32_t i = 0; i < 4; i++) {
+		TriNode child;
+		child.a = corners[i][0];
+		child.b = corners[i][1];
+		child.c = corners[i][2];
+		child.evalPos = m_CameraObjectSpacePos;
+		child.level = n.level + 1;
+		face.nodes[group + i] = child;
+	}
+	n.children = group;
+	face.splits++;
+}
+
+void Triangulator::MergeNode(TriFace &face, uint32_t node) const {
+	//Every instance below goes, every group below is freed
+	face.walk.clear();
+	face.walk.push_back(face.nodes[node].children);
+	while(!face.walk.empty()) {
+		uint32_t group = face.walk.back();
+		face.walk.pop_back();
+		face.pendingFree.push_back(group);
+		for(uint32_t i = group; i < group + 4; i++) {
+			const TriNode &child = face.nodes[i];
+			if(child.slot >= 0)
+				face.hide.push_back(i);
+			if(child.children != TriNode::NoNode)
+				face.walk.push_back(child.children);
+		}
+	}
+	face.nodes[node].children = TriNode::NoNode;
+	face.nodes[node].partHidden = false;
+	face.merges++;
+}
+
+void Triangulator::HideNode(TriFace &face, uint32_t node) const {
+	//Subtrees are hidden whole, one that already is can be skipped
+	face.walk.clear();
+	face.walk.push_back(node);
+	while(!face.walk.empty()) {
+		uint32_t index = face.walk.back();
+		face.walk.pop_back();
+		TriNode &n = face.nodes[index];
+		if(n.hidden)
+			continue;
+		n.hidden = true;
+		n.partHidden = false;
+		if(n.slot >= 0)
+			face.hide.push_back(index);
+		if(n.children != TriNode::NoNode)
+			for(uint32_t i = 0; i < 4; i++)
+				face.walk.push_back(n.children + i);
 	}
 }
 
+void Triangulator::FinishNode(TriFace &face, uint32_t node) const {
+	//A child's decisions hold while the camera is within its slack of its evalPos, which it is while within that
+	//less the distance between the two evalPos of this one's
+	TriNode &n = face.nodes[node];
+	float slack = n.slack;
+	bool partHidden = false;
+	for(uint32_t i = n.children; i < n.children + 4; i++) {
+		const TriNode &child = face.nodes[i];
+		slack = std::min(slack, child.subtreeSlack - glm::length(child.evalPos - n.evalPos));
+		partHidden |= child.hidden || child.partHidden;
+	}
+	n.subtreeSlack = slack;
+	n.partHidden = partHidden;
+}
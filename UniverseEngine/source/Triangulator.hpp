@@ -5,7 +5,7 @@
 #include <vector>
 #include "Patch.hpp"
 
-class UniFrustum;
+class Frustum;
 class UniBody;
 
 enum TriNext {
@@ -35,6 +35,57 @@ struct Tri {
 	glm::vec3 c;
 };
 
+//A triangle of the persistent subdivision, kept from frame to frame
+struct TriNode {
+	static const uint32_t NoNode = 0xffffffff;
+
+	glm::vec3 a;
+	glm::vec3 b;
+	glm::vec3 c;
+
+	//camera position the split decision was last made at, it holds while the camera stays within slack of it
+	glm::vec3 evalPos;
+	float slack = 0.f;
+	//the same for every decision in the subtree, measured from evalPos
+	float subtreeSlack = 0.f;
+
+	//first of four consecutive children in the face's pool
+	uint32_t children = NoNode;
+	//instance slot while drawn
+	int32_t slot = -1;
+	uint16_t level = 0;
+	TriNext state = LEAF;
+	//outside the frustum, nothing below is drawn
+	bool hidden = false;
+	//something below is outside the frustum
+	bool partHidden = false;
+};
+
+//A node waiting on the traversal stack, exit marks the second visit after its children
+struct TriVisit {
+	uint32_t node;
+	bool frustumCull;
+	bool exit;
+};
+
+//The subdivision of one root triangle, updated on its own thread
+struct TriFace {
+	std::vector<TriNode> nodes;
+	std::vector<uint32_t> freeGroups;
+	//groups merged away this frame, they can only be reused once their instances are gone
+	std::vector<uint32_t> pendingFree;
+
+	std::vector<TriVisit> stack;
+	std::vector<uint32_t> walk;
+
+	//nodes to lose or gain an instance
+	std::vector<uint32_t> hide;
+	std::vector<uint32_t> show;
+
+	uint32_t splits = 0;
+	uint32_t merges = 0;
+};
+
 class Triangulator {
 public:
 	Triangulator(UniBody* pPlanet);
@@ -44,36 +95,73 @@ public:
 	void Init();
 	bool Update();
 	void GenerateGeometry();
+	//Times a full build on one thread and on all of them, and an update with the camera standing still, for every max level in [minLevel, maxLevel], prints to std::cout
+	void Benchmark(uint32_t minLevel = 10, uint32_t maxLevel = 22, uint32_t runs = 10);
 
 	bool IsFrustumLocked() { return m_LockFrustum; }
-	UniFrustum* GetFrustum() { return m_pFrustum; }
+	Frustum* GetFrustum() { return m_pFrustum; }
 	uint32_t GetVertexCount() { return static_cast<uint32_t>(m_Positions.size()); }
 
+	//Splits and merges beyond these wait for the next frame
+	uint32_t m_SplitBudget = 1024;
+	uint32_t m_MergeBudget = 2048;
+
 private:
 	friend class UniBody;
 
 	void Precalculate();
-	TriNext SplitHeuristic(glm::vec3 &a, glm::vec3 &b, glm::vec3 &c, uint16_t level, bool frustumCull);
-	void RecursiveTriangle(glm::vec3 a, glm::vec3 b, glm::vec3 c, uint16_t level, bool frustumCull);
+	//true when the distances changed
+	bool CalculateDistanceLUT();
+	void CalculateDotLUT();
+	//Split decision from the horizon and camera distance, slack is how far the camera can move before it may change
+	TriNext Decide(const TriNode &node, float &slack) const;
+
+	void ResetTree();
+	//Updates every face, then moves the instance changes into m_Positions
+	void UpdateTree(bool parallel, bool unlimited);
+	void UpdateFace(TriFace &face, uint32_t splitBudget, uint32_t mergeBudget) const;
+	void SplitNode(TriFace &face, uint32_t node) const;
+	void MergeNode(TriFace &face, uint32_t node) const;
+	void HideNode(TriFace &face, uint32_t node) const;
+	void FinishNode(TriFace &face, uint32_t node) const;
+	void RemoveSlot(int32_t slot);
 
 	//Triangulation paramenters
 	float m_AllowedTriPx = 300.f;
 	uint32_t m_MaxLevel = 0;
+	//max level the tree was built for, the tree starts over when it or the distance LUT changes
+	uint32_t m_TreeLevel = 0;
 
 	std::vector<Tri> m_Icosahedron;
 	std::vector<float> m_DistanceLUT;
+	//Per level, how far a triangle's corners are from its centre plus how far past the horizon terrain can be seen (radians)
+	std::vector<float> m_TriLevelAngleLUT;
+	//Per level, triangles whose centre direction has a smaller dot with the camera direction are beyond the horizon
 	std::vector<float> m_TriLevelDotLUT;
 	std::vector<float> m_HeightMultLUT;
 
 	std::vector<Tri*> m_Leafs;
 
 	UniBody* m_pPlanet = nullptr;
-	UniFrustum* m_pFrustum = nullptr;
+	Frustum* m_pFrustum = nullptr;
 	bool m_LockFrustum = false;
 
-	glm::vec3 m_CameraObjectSpacePos;
+	//Cached once per frame in Update, the traversal reads nothing else that changes
+	glm::vec3 m_CameraObjectSpacePos = glm::vec3(0.f);
+	glm::vec3 m_CameraDirection = glm::vec3(0.f, 1.f, 0.f);
+	float m_Horizon = 0.f;
+	float m_CameraAltitude = 0.f;
+	float m_Radius = 0.f;
 
-	std::vector<PatchInstance> m_Positions;
-};
+	std::vector<TriFace> m_Faces;
 
+	//Instances of the drawn leaves, a leaf keeps its slot until it goes and the last slot moves into the gap
+	std::vector<PatchInstance> m_Positions;
+	//face << 32 | node for every slot
+	std::vector<uint64_t> m_SlotOwner;
+	//slots written since the last GenerateGeometry, sorted
+	std::vector<uint32_t> m_DirtySlots;
 
+	uint32_t m_FrameSplits = 0;
+	uint32_t m_FrameMerges = 0;
+};
@@ -84,7 +84,7 @@ void UniBody::Initialize() {
 void UniBody::Update() {
 	if(m_pTriangulator->Update()) {
 		m_pTriangulator->GenerateGeometry();
-		m_pPatch->BindInstances(m_pTriangulator->m_Positions);
+		m_pPatch->UpdateInstances(m_pTriangulator->m_Positions, m_pTriangulator->m_DirtySlots);
 		m_pPatch->UploadDistanceLUT(m_pTriangulator->m_DistanceLUT);
 		//std::cout << "Updated Triangulator." << std::endl;
 	}
@@ -17,6 +17,11 @@
 void UniEngine::Shutdown() {
   std::cout << "Shutting down..." << std::endl;
 
+  // uploads may still be writing into buffers the scenes are about to free
+  m_UploadManager.destroy();
+  vkDeviceWaitIdle(device);
+  m_UniformRing.destroy();
+
   GetSceneManager()->Shutdown();
   GetAudioManager()->Shutdown();
   GetAssetManager()->Shutdown();
@@ -87,6 +92,11 @@ void UniEngine::getEnabledFeatures() {
     }
   }
 
+  // Culled model batches are indirect draws starting at their own instance
+  if (deviceFeatures.drawIndirectFirstInstance) {
+    enabledFeatures.drawIndirectFirstInstance = VK_TRUE;
+  }
+
   if (deviceFeatures.tessellationShader) {
     enabledFeatures.tessellationShader = VK_TRUE;
   } else {
@@ -128,6 +138,14 @@ void UniEngine::prepare() {
   std::cout << "Initialize base engine..." << std::endl;
   VulkanExampleBase::prepare();
 
+  std::cout << "Create upload manager..." << std::endl;
+  m_UploadManager.create(vulkanDevice, queue, 32 * 1024 * 1024, &m_QueueMutex);
+
+  std::cout << "Create uniform ring..." << std::endl;
+  // A slice per swapchain image, each image's command buffer binds its own
+  m_UniformRing.create(vulkanDevice, 1024 * 1024,
+                       static_cast<uint32_t>(drawCmdBuffers.size()));
+
   std::cout << "Create an audio manager..." << std::endl;
   GetAudioManager()->Init();
 
@@ -251,13 +269,27 @@ void UniEngine::SetupOverlay()
 void UniEngine::draw() {
   VulkanExampleBase::prepareFrame();
 
+  // Waits for the last frame drawn into this image before writing its uniforms
+  m_UniformRing.beginFrame(currentBuffer);
+  GetSceneRenderer()->PushUniforms();
+
+  // The last frame has finished, so its command buffers can be recorded again
+  GetSceneRenderer()->UpdateCommandBuffers();
+
+  // Only now is it known which image's instances to write
+  GetSceneRenderer()->UpdateRenderQueue(currentBuffer);
+
   // Scene rendering
   // Submit work
 
   submitInfo.commandBufferCount = 1;
   submitInfo.pCommandBuffers = &drawCmdBuffers[currentBuffer];
 
-  VK_CHECK_RESULT(vkQueueSubmit(queue, 1, &submitInfo, VK_NULL_HANDLE));
+  // Import threads submit uploads to the same queue when there is no transfer
+  // queue, submitFrame presents and waits on it as well
+  std::lock_guard<std::mutex> guard(m_QueueMutex);
+  VK_CHECK_RESULT(
+      vkQueueSubmit(queue, 1, &submitInfo, m_UniformRing.fence()));
 
   VulkanExampleBase::submitFrame();
 }
@@ -277,9 +309,15 @@ void UniEngine::render() {
     GetSceneManager()->Tick(frameTimer);
   }
 
+  m_UploadManager.endFrame();
+
   if (GetSceneManager()->CheckNewScene()) {
     m_InputManager.reset();
     SetupInput();
+    // the new scene's systems start from their defaults
+    GetSceneManager()->CurrentScene()->m_World->setTickMode(
+        m_SerialSystemTick ? ECS::TickMode::Serial : ECS::TickMode::Parallel);
+    GetSceneManager()->EmitEvent<GravityModeEvent>({m_NBodyGravity});
   }
 }
 
@@ -288,6 +326,8 @@ void UniEngine::viewChanged() {
 }
 
 void UniEngine::windowResized() {
+  // the command buffers were recreated empty along with the swapchain
+  GetSceneRenderer()->MarkCommandBuffersDirty();
   GetSceneManager()->CurrentCamera()->aspect = (float)width / (float)height;
   GetSceneManager()->CurrentCamera()->CalculateProjection();
 }
@@ -301,6 +341,33 @@ void UniEngine::OnUpdateUIOverlay(vks::UIOverlay* overlay) {
       GetSceneManager()->EmitEvent<CameraPauseEvent>({m_CamPaused});
     }
 
+    if (overlay->checkBox("Serial system tick", &m_SerialSystemTick)) {
+      GetSceneManager()->CurrentScene()->m_World->setTickMode(
+          m_SerialSystemTick ? ECS::TickMode::Serial : ECS::TickMode::Parallel);
+    }
+
+    if (overlay->checkBox("N-body gravity", &m_NBodyGravity)) {
+      GetSceneManager()->EmitEvent<GravityModeEvent>({m_NBodyGravity});
+    }
+
+    auto uploads = m_UploadManager.frameStats();
+    overlay->text("Uploads: %.1f KB/frame, %u submits, %.2f ms stalled%s",
+                  uploads.bytes / 1024.0, uploads.submits, uploads.stallMs,
+                  m_UploadManager.usesTransferQueue() ? " (transfer queue)" : "");
+
+    auto renderer = GetSceneRenderer();
+    auto& queue = renderer->GetRenderQueue();
+    auto& recorded = renderer->GetRecordStats();
+    overlay->text("Models: %u meshes in %u draws on %u threads, %u pipeline "
+                  "and %u material binds",
+                  queue.ItemCount(), recorded.draws,
+                  renderer->GetRecordThreads(), recorded.pipelineBinds,
+                  recorded.materialBinds);
+    auto& visibility = renderer->GetVisibilityStats();
+    overlay->text("Instances: %u of %u drawn, %u out of view, %u too small",
+                  visibility.visible, visibility.tested,
+                  visibility.frustumCulled, visibility.sizeCulled);
+
     GetSceneManager()
         ->CurrentScene()
         ->m_World
@@ -398,16 +465,27 @@ void UniEngine::OnUpdateUserUIOverlay(vks::UIOverlay* overlay) {
   for (const auto& so : GetSceneManager()->CurrentScene()->m_SceneObjects) {
     if (so->GetComponent<Planet>()) {
       if (overlay->header(so->GetName().c_str())) {
-        auto camPos = GetSceneManager()
+        auto camWorldPos = GetSceneManager()
                           ->CurrentScene()
                           ->GetCameraObject()
                           ->GetTransform()
-                          ->GetPosition();
+                          ->GetWorldPosition();
         auto transform = so->GetComponent<TransformComponent>();
-        camPos = transform->TransformWSToLocal(camPos);
+        auto camPos = glm::vec3(transform->GetInverseModelMatDouble() * glm::dvec4(camWorldPos, 1.0));
         auto altitude = so->GetComponent<Planet>()->GetAltitude(camPos);
         overlay->text("Alt: %.3f km", altitude / 1000.0);
         overlay->text("Dist: %.3f km", glm::length(camPos) / 1000.0);
+
+        if (auto query = so->GetComponent<Planet>()->GetHeightQuery()) {
+          auto frame = query->FrameStats();
+          auto total = query->TotalStats();
+          overlay->text("Height tiles: %u (%.1f MB), %.1f%% hits",
+                        frame.tiles, frame.bytes / (1024.0 * 1024.0),
+                        total.HitRate() * 100.0);
+          overlay->text("Height queries: %llu/frame, %u bakes %.2f ms",
+                        (unsigned long long)frame.queries, frame.bakes,
+                        frame.bakeMs);
+        }
       }
     }
   }
@@ -12,6 +12,8 @@
 #include "vks/VulkanBuffer.hpp"
 #include "vks/VulkanModel.hpp"
 #include "vks/VulkanTexture.hpp"
+#include "vks/VulkanUploadManager.hpp"
+#include "vks/VulkanUniformRing.hpp"
 #include "vks/vulkanexamplebase.h"
 #include <mutex>
 
@@ -70,6 +72,10 @@ class UniEngine final : public VulkanExampleBase {
   VkDevice GetDevice() { return device; }
   VkQueue GetQueue() { return queue; }
   VkPipelineCache GetPipelineCache() { return pipelineCache; }
+  /** @brief batched buffer and texture uploads, on the transfer queue when there is one */
+  vks::UploadManager& GetUploadManager() { return m_UploadManager; }
+  /** @brief per-frame uniform memory, blocks pushed here are bound with dynamic offsets */
+  vks::UniformRing& GetUniformRing() { return m_UniformRing; }
   void Shutdown();
   bool m_debugDisplay = false;
   bool m_useWireframe = false;
@@ -82,8 +88,13 @@ class UniEngine final : public VulkanExampleBase {
   std::shared_ptr<uni::assets::AssetManager> m_AssetManager;
 
   bool m_CamPaused = false;
+  bool m_SerialSystemTick = false;
+  bool m_NBodyGravity = false;
   float m_PlanetZOffset = 0;
 
+  vks::UploadManager m_UploadManager;
+  vks::UniformRing m_UniformRing;
+
 
  public:
   std::shared_ptr<uni::scene::SceneManager> GetSceneManager(){ return m_SceneManager; }
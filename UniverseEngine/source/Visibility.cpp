@@ -0,0 +1,65 @@
+#include "Visibility.h"
+#include <algorithm>
+#include <limits>
+#include "Frustum.hpp"
+#include "ModelMesh.h"
+
+using namespace uni::render;
+
+void Visibility::Clear() {
+  m_X.clear();
+  m_Y.clear();
+  m_Z.clear();
+  m_Radius.clear();
+}
+
+uint32_t Visibility::Add(const uni::Model& model, const glm::mat4& transform) {
+  auto& dim = model.dim;
+  // Models filled in by hand never set their bounds, never cull them
+  if (dim.min.x > dim.max.x)
+    return Add(glm::vec3(transform[3]),
+               std::numeric_limits<float>::infinity());
+
+  glm::vec3 center = transform * glm::vec4((dim.min + dim.max) * 0.5f, 1.f);
+  float scale = std::max({glm::length(glm::vec3(transform[0])),
+                          glm::length(glm::vec3(transform[1])),
+                          glm::length(glm::vec3(transform[2]))});
+  return Add(center, glm::length(dim.max - dim.min) * 0.5f * scale);
+}
+
+uint32_t Visibility::Add(const glm::vec3& center, float radius) {
+  m_X.push_back(center.x);
+  m_Y.push_back(center.y);
+  m_Z.push_back(center.z);
+  m_Radius.push_back(radius);
+  return static_cast<uint32_t>(m_Radius.size() - 1);
+}
+
+void Visibility::Cull(const Frustum& frustum, float pixelScale,
+                      float minPixels) {
+  auto count = static_cast<uint32_t>(m_Radius.size());
+  m_Visible.resize(count);
+  m_Stats = VisibilityStats();
+  m_Stats.tested = count;
+
+  frustum.ContainsSpheres(m_X.data(), m_Y.data(), m_Z.data(), m_Radius.data(),
+                          count, m_Visible.data());
+
+  // radius * pixelScale / distance < minPixels, squared to skip the root
+  float scale = pixelScale * pixelScale;
+  float threshold = minPixels * minPixels;
+  for (uint32_t i = 0; i < count; i++) {
+    if (!m_Visible[i]) {
+      m_Stats.frustumCulled++;
+      continue;
+    }
+    float distance2 = m_X[i] * m_X[i] + m_Y[i] * m_Y[i] + m_Z[i] * m_Z[i];
+    float radius2 = m_Radius[i] * m_Radius[i];
+    if (radius2 * scale < threshold * distance2) {
+      m_Visible[i] = 0;
+      m_Stats.sizeCulled++;
+      continue;
+    }
+    m_Stats.visible++;
+  }
+}
@@ -0,0 +1,56 @@
+#pragma once
+
+#include <stdint.h>
+#include <vector>
+#include "3dmaths.h"
+
+class Frustum;
+
+namespace uni
+{
+	struct Model;
+
+	namespace render
+	{
+		/** @brief How many bounds the last Cull tested and why the rest were dropped */
+		struct VisibilityStats {
+			uint32_t tested = 0;
+			uint32_t visible = 0;
+			uint32_t frustumCulled = 0;
+			uint32_t sizeCulled = 0;
+		};
+
+		/**
+		* @brief Frustum and distance culling of bounding spheres on the CPU
+		*
+		* Add one sphere per object each frame in camera relative space, then Cull tests them all against the frustum
+		* planes four at a time and drops whatever is too far away to cover minPixels on screen. The spheres are kept as
+		* separate x, y, z and radius arrays so the plane tests load them straight into SIMD registers.
+		*/
+		class Visibility {
+		public:
+			void Clear();
+			/** @brief Sphere around a model's bounds moved by a camera relative model matrix, returns its index */
+			uint32_t Add(const uni::Model& model, const glm::mat4& transform);
+			uint32_t Add(const glm::vec3& center, float radius);
+
+			/**
+			* Decide what of the added spheres can be seen
+			*
+			* @param frustum Planes in the same camera relative space as the spheres
+			* @param pixelScale Screen pixels covered by a radius of one at a distance of one (projection[1][1] * height / 2)
+			* @param minPixels Spheres with a smaller radius on screen are culled, zero keeps them all
+			*/
+			void Cull(const Frustum& frustum, float pixelScale, float minPixels);
+
+			/** @brief 1 for every visible sphere in the order they were added */
+			const std::vector<uint8_t>& Visible() const { return m_Visible; }
+			const VisibilityStats& Stats() const { return m_Stats; }
+
+		private:
+			std::vector<float> m_X, m_Y, m_Z, m_Radius;
+			std::vector<uint8_t> m_Visible;
+			VisibilityStats m_Stats;
+		};
+	}
+}
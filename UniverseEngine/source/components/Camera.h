@@ -16,9 +16,12 @@ namespace uni {
       float aspect = 1.777778f;
 
       glm::vec3 m_Position = glm::vec3(0);
+      glm::dvec3 m_WorldPosition = glm::dvec3(0.0);
 
       glm::vec3 target;
 
+      // The view matrix only rotates: rendering happens in camera relative space, with everything moved by
+      // RelativeToCamera in double precision first, so float is only ever asked to hold nearby positions.
       struct {
         glm::mat4 projection = glm::identity<glm::mat4>();
         glm::mat4 view = glm::identity<glm::mat4>();
@@ -52,18 +55,22 @@ namespace uni {
       void UpdateTarget(glm::vec3 t) { target = t; }
 
       void CalculateView(ECS::ComponentHandle<TransformComponent> transform) {
-        auto mat = transform->GetModelMat();
+        auto mat = transform->GetModelMatDouble();
 
-        m_Position = { mat[3].x, mat[3].y, mat[3].z };
-        auto forward = m_Position + transform->TransformLocalDirectionToWorldSpace(glm::vec3(0.0, 0.0, 1.0));
+        m_WorldPosition = glm::dvec3(mat[3]);
+        m_Position = glm::vec3(m_WorldPosition);
+        auto forward = transform->TransformLocalDirectionToWorldSpace(glm::vec3(0.0, 0.0, 1.0));
         //forward = glm::normalize(forward);
         auto up = glm::mat3(mat) * glm::vec3(0.0, 1.0, 0.0);
         //up = glm::normalize(up);
 
         if (cameraType == CameraType::CAMERA_FIXED) {
-          target = forward;
+          target = m_Position + forward;
         }
-        matrices.view = glm::lookAt(m_Position, target, up);
+        else {
+          forward = RelativeToCamera(glm::dvec3(target));
+        }
+        matrices.view = glm::lookAt(glm::vec3(0.f), forward, up);
 
         //std::cout << "Camera view matrix: " << glm::to_string<glm::mat4>(matrices.view) << std::endl;
 
@@ -85,6 +92,17 @@ namespace uni {
       }
 
       glm::vec3 GetPosition() { return m_Position; }
+      glm::dvec3 GetWorldPosition() { return m_WorldPosition; }
+
+      /** @brief world space position moved into camera relative render space */
+      glm::vec3 RelativeToCamera(const glm::dvec3& worldPos) { return worldPos - m_WorldPosition; }
+
+      /** @brief model matrix moved into camera relative render space, the translation is subtracted before narrowing */
+      glm::mat4 RelativeToCamera(const glm::dmat4& modelMat) {
+        glm::dmat4 mat = modelMat;
+        mat[3] = glm::dvec4(glm::dvec3(mat[3]) - m_WorldPosition, mat[3].w);
+        return mat;
+      }
     };
   }
 }
@@ -7,7 +7,15 @@ void PhysicsComponent::AddForce(glm::dvec3 force) {
 }
 
 void PhysicsComponent::AddForceAt(glm::dvec3 force, glm::dvec3 pos) {
-	m_Velocity += force / m_Mass;
+	m_Acceleration += force / m_Mass;
+}
+
+void PhysicsComponent::AddAcceleration(const glm::dvec3& acceleration) {
+	m_Acceleration += acceleration;
+}
+
+void PhysicsComponent::AddAngularAcceleration(const glm::dvec3& angular) {
+	m_AngularAcceleration += angular;
 }
 
 void PhysicsComponent::AddAngularVelocity(const glm::vec3 &angular) {
@@ -40,18 +40,43 @@ namespace uni
       glm::dvec3 m_Velocity = glm::dvec3(0.0); // in world space
       glm::dvec3 m_AngularVelocity = glm::dvec3(0.0);
 
+      // Rates gathered since the last physics tick. PhysicsSystem applies them over every fixed step it takes, then
+      // clears them, so systems add what acts on the body now without scaling by their frame's deltaTime.
+      glm::dvec3 m_Acceleration = glm::dvec3(0.0); // in world space, m/s^2
+      glm::dvec3 m_AngularAcceleration = glm::dvec3(0.0); // in the body's frame, rad/s^2
+
       glm::dvec3 m_CentreOfMass = glm::dvec3(0);
       double m_Radius = 0.0;
 
       double m_Drag = 0.0;
       double m_AngularDrag = 0.0;
 
+      // Fixed step state owned by PhysicsSystem. The transform shows a blend of the previous and current pose, so
+      // if it no longer matches what was presented, something else moved the body and the simulation resyncs.
+      glm::dvec3 m_Position = glm::dvec3(0.0);
+      glm::dvec3 m_PreviousPosition = glm::dvec3(0.0);
+      glm::dquat m_Orientation = glm::dquat(1.0, 0.0, 0.0, 0.0);
+      glm::dquat m_PreviousOrientation = glm::dquat(1.0, 0.0, 0.0, 0.0);
+      glm::dvec3 m_PresentedPosition = glm::dvec3(0.0);
+      glm::quat m_PresentedRotation = glm::quat(1.f, 0.f, 0.f, 0.f);
+      bool m_HasSimulationState = false;
+      uint32_t m_BodyIndex = 0;
+
+      /** @brief Continuous force in newtons, acting until the next physics tick */
       void AddForce(glm::dvec3 force);
       void AddForceAt(glm::dvec3 force, glm::dvec3 pos);
+      /** @brief Continuous acceleration in m/s^2 whatever the mass, e.g. gravity */
+      void AddAcceleration(const glm::dvec3& acceleration);
+      void AddAngularAcceleration(const glm::dvec3& angular);
+      /** @brief Immediate change of angular velocity, not scaled by any timestep */
       void AddAngularVelocity(const glm::vec3 & angular);
-      void FullStop() { m_Velocity = glm::dvec3(0); m_AngularVelocity = glm::dvec3(0); }
+      void FullStop() {
+        m_Velocity = glm::dvec3(0); m_AngularVelocity = glm::dvec3(0);
+        m_Acceleration = glm::dvec3(0); m_AngularAcceleration = glm::dvec3(0);
+      }
       void SetSceneObject(std::shared_ptr<uni::scene::SceneObject> so) { m_SceneObject = so; }
     };
   }
 }
 
+ECS_PACKED_COMPONENT(uni::components::PhysicsComponent);
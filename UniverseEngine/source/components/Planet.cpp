@@ -2,7 +2,6 @@
 #include <assert.h>
 #include <math.h>
 #include <iostream>
-#include "../FastNoise.h"
 #include "../UniEngine.h"
 #include "../Scene.h"
 #include "../SceneManager.h"
@@ -54,11 +53,14 @@ void Planet::Initialize() {
   UpdateBuffers();
 
   auto modelMat = glm::mat4(1.0);
-  UpdateUniformBuffers(modelMat);
+  UpdateUniformBuffers(modelMat, m_CurrentCameraPos);
 
   MakeContintentTexture();
   MakeRampTexture();
 
+  m_HeightQuery = std::make_shared<uni::planet::HeightQuery>(
+      m_ContinentMap, (float)m_Radius, (float)m_MaxHeightOffset);
+
   std::cout << "Created planet grid with " << m_GridPoints.size()
             << " points and " << m_Indices.size() / 4 << " quads." << std::endl;
 }
@@ -161,6 +163,10 @@ double Planet::GetPositionOffset(glm::vec3& pos) {
 }
 
 void Planet::UpdateMesh() {
+  // The shaders place the static grid themselves
+  if (m_StaticGrid)
+    return;
+
   m_MeshVerts.clear();
   m_OceanVerts.clear();
   auto zs = CalculateZOffset();
@@ -195,96 +201,40 @@ void Planet::UpdateMesh() {
 }
 
 void Planet::UpdateBuffers() {
+  // A static grid is the same every frame, after the first upload there is
+  // nothing left to send
+  if (m_StaticGrid && m_IndicesUploaded)
+    return;
+
+  const auto& vertices = m_StaticGrid ? m_GridPoints : m_MeshVerts;
+  const auto& oceanVertices = m_StaticGrid ? m_GridPoints : m_OceanVerts;
+
   m_IndexCount = static_cast<uint32_t>(m_Indices.size());
-  m_VertexCount = static_cast<uint32_t>(m_MeshVerts.size());
-  m_OceanVertexCount = static_cast<uint32_t>(m_OceanVerts.size());
+  m_VertexCount = static_cast<uint32_t>(vertices.size());
+  m_OceanVertexCount = m_HasOcean ? static_cast<uint32_t>(oceanVertices.size()) : 0;
   m_OceanIndexCount = static_cast<uint32_t>(m_OceanIndices.size());
 
   m_Material->SetIndexCount(m_IndexCount);
   m_Material->SetOceanIndexCount(m_OceanIndexCount);
 
-  uint32_t vertexBufferSize =
-      static_cast<uint32_t>(m_MeshVerts.size() * sizeof(glm::vec3));
-  uint32_t indexBufferSize =
-      static_cast<uint32_t>(m_Indices.size() * sizeof(uint32_t));
-
-  vks::Buffer vertexStaging, indexStaging, oceanVertexStaging,
-      oceanIndexStaging;
-
-  auto device = UniEngine::GetInstance()->vulkanDevice;
-
-  // Vertex buffer
-  VK_CHECK_RESULT(device->createBuffer(VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
-                                       VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT |
-                                           VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
-                                       &vertexStaging, vertexBufferSize,
-                                       m_MeshVerts.data()));
-
-  // Index buffer
-  VK_CHECK_RESULT(device->createBuffer(VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
-                                       VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT |
-                                           VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
-                                       &indexStaging, indexBufferSize,
-                                       m_Indices.data()));
-
-  // Copy from staging buffers
-  VkCommandBuffer copyCmd =
-      device->createCommandBuffer(VK_COMMAND_BUFFER_LEVEL_PRIMARY, true);
-
-  VkBufferCopy copyRegion{};
-
-  copyRegion.size = m_VertexBuffer.size;
-  vkCmdCopyBuffer(copyCmd, vertexStaging.buffer, m_VertexBuffer.buffer, 1,
-                  &copyRegion);
+  auto& uploads = UniEngine::GetInstance()->GetUploadManager();
 
-  copyRegion.size = m_IndexBuffer.size;
-  vkCmdCopyBuffer(copyCmd, indexStaging.buffer, m_IndexBuffer.buffer, 1,
-                  &copyRegion);
+  uploads.copy(vertices.data(), vertices.size() * sizeof(glm::vec3), m_VertexBuffer.buffer);
+  if (m_HasOcean)
+    uploads.copy(oceanVertices.data(), oceanVertices.size() * sizeof(glm::vec3), m_OceanVertexBuffer.buffer);
 
-  if (m_HasOcean) {
-    uint32_t oceanVertexBufferSize =
-        static_cast<uint32_t>(m_OceanVerts.size() * sizeof(glm::vec3));
-    // Vertex buffer
-    VK_CHECK_RESULT(device->createBuffer(
-        VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
-        VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT |
-            VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
-        &oceanVertexStaging, oceanVertexBufferSize, m_OceanVerts.data()));
-
-    copyRegion.size = m_OceanVertexBuffer.size;
-    vkCmdCopyBuffer(copyCmd, oceanVertexStaging.buffer,
-                    m_OceanVertexBuffer.buffer, 1, &copyRegion);
-
-    uint32_t oceanIndexBufferSize =
-        static_cast<uint32_t>(m_OceanIndices.size() * sizeof(uint32_t));
-    // Index buffer
-    VK_CHECK_RESULT(device->createBuffer(
-        VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
-        VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT |
-            VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
-        &oceanIndexStaging, oceanIndexBufferSize, m_OceanIndices.data()));
-
-    copyRegion.size = m_OceanIndexBuffer.size;
-    vkCmdCopyBuffer(copyCmd, oceanIndexStaging.buffer,
-                    m_OceanIndexBuffer.buffer, 1, &copyRegion);
+  // The grid topology never changes, indices only need to go up once.
+  if (!m_IndicesUploaded) {
+    uploads.copy(m_Indices.data(), m_Indices.size() * sizeof(uint32_t), m_IndexBuffer.buffer);
+    if (m_HasOcean)
+      uploads.copy(m_OceanIndices.data(), m_OceanIndices.size() * sizeof(uint32_t), m_OceanIndexBuffer.buffer);
+    m_IndicesUploaded = true;
   }
 
-  device->flushCommandBuffer(copyCmd, UniEngine::GetInstance()->GetQueue());
-
-  // Destroy staging resources
-  vkDestroyBuffer(device->logicalDevice, vertexStaging.buffer, nullptr);
-  vkFreeMemory(device->logicalDevice, vertexStaging.memory, nullptr);
-  vkDestroyBuffer(device->logicalDevice, indexStaging.buffer, nullptr);
-  vkFreeMemory(device->logicalDevice, indexStaging.memory, nullptr);
-  if (m_HasOcean) {
-    vkDestroyBuffer(device->logicalDevice, oceanVertexStaging.buffer, nullptr);
-    vkFreeMemory(device->logicalDevice, oceanVertexStaging.memory, nullptr);
-    vkDestroyBuffer(device->logicalDevice, oceanIndexStaging.buffer, nullptr);
-    vkFreeMemory(device->logicalDevice, oceanIndexStaging.memory, nullptr);
-  }
+  uploads.submit();
 }
 
-void Planet::UpdateUniformBuffers(glm::mat4& modelMat) {
+void Planet::UpdateUniformBuffers(const glm::mat4& modelMat, const glm::vec3& cameraPos) {
   auto engine = UniEngine::GetInstance();
   auto camera = engine->GetSceneManager()->CurrentScene()->GetCameraComponent();
 
@@ -294,8 +244,8 @@ void Planet::UpdateUniformBuffers(glm::mat4& modelMat) {
   m_UniformBufferData.projMat = camera->matrices.projection;
 
   ////Set other uniforms here too!
-  auto camPos =
-      glm::vec3(glm::inverse(modelMat) * glm::vec4(camera->GetPosition(), 1.f));
+  // worked out in double by the caller, inverting the float camera relative matrix would lose it at planet scale
+  auto camPos = cameraPos;
   m_UniformBufferData.camPos = glm::vec4(camPos, 1.0);
   m_UniformBufferData.radius = (float)m_Radius;
   m_UniformBufferData.maxHeight = (float)m_MaxHeightOffset;
@@ -316,65 +266,36 @@ void Planet::UpdateUniformBuffers(glm::mat4& modelMat) {
 
   m_UniformBufferData.hasOcean = m_HasOcean;
 
-  vks::Buffer uniformStaging;
-  auto device = UniEngine::GetInstance()->vulkanDevice;
-
-  // Vertex buffer
-  VK_CHECK_RESULT(device->createBuffer(
-      VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
-      VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT |
-          VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
-      &uniformStaging, static_cast<uint32_t>(sizeof(UniformBufferData)),
-      &m_UniformBufferData));
-
-  // Copy from staging buffers
-  VkCommandBuffer copyCmd =
-      device->createCommandBuffer(VK_COMMAND_BUFFER_LEVEL_PRIMARY, true);
-
-  VkBufferCopy copyRegion{};
-
-  copyRegion.size = static_cast<uint32_t>(sizeof(UniformBufferData));
-  vkCmdCopyBuffer(copyCmd, uniformStaging.buffer, m_UniformBuffer.buffer, 1,
-                  &copyRegion);
-
-  device->flushCommandBuffer(copyCmd, UniEngine::GetInstance()->GetQueue());
+  // What UpdateMesh does per vertex, done once here and applied in the vertex
+  // shaders: the row vector times lookAt there is the transpose here
+  if (m_StaticGrid) {
+    auto rot = glm::lookAt({0, 0, 0}, m_CurrentCameraPos, {0, 1, 0});
+    m_UniformBufferData.gridRotation = glm::transpose(rot);
+    m_UniformBufferData.gridOffset =
+        glm::vec4((float)CalculateZOffset(),
+                  m_HasOcean ? (float)CalculateOceanZOffset() : 0.f, 0.f, 0.f);
+  } else {
+    m_UniformBufferData.gridRotation = glm::mat4(1.f);
+    m_UniformBufferData.gridOffset = glm::vec4(0.f);
+  }
+}
 
-  // Destroy staging resources
-  vkDestroyBuffer(device->logicalDevice, uniformStaging.buffer, nullptr);
-  vkFreeMemory(device->logicalDevice, uniformStaging.memory, nullptr);
+void Planet::PushUniforms() {
+  // written straight into mapped memory, nothing to submit or wait for
+  m_Material->SetDynamicUniformOffset(
+      UniEngine::GetInstance()->GetUniformRing().push(
+          &m_UniformBufferData, sizeof(UniformBufferData)));
 }
 
-// TODO: Fixme for pn-patch interpolation causing offset problems where shader
-// != cpp
 float Planet::GetAltitude(glm::vec3& point) {
-  // std::cout << "Input pos: " << point.x << ", " << point.y << ", " <<
-  // point.z;
-
-  auto p = glm::normalize(point);
-
-  float u = glm::atan(p.z, p.x) / (2 * 3.1415926f) + 0.5f;
-  float v = p.y * 0.5f + 0.5f;
-
-  uint32_t x = (uint32_t)round(u * 1024.f);
-  uint32_t y = (uint32_t)round(v * 1024.f);
-
-  x = x % 1024;
-  y = y % 1024;
-
-  auto n = m_ContinentData[y * 1024 + x];
-
-  // std::cout << ". Lookup offset data: " << x << ", " << y << " = " << n;
-
-  n = std::clamp(n, 0.5f, 1.f);
-
-  auto height =
-      (float)m_Radius + float(m_Radius) * (float)m_MaxHeightOffset * n;
-
-  // std::cout << ", height: " << height << std::endl;
-
-  auto altitude = glm::length(point) - (float)height;
+  return GetTerrain().Altitude(point);
+}
 
-  return altitude;
+uni::planet::TerrainSampler Planet::GetTerrain() const {
+  static const uni::planet::ContinentMap noContinents;
+  return uni::planet::TerrainSampler(
+      m_ContinentMap ? *m_ContinentMap : noContinents, (float)m_Radius,
+      (float)m_MaxHeightOffset);
 }
 
 void Planet::SetZOffset(float value) {
@@ -382,15 +303,14 @@ void Planet::SetZOffset(float value) {
 }
 
 void Planet::CreateBuffers() {
+  // Both meshes have a vertex per grid point, whichever way they are placed
   uint32_t vertexBufferSize =
-      static_cast<uint32_t>(m_MeshVerts.size() * sizeof(glm::vec3));
-  uint32_t oceanVertexBufferSize =
-      static_cast<uint32_t>(m_OceanVerts.size() * sizeof(glm::vec3));
+      static_cast<uint32_t>(m_GridPoints.size() * sizeof(glm::vec3));
+  uint32_t oceanVertexBufferSize = vertexBufferSize;
   uint32_t indexBufferSize =
       static_cast<uint32_t>(m_Indices.size() * sizeof(uint32_t));
   uint32_t oceanIndexBufferSize =
       static_cast<uint32_t>(m_OceanIndices.size() * sizeof(uint32_t));
-  uint32_t ubSize = static_cast<uint32_t>(sizeof(Planet::UniformBufferData));
   uint32_t storageBufferSize =
       static_cast<uint32_t>(m_NoiseLayers.size() * sizeof(NoiseLayerData));
 
@@ -422,19 +342,16 @@ void Planet::CreateBuffers() {
       VK_BUFFER_USAGE_INDEX_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT,
       VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, &m_IndexBuffer, indexBufferSize));
 
-  // uniform buffer
-  VK_CHECK_RESULT(device->createBuffer(
-      VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT,
-      VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, &m_UniformBuffer, ubSize));
-
   // storage buffer
   VK_CHECK_RESULT(device->createBuffer(
       VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT,
       VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, &m_StorageBuffer,
       storageBufferSize));
 
-  m_Material->SetBuffer("uniform",
-                        std::make_shared<vks::Buffer>(m_UniformBuffer));
+  // UniformBufferData comes from the engine's uniform ring, at binding 8
+  m_Material->SetDynamicUniform(
+      UniEngine::GetInstance()->GetUniformRing().descriptor(
+          sizeof(UniformBufferData)));
   m_Material->SetBuffer("noiselayers",
                         std::make_shared<vks::Buffer>(m_StorageBuffer));
   m_Material->SetBuffer("vertex",
@@ -449,45 +366,34 @@ void Planet::CreateBuffers() {
 }
 
 void Planet::DestroyBuffers() {
+  // don't free anything a pending upload still writes to
+  UniEngine::GetInstance()->GetUploadManager().wait();
+
   m_IndexBuffer.destroy();
   m_VertexBuffer.destroy();
   if (m_HasOcean) {
     m_OceanVertexBuffer.destroy();
     m_OceanIndexBuffer.destroy();
   }
-  m_UniformBuffer.destroy();
 }
 
 void Planet::MakeContintentTexture() {
-  FastNoise noise;
-  noise.SetNoiseType(FastNoise::SimplexFractal);
-  noise.SetFractalOctaves(3);
-
   auto engine = UniEngine::GetInstance();
 
-  std::vector<glm::vec4> buffer;
-
-  glm::vec3 noiseOffset = {2, 2, 2};
-  float noiseScale = 120.3587f;
-
-  for (float lat = -90.f; lat < 90.f; lat += 180.f / 1024) {
-    for (float lon = 0; lon < 360.f; lon += 360.f / 1024) {
-      auto x = cos(glm::radians(lat)) * cos(glm::radians(lon));
-      auto y = cos(glm::radians(lat)) * sin(glm::radians(lon));
-      auto z = sin(glm::radians(lat));
+  // Only depends on the continent settings, so it's baked once and read back
+  // from the cache on later launches
+  m_ContinentMap = std::make_shared<const uni::planet::ContinentMap>(
+      uni::planet::LoadOrBakeContinentMap(
+          m_ContinentParams, engine->getAssetPath() + "cache/planets"));
 
-      auto nv = (glm::normalize(glm::vec3(x, y, z)) + noiseOffset) * noiseScale;
-
-      float n = noise.GetNoise(nv.x, nv.y, nv.z) / 2.f + 0.5f;
-      m_ContinentData.push_back(n);
-      buffer.emplace_back(n, n, n, 0);
-    }
-  }
+  // The shaders only read the red channel, one channel is all that goes up
+  auto format = uni::planet::ContinentTextureFormat(engine->vulkanDevice->physicalDevice);
+  auto texels = uni::planet::ContinentTextureData(*m_ContinentMap, format);
 
   m_ContinentTexture.fromBuffer(
-      buffer.data(), buffer.size() * sizeof(glm::vec4),
-      VK_FORMAT_R32G32B32A32_SFLOAT, 1024, 1024, engine->vulkanDevice,
-      engine->GetQueue(), VK_FILTER_LINEAR);
+      texels.data(), texels.size(), format, m_ContinentMap->size,
+      m_ContinentMap->size, engine->vulkanDevice, engine->GetQueue(),
+      VK_FILTER_LINEAR);
 
   auto t = std::make_shared<vks::Texture>(m_ContinentTexture);
 
@@ -495,38 +401,11 @@ void Planet::MakeContintentTexture() {
 }
 
 void Planet::UpdateStorageBuffer() {
-  auto engine = UniEngine::GetInstance();
-
-  vks::Buffer storageStaging;
-  auto device = engine->vulkanDevice;
-
   m_Material->SetNoiseLayerCount(static_cast<uint32_t>(m_NoiseLayers.size()));
 
-  // Vertex buffer
-  VK_CHECK_RESULT(device->createBuffer(
-      VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
-      VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT |
-          VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
-      &storageStaging,
-      static_cast<uint32_t>(m_NoiseLayers.size() * sizeof(NoiseLayerData)),
-      m_NoiseLayers.data()));
-
-  // Copy from staging buffers
-  VkCommandBuffer copyCmd =
-      device->createCommandBuffer(VK_COMMAND_BUFFER_LEVEL_PRIMARY, true);
-
-  VkBufferCopy copyRegion{};
-
-  copyRegion.size =
-      static_cast<uint32_t>(m_NoiseLayers.size() * sizeof(NoiseLayerData));
-  vkCmdCopyBuffer(copyCmd, storageStaging.buffer, m_StorageBuffer.buffer, 1,
-                  &copyRegion);
-
-  device->flushCommandBuffer(copyCmd, engine->GetQueue());
-
-  // Destroy staging resources
-  vkDestroyBuffer(device->logicalDevice, storageStaging.buffer, nullptr);
-  vkFreeMemory(device->logicalDevice, storageStaging.memory, nullptr);
+  auto& uploads = UniEngine::GetInstance()->GetUploadManager();
+  uploads.copy(m_NoiseLayers.data(), m_NoiseLayers.size() * sizeof(NoiseLayerData), m_StorageBuffer.buffer);
+  uploads.submit();
 }
 
 double Planet::GetRadius() {
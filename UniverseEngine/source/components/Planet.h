@@ -3,6 +3,9 @@
 #include "../vks/VulkanBuffer.hpp"
 #include "../vks/VulkanTexture.hpp"
 #include "../materials/PlanetMaterial.h"
+#include "PlanetBake.h"
+#include "PlanetTerrain.h"
+#include "PlanetHeightQuery.h"
 #include "../vks/frustum.hpp"
 #include "../3dmaths.h"
 
@@ -32,6 +35,10 @@ namespace uni
 				glm::vec2 viewportDim;
 				float tessellatedEdgeSize;
 				bool hasOcean = false;
+				/** @brief Turns the static grid to face the camera, identity when the vertices are already placed */
+				glm::mat4 gridRotation = glm::mat4(1.f);
+				/** @brief x: terrain grid Z offset, y: ocean grid Z offset */
+				glm::vec4 gridOffset = glm::vec4(0.f);
 			} m_UniformBufferData;
 		
 			struct NoiseLayerData {
@@ -50,11 +57,14 @@ namespace uni
 			vks::Buffer m_OceanVertexBuffer;
 			vks::Buffer m_IndexBuffer;
 			vks::Buffer m_OceanIndexBuffer;
-			vks::Buffer m_UniformBuffer;
 			vks::Buffer m_StorageBuffer;
 			uint32_t m_VertexCount;
 			uint32_t m_IndexCount;
 			VkDescriptorSet m_DescriptorSet;
+			/**
+			* @brief Upload the grid once and place it in the vertex shaders, set before Initialize. Off rebuilds it on the CPU
+			*/
+			bool m_StaticGrid = true;
 		
 			vks::Frustum frustum;
 		
@@ -75,8 +85,16 @@ namespace uni
 			double GetPositionOffset(glm::vec3& pos);
 			void UpdateMesh();
 			void UpdateBuffers();
-			void UpdateUniformBuffers(glm::mat4& modelMat);
+			/** @brief modelMat is camera relative (see CameraComponent::RelativeToCamera), cameraPos in planet space */
+			void UpdateUniformBuffers(const glm::mat4& modelMat, const glm::vec3& cameraPos);
+			/** @brief Copy the uniforms into the frame's uniform ring slice, called by SceneRenderer::PushUniforms */
+			void PushUniforms();
+			/** @brief Height of point (planet space) above the displaced surface, see GetTerrain */
 			float GetAltitude(glm::vec3& point);
+			/** @brief CPU sampler of the surface the shaders draw, only valid while this planet lives */
+			uni::planet::TerrainSampler GetTerrain() const;
+			/** @brief Cached height and ray queries for collision, null until Initialize */
+			std::shared_ptr<uni::planet::HeightQuery> GetHeightQuery() { return m_HeightQuery; }
 			glm::vec3 CameraPos() { return m_CurrentCameraPos; }
 			std::vector<glm::vec3> GetMesh() { return m_MeshVerts; }
 			uint16_t GridSize() { return m_GridSize; }
@@ -118,12 +136,15 @@ namespace uni
 			void MakeRampTexture();
 			void MakeContintentTexture();
 		
-			std::vector<float> m_ContinentData;
+			uni::planet::ContinentParams m_ContinentParams;
+			std::shared_ptr<const uni::planet::ContinentMap> m_ContinentMap;
+			std::shared_ptr<uni::planet::HeightQuery> m_HeightQuery;
 			bool m_HasOcean = false;
 			uint32_t m_OceanVertexCount;
 			void UpdateStorageBuffer();
 			
 			uint32_t m_OceanIndexCount;
+			bool m_IndicesUploaded = false;
 		
 		};
 		
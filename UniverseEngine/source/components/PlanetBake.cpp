@@ -0,0 +1,201 @@
+#include "PlanetBake.h"
+#include <algorithm>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <iomanip>
+#include <string.h>
+#include <ppl.h>
+#include "../FastNoise.h"
+
+using namespace uni::planet;
+
+namespace {
+  const uint32_t ContinentFileMagic = 0x504D4355;  // "UCMP"
+
+  struct ContinentFileHeader {
+    uint32_t magic;
+    uint32_t version;
+    uint64_t key;
+    uint32_t size;
+    uint32_t reserved;
+  };
+
+  std::string ContinentFilePath(const std::string& cacheDir, uint64_t key) {
+    std::stringstream name;
+    name << "continent_" << std::hex << std::setw(16) << std::setfill('0')
+         << key << ".bin";
+    return (std::filesystem::path(cacheDir) / name.str()).string();
+  }
+
+  bool ReadContinentFile(const std::string& path,
+                         uint64_t key,
+                         uint32_t size,
+                         ContinentMap& map) {
+    std::ifstream file(path, std::ios::binary);
+    if (!file)
+      return false;
+
+    ContinentFileHeader header;
+    if (!file.read(reinterpret_cast<char*>(&header), sizeof(header)))
+      return false;
+
+    if (header.magic != ContinentFileMagic ||
+        header.version != ContinentBakeVersion || header.key != key ||
+        header.size != size)
+      return false;
+
+    map.size = size;
+    map.data.resize(size_t(size) * size);
+    if (!file.read(reinterpret_cast<char*>(map.data.data()),
+                   map.data.size() * sizeof(float)))
+      return false;
+
+    return true;
+  }
+
+  void WriteContinentFile(const std::string& path,
+                          uint64_t key,
+                          const ContinentMap& map) {
+    ContinentFileHeader header = {ContinentFileMagic, ContinentBakeVersion,
+                                  key, map.size, 0};
+
+    // Written next to the real name and renamed once complete, so a crash
+    // half way through never leaves a short file behind under the key
+    auto temp = path + ".tmp";
+    {
+      std::ofstream file(temp, std::ios::binary | std::ios::trunc);
+      file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+      file.write(reinterpret_cast<const char*>(map.data.data()),
+                 map.data.size() * sizeof(float));
+      if (!file) {
+        std::cout << "Could not write continent cache " << temp << std::endl;
+        return;
+      }
+    }
+
+    std::error_code error;
+    std::filesystem::rename(temp, path, error);
+    if (error)
+      std::cout << "Could not write continent cache " << path << ": "
+                << error.message() << std::endl;
+  }
+}
+
+ContinentMap uni::planet::BakeContinentMap(const ContinentParams& params) {
+  const uint32_t size = params.size;
+
+  ContinentMap map;
+  map.size = size;
+  map.data.resize(size_t(size) * size);
+
+  FastNoise noise(params.seed);
+  noise.SetNoiseType(FastNoise::SimplexFractal);
+  noise.SetFractalOctaves(params.octaves);
+
+  // Longitude only depends on the column, work it out once for every row.
+  // Angles come from integer texel indices so every row and column lands
+  // exactly where it should, however large the map.
+  std::vector<float> cosLon(size), sinLon(size);
+  for (uint32_t x = 0; x < size; x++) {
+    float lon = glm::radians(360.f * x / size);
+    cosLon[x] = cos(lon);
+    sinLon[x] = sin(lon);
+  }
+
+  // GetNoiseSet only reads the generator, so rows can share it
+  concurrency::parallel_for(0u, size, [&](uint32_t y) {
+    float lat = glm::radians(-90.f + 180.f * y / size);
+    float cosLat = cos(lat);
+    float sinLat = sin(lat);
+
+    // Positions for the whole row first, then the noise in one pass
+    std::vector<float> px(size), py(size), pz(size);
+    for (uint32_t x = 0; x < size; x++) {
+      px[x] = (cosLat * cosLon[x] + params.offset.x) * params.scale;
+      py[x] = (cosLat * sinLon[x] + params.offset.y) * params.scale;
+      pz[x] = (sinLat + params.offset.z) * params.scale;
+    }
+
+    float* row = &map.data[size_t(y) * size];
+    noise.GetNoiseSet(px.data(), py.data(), pz.data(), row, size);
+    for (uint32_t x = 0; x < size; x++) {
+      row[x] = row[x] / 2.f + 0.5f;
+    }
+  });
+
+  return map;
+}
+
+uint64_t uni::planet::HashBytes(const void* data, size_t size, uint64_t seed) {
+  auto bytes = static_cast<const uint8_t*>(data);
+  uint64_t hash = seed;
+  for (size_t i = 0; i < size; i++) {
+    hash ^= bytes[i];
+    hash *= 1099511628211ull;
+  }
+  return hash;
+}
+
+uint64_t uni::planet::ContinentKey(const ContinentParams& params) {
+  // field by field, so padding never ends up in the key
+  uint64_t key = HashBytes(&ContinentBakeVersion, sizeof(ContinentBakeVersion));
+  key = HashBytes(&params.seed, sizeof(params.seed), key);
+  key = HashBytes(&params.octaves, sizeof(params.octaves), key);
+  key = HashBytes(&params.scale, sizeof(params.scale), key);
+  key = HashBytes(&params.offset.x, sizeof(float), key);
+  key = HashBytes(&params.offset.y, sizeof(float), key);
+  key = HashBytes(&params.offset.z, sizeof(float), key);
+  key = HashBytes(&params.size, sizeof(params.size), key);
+  return key;
+}
+
+ContinentMap uni::planet::LoadOrBakeContinentMap(const ContinentParams& params,
+                                                 const std::string& cacheDir) {
+  auto key = ContinentKey(params);
+  auto path = ContinentFilePath(cacheDir, key);
+
+  ContinentMap map;
+  if (ReadContinentFile(path, key, params.size, map))
+    return map;
+
+  map = BakeContinentMap(params);
+
+  std::error_code error;
+  std::filesystem::create_directories(cacheDir, error);
+  if (!error)
+    WriteContinentFile(path, key, map);
+
+  return map;
+}
+
+VkFormat uni::planet::ContinentTextureFormat(VkPhysicalDevice physicalDevice) {
+  VkFormatProperties properties;
+  vkGetPhysicalDeviceFormatProperties(physicalDevice, VK_FORMAT_R16_UNORM,
+                                      &properties);
+  if (properties.optimalTilingFeatures &
+      VK_FORMAT_FEATURE_SAMPLED_IMAGE_FILTER_LINEAR_BIT)
+    return VK_FORMAT_R16_UNORM;
+
+  return VK_FORMAT_R32_SFLOAT;
+}
+
+std::vector<uint8_t> uni::planet::ContinentTextureData(const ContinentMap& map,
+                                                       VkFormat format) {
+  std::vector<uint8_t> texels;
+
+  if (format == VK_FORMAT_R16_UNORM) {
+    texels.resize(map.data.size() * sizeof(uint16_t));
+    auto out = reinterpret_cast<uint16_t*>(texels.data());
+    for (size_t i = 0; i < map.data.size(); i++) {
+      float n = std::clamp(map.data[i], 0.f, 1.f);
+      out[i] = static_cast<uint16_t>(n * 65535.f + 0.5f);
+    }
+  } else {
+    texels.resize(map.data.size() * sizeof(float));
+    memcpy(texels.data(), map.data.data(), texels.size());
+  }
+
+  return texels;
+}
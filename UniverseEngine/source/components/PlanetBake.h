@@ -0,0 +1,61 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include <vulkan/vulkan.h>
+#include "../3dmaths.h"
+
+namespace uni
+{
+	namespace planet
+	{
+		/** @brief Noise settings a continent map is baked from */
+		struct ContinentParams {
+			int seed = 1337;
+			int octaves = 3;
+			float scale = 120.3587f;
+			glm::vec3 offset = glm::vec3(2.f);
+			/** @brief Width and height of the map in texels */
+			uint32_t size = 1024;
+		};
+
+		/**
+		* @brief Single channel equirectangular map of the continent noise, values roughly in [0, 1]
+		*
+		* Rows run from latitude -90 upwards and columns from longitude 0 eastwards, one texel per 180/size and
+		* 360/size degrees.
+		*/
+		struct ContinentMap {
+			uint32_t size = 0;
+			std::vector<float> data;
+
+			float At(uint32_t x, uint32_t y) const { return data[y * size + x]; }
+		};
+
+		/** @brief Bump whenever BakeContinentMap gives different output for the same params, old cache files then miss */
+		const uint32_t ContinentBakeVersion = 1;
+
+		/** @brief Evaluate the continent noise for every texel, rows are spread over all cores */
+		ContinentMap BakeContinentMap(const ContinentParams& params);
+
+		/** @brief 64 bit FNV-1a of a block of bytes, pass the previous result as seed to hash several blocks */
+		uint64_t HashBytes(const void* data, size_t size, uint64_t seed = 14695981039346656037ull);
+
+		/** @brief Cache key of everything BakeContinentMap's output depends on, including the bake's version */
+		uint64_t ContinentKey(const ContinentParams& params);
+
+		/**
+		* @brief Read the map baked with params from cacheDir, or bake it and store it there for next time
+		*
+		* Files are named after ContinentKey, so changing any parameter (or the bake itself, see ContinentBakeVersion)
+		* simply misses and bakes again. A file that is short, from another version or for another key is ignored.
+		*/
+		ContinentMap LoadOrBakeContinentMap(const ContinentParams& params, const std::string& cacheDir);
+
+		/** @brief R16_UNORM when the device can filter it, R32_SFLOAT otherwise */
+		VkFormat ContinentTextureFormat(VkPhysicalDevice physicalDevice);
+
+		/** @brief Texel data for a texture of the given format, R16_UNORM or R32_SFLOAT */
+		std::vector<uint8_t> ContinentTextureData(const ContinentMap& map, VkFormat format);
+	}
+}
@@ -0,0 +1,366 @@
+#include "PlanetHeightQuery.h"
+#include <chrono>
+#include <cmath>
+
+using namespace uni::planet;
+
+namespace {
+  const size_t BatchChunk = 256;
+
+  // Marching stops here, a ray this long without an answer counts as a miss
+  const int MaxRaySteps = 256;
+  const int RayRefineSteps = 16;
+
+  // Tile keys: face in bits 40 and up, tile row in 20-39, tile column in 0-19
+  uint64_t TileKey(uint32_t face, uint32_t tx, uint32_t ty) {
+    return (uint64_t(face) << 40) | (uint64_t(ty) << 20) | uint64_t(tx);
+  }
+}
+
+HeightQuery::HeightQuery(std::shared_ptr<const ContinentMap> continents,
+                         float radius,
+                         float maxHeight,
+                         const Settings& settings)
+    : m_Continents(continents),
+      m_Sampler(*continents, radius, maxHeight),
+      m_Settings(settings) {
+  m_Settings.tilesPerEdge = std::max(1u, m_Settings.tilesPerEdge);
+  m_Settings.tileResolution = std::max(2u, m_Settings.tileResolution);
+
+  m_TileBytes = sizeof(Tile) + size_t(m_Settings.tileResolution) *
+                                   m_Settings.tileResolution * sizeof(float);
+  m_MaxTiles = std::max<size_t>(1, m_Settings.maxBytes / m_TileBytes);
+
+  uint32_t workers = m_Settings.workers;
+  if (workers == 0)
+    workers = std::max(2u, std::thread::hardware_concurrency()) - 1;
+  for (uint32_t i = 0; i < workers; i++)
+    m_Workers.emplace_back(&HeightQuery::WorkerLoop, this);
+}
+
+HeightQuery::~HeightQuery() {
+  {
+    std::lock_guard<std::mutex> lock(m_Mutex);
+    m_Stopping = true;
+    m_Pending.clear();
+  }
+  m_WorkAvailable.notify_all();
+  for (auto& worker : m_Workers)
+    worker.join();
+}
+
+HeightQuery::TileCoord HeightQuery::Locate(const glm::vec3& dir) const {
+  // Cube face of the largest component, the other two divided by it give the
+  // position on the face in [-1, 1]
+  float ax = std::abs(dir.x);
+  float ay = std::abs(dir.y);
+  float az = std::abs(dir.z);
+  uint32_t face;
+  float u, v;
+  if (ax >= ay && ax >= az) {
+    face = dir.x >= 0.f ? 0 : 1;
+    u = dir.y / ax;
+    v = dir.z / ax;
+  } else if (ay >= az) {
+    face = dir.y >= 0.f ? 2 : 3;
+    u = dir.x / ay;
+    v = dir.z / ay;
+  } else {
+    face = dir.z >= 0.f ? 4 : 5;
+    u = dir.x / az;
+    v = dir.y / az;
+  }
+  if (!(ax > 0.f || ay > 0.f || az > 0.f)) {
+    u = 0.f;
+    v = 0.f;
+  }
+
+  const uint32_t tiles = m_Settings.tilesPerEdge;
+  const float cells = float(m_Settings.tileResolution - 1);
+  float gx = std::clamp((u + 1.f) * 0.5f * tiles, 0.f, float(tiles));
+  float gy = std::clamp((v + 1.f) * 0.5f * tiles, 0.f, float(tiles));
+  uint32_t tx = std::min(uint32_t(gx), tiles - 1);
+  uint32_t ty = std::min(uint32_t(gy), tiles - 1);
+
+  TileCoord coord;
+  coord.key = TileKey(face, tx, ty);
+  coord.x = std::clamp((gx - tx) * cells, 0.f, cells);
+  coord.y = std::clamp((gy - ty) * cells, 0.f, cells);
+  return coord;
+}
+
+glm::vec3 HeightQuery::SampleDirection(uint64_t key,
+                                       uint32_t x,
+                                       uint32_t y) const {
+  uint32_t face = uint32_t(key >> 40);
+  uint32_t ty = uint32_t(key >> 20) & 0xfffff;
+  uint32_t tx = uint32_t(key) & 0xfffff;
+
+  // Samples on a tile's edge land on exactly the same direction as the
+  // neighbouring tile's, on this face or the next
+  const float tiles = float(m_Settings.tilesPerEdge);
+  const float cells = float(m_Settings.tileResolution - 1);
+  float u = (tx + x / cells) / tiles * 2.f - 1.f;
+  float v = (ty + y / cells) / tiles * 2.f - 1.f;
+
+  switch (face) {
+    case 0:
+      return glm::vec3(1.f, u, v);
+    case 1:
+      return glm::vec3(-1.f, u, v);
+    case 2:
+      return glm::vec3(u, 1.f, v);
+    case 3:
+      return glm::vec3(u, -1.f, v);
+    case 4:
+      return glm::vec3(u, v, 1.f);
+    default:
+      return glm::vec3(u, v, -1.f);
+  }
+}
+
+float HeightQuery::SampleTile(const Tile& tile, const TileCoord& coord) const {
+  const uint32_t res = m_Settings.tileResolution;
+  uint32_t x0 = std::min(uint32_t(coord.x), res - 2);
+  uint32_t y0 = std::min(uint32_t(coord.y), res - 2);
+  float tx = coord.x - x0;
+  float ty = coord.y - y0;
+
+  const float* row0 = &tile.heights[size_t(y0) * res + x0];
+  const float* row1 = row0 + res;
+  return glm::mix(glm::mix(row0[0], row0[1], tx), glm::mix(row1[0], row1[1], tx), ty);
+}
+
+std::shared_ptr<const HeightQuery::Tile> HeightQuery::FindTile(uint64_t key) {
+  auto found = m_Cache.find(key);
+  if (found != m_Cache.end()) {
+    m_Lru.splice(m_Lru.begin(), m_Lru, found->second.lru);
+    return found->second.tile;
+  }
+
+  if (!m_Stopping && m_Pending.size() < m_Settings.maxPendingBakes &&
+      m_Requested.insert(key).second) {
+    m_Pending.push_back(key);
+    m_WorkAvailable.notify_one();
+  }
+  return nullptr;
+}
+
+float HeightQuery::Lookup(const glm::vec3& dir,
+                          uint64_t& key,
+                          std::shared_ptr<const Tile>& tile,
+                          uint64_t& hits) {
+  auto coord = Locate(dir);
+  if (coord.key != key) {
+    std::lock_guard<std::mutex> lock(m_Mutex);
+    tile = FindTile(coord.key);
+    key = coord.key;
+  }
+
+  if (!tile)
+    return m_Sampler.Height(dir);
+
+  hits++;
+  return SampleTile(*tile, coord);
+}
+
+void HeightQuery::Count(uint64_t queries, uint64_t hits) {
+  std::lock_guard<std::mutex> lock(m_Mutex);
+  m_Frame.queries += queries;
+  m_Frame.hits += hits;
+  m_Total.queries += queries;
+  m_Total.hits += hits;
+}
+
+float HeightQuery::HeightAt(const glm::vec3& dir) {
+  uint64_t key = ~0ull;
+  std::shared_ptr<const Tile> tile;
+  uint64_t hits = 0;
+  float height = Lookup(dir, key, tile, hits);
+  Count(1, hits);
+  return height;
+}
+
+void HeightQuery::HeightAt(const glm::vec3* dirs, float* out, size_t count) {
+  std::vector<TileCoord> coords(count);
+  std::vector<std::shared_ptr<const Tile>> tiles(count);
+  for (size_t i = 0; i < count; i++)
+    coords[i] = Locate(dirs[i]);
+
+  // One lock for the whole batch, neighbouring queries mostly share a tile
+  uint64_t hits = 0;
+  {
+    std::lock_guard<std::mutex> lock(m_Mutex);
+    uint64_t key = ~0ull;
+    std::shared_ptr<const Tile> tile;
+    for (size_t i = 0; i < count; i++) {
+      if (coords[i].key != key) {
+        key = coords[i].key;
+        tile = FindTile(key);
+      }
+      if (tile) {
+        tiles[i] = tile;
+        hits++;
+      }
+    }
+  }
+  Count(count, hits);
+
+  ParallelChunks(count, BatchChunk, [&](size_t begin, size_t end) {
+    for (size_t i = begin; i < end; i++)
+      out[i] = tiles[i] ? SampleTile(*tiles[i], coords[i])
+                        : m_Sampler.Height(dirs[i]);
+  });
+}
+
+TerrainHit HeightQuery::Raycast(const glm::vec3& origin,
+                                const glm::vec3& dir,
+                                float maxDistance) {
+  TerrainHit result;
+  float length = glm::length(dir);
+  if (!(length > 0.f) || !(maxDistance > 0.f))
+    return result;
+  glm::vec3 d = dir / length;
+
+  // Only the stretch inside the sphere every mountain fits in is marched
+  float bound = m_Sampler.MaxHeight();
+  float b = glm::dot(origin, d);
+  float c = glm::dot(origin, origin) - bound * bound;
+  float disc = b * b - c;
+  if (disc < 0.f || (c > 0.f && b > 0.f))
+    return result;
+  float root = std::sqrt(disc);
+  float t = std::max(0.f, -b - root);
+  float end = std::min(maxDistance, -b + root);
+  if (t > end)
+    return result;
+
+  // About a quarter of the spacing between tile samples
+  const float minStep = m_Sampler.MaxHeight() * 0.5f /
+                        (m_Settings.tilesPerEdge * (m_Settings.tileResolution - 1));
+
+  uint64_t key = ~0ull;
+  std::shared_ptr<const Tile> tile;
+  uint64_t queries = 0;
+  uint64_t hits = 0;
+  auto altitude = [&](float at) {
+    glm::vec3 p = origin + d * at;
+    queries++;
+    return glm::length(p) - Lookup(p, key, tile, hits);
+  };
+
+  // Step by half the height above ground, slopes can be steeper than the
+  // direction straight down suggests
+  float previous = t;
+  for (int step = 0; step < MaxRaySteps; step++) {
+    float alt = altitude(t);
+    if (alt <= 0.f) {
+      float above = previous;
+      float below = t;
+      if (step == 0)
+        above = below;
+      for (int i = 0; i < RayRefineSteps && above < below; i++) {
+        float mid = 0.5f * (above + below);
+        if (altitude(mid) > 0.f)
+          above = mid;
+        else
+          below = mid;
+      }
+      result.hit = true;
+      result.distance = below;
+      result.point = origin + d * below;
+      break;
+    }
+    if (t >= end)
+      break;
+
+    previous = t;
+    t = std::min(end, t + std::max(alt * 0.5f, minStep));
+  }
+
+  Count(queries, hits);
+  return result;
+}
+
+void HeightQuery::Raycast(const glm::vec3* origins,
+                          const glm::vec3* dirs,
+                          const float* maxDistances,
+                          TerrainHit* hits,
+                          size_t count) {
+  ParallelChunks(count, 16, [&](size_t begin, size_t end) {
+    for (size_t i = begin; i < end; i++)
+      hits[i] = Raycast(origins[i], dirs[i], maxDistances[i]);
+  });
+}
+
+HeightQueryStats HeightQuery::FrameStats() {
+  std::lock_guard<std::mutex> lock(m_Mutex);
+  auto stats = m_Frame;
+  stats.tiles = static_cast<uint32_t>(m_Cache.size());
+  stats.bytes = m_Cache.size() * m_TileBytes;
+  return stats;
+}
+
+HeightQueryStats HeightQuery::TotalStats() {
+  std::lock_guard<std::mutex> lock(m_Mutex);
+  auto stats = m_Total;
+  stats.tiles = static_cast<uint32_t>(m_Cache.size());
+  stats.bytes = m_Cache.size() * m_TileBytes;
+  return stats;
+}
+
+void HeightQuery::EndFrame() {
+  std::lock_guard<std::mutex> lock(m_Mutex);
+  m_Frame = HeightQueryStats();
+}
+
+void HeightQuery::WorkerLoop() {
+  const uint32_t res = m_Settings.tileResolution;
+
+  while (true) {
+    uint64_t key;
+    {
+      std::unique_lock<std::mutex> lock(m_Mutex);
+      m_WorkAvailable.wait(lock, [this] { return m_Stopping || !m_Pending.empty(); });
+      if (m_Stopping)
+        return;
+      // Newest first, whatever asked last is most likely still around
+      key = m_Pending.back();
+      m_Pending.pop_back();
+    }
+
+    auto start = std::chrono::high_resolution_clock::now();
+
+    auto tile = std::make_shared<Tile>();
+    tile->heights.resize(size_t(res) * res);
+    for (uint32_t y = 0; y < res; y++) {
+      for (uint32_t x = 0; x < res; x++)
+        tile->heights[size_t(y) * res + x] = m_Sampler.Height(SampleDirection(key, x, y));
+    }
+
+    double ms = std::chrono::duration<double, std::milli>(
+                    std::chrono::high_resolution_clock::now() - start)
+                    .count();
+    Insert(key, tile, ms);
+  }
+}
+
+void HeightQuery::Insert(uint64_t key,
+                         std::shared_ptr<const Tile> tile,
+                         double bakeMs) {
+  std::lock_guard<std::mutex> lock(m_Mutex);
+  m_Requested.erase(key);
+
+  m_Frame.bakes++;
+  m_Frame.bakeMs += bakeMs;
+  m_Total.bakes++;
+  m_Total.bakeMs += bakeMs;
+
+  m_Lru.push_front(key);
+  m_Cache[key] = {tile, m_Lru.begin()};
+
+  while (m_Cache.size() > m_MaxTiles) {
+    m_Cache.erase(m_Lru.back());
+    m_Lru.pop_back();
+  }
+}
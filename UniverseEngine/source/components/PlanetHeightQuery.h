@@ -0,0 +1,154 @@
+#pragma once
+
+#include <condition_variable>
+#include <deque>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+#include "PlanetTerrain.h"
+
+namespace uni
+{
+	namespace planet
+	{
+		/** @brief Where a ray met the terrain, distance along its (normalised) direction */
+		struct TerrainHit {
+			bool hit = false;
+			float distance = 0.f;
+			glm::vec3 point = glm::vec3(0.f);
+		};
+
+		/** @brief Counters of a HeightQuery, per frame (see EndFrame) or since it was created */
+		struct HeightQueryStats {
+			/** @brief Height lookups, a ray counts every lookup it makes while marching */
+			uint64_t queries = 0;
+			/** @brief Lookups answered from a cached tile, the rest were evaluated exactly */
+			uint64_t hits = 0;
+			uint32_t bakes = 0;
+			/** @brief Worker time spent baking tiles */
+			double bakeMs = 0.0;
+			/** @brief Cached tiles and their memory, current values rather than sums */
+			uint32_t tiles = 0;
+			size_t bytes = 0;
+
+			double HitRate() const { return queries ? double(hits) / double(queries) : 0.0; }
+		};
+
+		/**
+		* @brief Height and ray queries against a planet's terrain for collision, physics and AI
+		*
+		* The sphere is split into the six faces of a cube, each cut into tilesPerEdge x tilesPerEdge tiles. A tile
+		* holds a grid of heights baked with TerrainSampler and queries read it bilinearly. Neighbouring tiles (also
+		* across cube faces) sample their shared edge at the same directions, so the cached surface has no cracks.
+		*
+		* Tiles are baked lazily on the query's own worker threads and kept in an LRU cache bounded by maxBytes. A
+		* query never waits for a bake: a lookup landing on a tile that isn't cached yet asks for it and is answered
+		* with an exact TerrainSampler evaluation, so latency is bounded by the sampler's cost.
+		*
+		* Every method can be called from any thread.
+		*/
+		class HeightQuery {
+		public:
+			struct Settings {
+				/** @brief Tiles along each edge of a cube face */
+				uint32_t tilesPerEdge = 64;
+				/** @brief Height samples along each edge of a tile, edges are shared with the neighbours */
+				uint32_t tileResolution = 33;
+				/** @brief Cache budget, least recently used tiles go first */
+				size_t maxBytes = 32 * 1024 * 1024;
+				/** @brief Bake threads, 0 for one less than the hardware has (at least one) */
+				uint32_t workers = 0;
+				/** @brief Bakes that may be waiting, further misses are evaluated without asking for their tile */
+				uint32_t maxPendingBakes = 256;
+			};
+
+			HeightQuery(std::shared_ptr<const ContinentMap> continents, float radius, float maxHeight, const Settings& settings);
+			HeightQuery(std::shared_ptr<const ContinentMap> continents, float radius, float maxHeight)
+				: HeightQuery(continents, radius, maxHeight, Settings()) {}
+			/** @brief Waits for bakes in progress, queued ones are dropped */
+			~HeightQuery();
+
+			HeightQuery(const HeightQuery&) = delete;
+			HeightQuery& operator=(const HeightQuery&) = delete;
+
+			/** @brief Surface height (distance from the centre) in the direction of dir, planet space */
+			float HeightAt(const glm::vec3& dir);
+			/** @brief HeightAt for count directions, tile lookups happen once per batch and sampling is spread over all cores */
+			void HeightAt(const glm::vec3* dirs, float* out, size_t count);
+
+			/**
+			* Find where a ray first meets the terrain
+			*
+			* @param origin Start of the ray in planet space
+			* @param dir Direction of the ray, need not be normalised
+			* @param maxDistance Length of the ray
+			*/
+			TerrainHit Raycast(const glm::vec3& origin, const glm::vec3& dir, float maxDistance);
+			/** @brief Raycast for count rays, spread over all cores */
+			void Raycast(const glm::vec3* origins, const glm::vec3* dirs, const float* maxDistances, TerrainHit* hits, size_t count);
+
+			/** @brief Counters since the last EndFrame */
+			HeightQueryStats FrameStats();
+			/** @brief Counters since creation */
+			HeightQueryStats TotalStats();
+			/** @brief Close the current frame's counters */
+			void EndFrame();
+
+			const TerrainSampler& Sampler() const { return m_Sampler; }
+
+		private:
+			struct Tile {
+				std::vector<float> heights;
+			};
+
+			struct CacheEntry {
+				std::shared_ptr<const Tile> tile;
+				std::list<uint64_t>::iterator lru;
+			};
+
+			/** @brief A direction's tile and position within it in sample units */
+			struct TileCoord {
+				uint64_t key;
+				float x;
+				float y;
+			};
+
+			std::shared_ptr<const ContinentMap> m_Continents;
+			TerrainSampler m_Sampler;
+			Settings m_Settings;
+			size_t m_TileBytes;
+			size_t m_MaxTiles;
+
+			std::mutex m_Mutex;
+			std::unordered_map<uint64_t, CacheEntry> m_Cache;
+			/** @brief Most recently used first */
+			std::list<uint64_t> m_Lru;
+			std::deque<uint64_t> m_Pending;
+			/** @brief Queued or being baked, so a tile is only asked for once */
+			std::unordered_set<uint64_t> m_Requested;
+			HeightQueryStats m_Frame;
+			HeightQueryStats m_Total;
+
+			std::condition_variable m_WorkAvailable;
+			std::vector<std::thread> m_Workers;
+			bool m_Stopping = false;
+
+			TileCoord Locate(const glm::vec3& dir) const;
+			glm::vec3 SampleDirection(uint64_t key, uint32_t x, uint32_t y) const;
+			float SampleTile(const Tile& tile, const TileCoord& coord) const;
+
+			/** @brief Cached tile or nullptr, asks for a bake on a miss. Called with m_Mutex held */
+			std::shared_ptr<const Tile> FindTile(uint64_t key);
+			/** @brief Height in the direction of dir, key and tile remember the last tile used so runs in one tile look it up once */
+			float Lookup(const glm::vec3& dir, uint64_t& key, std::shared_ptr<const Tile>& tile, uint64_t& hits);
+			void Count(uint64_t queries, uint64_t hits);
+
+			void WorkerLoop();
+			void Insert(uint64_t key, std::shared_ptr<const Tile> tile, double bakeMs);
+		};
+	}
+}
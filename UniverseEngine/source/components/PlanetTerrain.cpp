@@ -0,0 +1,226 @@
+#include "PlanetTerrain.h"
+
+using namespace uni::planet;
+
+namespace {
+  // Below this a batch isn't worth handing to other threads
+  const size_t BatchChunk = 1024;
+
+  glm::vec4 Mod289(const glm::vec4& x) {
+    return x - glm::floor(x * (1.0f / 289.0f)) * 289.0f;
+  }
+
+  glm::vec3 Mod289(const glm::vec3& x) {
+    return x - glm::floor(x * (1.0f / 289.0f)) * 289.0f;
+  }
+
+  glm::vec4 Permute(const glm::vec4& x) {
+    return Mod289(((x * 34.0f) + 1.0f) * x);
+  }
+
+  glm::vec4 TaylorInvSqrt(const glm::vec4& r) {
+    return 1.79284291400159f - 0.85373472095314f * r;
+  }
+
+  // FractalNoise(0, 4, pos) from its octaves, octave[i] = SimplexNoise(pos * 2^i)
+  float OctaveSum(const float* octave) {
+    return octave[0] + octave[1] * 0.25f + octave[2] * 0.125f +
+           octave[3] * 0.0625f;
+  }
+}
+
+// Line for line with snoise in noise.glsl, keep the two in step
+float uni::planet::SimplexNoise(const glm::vec3& v) {
+  const glm::vec2 C(1.0f / 6.0f, 1.0f / 3.0f);
+  const glm::vec4 D(0.0f, 0.5f, 1.0f, 2.0f);
+
+  // First corner
+  glm::vec3 i = glm::floor(v + glm::dot(v, glm::vec3(C.y)));
+  glm::vec3 x0 = v - i + glm::dot(i, glm::vec3(C.x));
+
+  // Other corners
+  glm::vec3 g = glm::step(glm::vec3(x0.y, x0.z, x0.x), x0);
+  glm::vec3 l = 1.0f - g;
+  glm::vec3 i1 = glm::min(g, glm::vec3(l.z, l.x, l.y));
+  glm::vec3 i2 = glm::max(g, glm::vec3(l.z, l.x, l.y));
+
+  glm::vec3 x1 = x0 - i1 + C.x;
+  glm::vec3 x2 = x0 - i2 + C.y;
+  glm::vec3 x3 = x0 - D.y;
+
+  // Permutations
+  i = Mod289(i);
+  glm::vec4 p =
+      Permute(Permute(Permute(i.z + glm::vec4(0.0f, i1.z, i2.z, 1.0f)) + i.y +
+                      glm::vec4(0.0f, i1.y, i2.y, 1.0f)) +
+              i.x + glm::vec4(0.0f, i1.x, i2.x, 1.0f));
+
+  // Gradients: 7x7 points over a square, mapped onto an octahedron
+  float n_ = 0.142857142857f;  // 1.0/7.0
+  glm::vec3 ns = n_ * glm::vec3(D.w, D.y, D.z) - glm::vec3(D.x, D.z, D.x);
+
+  glm::vec4 j = p - 49.0f * glm::floor(p * ns.z * ns.z);  // mod(p,7*7)
+
+  glm::vec4 x_ = glm::floor(j * ns.z);
+  glm::vec4 y_ = glm::floor(j - 7.0f * x_);  // mod(j,N)
+
+  glm::vec4 x = x_ * ns.x + ns.y;
+  glm::vec4 y = y_ * ns.x + ns.y;
+  glm::vec4 h = 1.0f - glm::abs(x) - glm::abs(y);
+
+  glm::vec4 b0(x.x, x.y, y.x, y.y);
+  glm::vec4 b1(x.z, x.w, y.z, y.w);
+
+  glm::vec4 s0 = glm::floor(b0) * 2.0f + 1.0f;
+  glm::vec4 s1 = glm::floor(b1) * 2.0f + 1.0f;
+  glm::vec4 sh = -glm::step(h, glm::vec4(0.0f));
+
+  glm::vec4 a0 = glm::vec4(b0.x, b0.z, b0.y, b0.w) +
+                 glm::vec4(s0.x, s0.z, s0.y, s0.w) *
+                     glm::vec4(sh.x, sh.x, sh.y, sh.y);
+  glm::vec4 a1 = glm::vec4(b1.x, b1.z, b1.y, b1.w) +
+                 glm::vec4(s1.x, s1.z, s1.y, s1.w) *
+                     glm::vec4(sh.z, sh.z, sh.w, sh.w);
+
+  glm::vec3 p0(a0.x, a0.y, h.x);
+  glm::vec3 p1(a0.z, a0.w, h.y);
+  glm::vec3 p2(a1.x, a1.y, h.z);
+  glm::vec3 p3(a1.z, a1.w, h.w);
+
+  // Normalise gradients
+  glm::vec4 norm = TaylorInvSqrt(glm::vec4(glm::dot(p0, p0), glm::dot(p1, p1),
+                                           glm::dot(p2, p2), glm::dot(p3, p3)));
+  p0 *= norm.x;
+  p1 *= norm.y;
+  p2 *= norm.z;
+  p3 *= norm.w;
+
+  // Mix final noise value
+  glm::vec4 m = glm::max(0.6f - glm::vec4(glm::dot(x0, x0), glm::dot(x1, x1),
+                                          glm::dot(x2, x2), glm::dot(x3, x3)),
+                         0.0f);
+  m = m * m;
+  return 42.0f * glm::dot(m * m, glm::vec4(glm::dot(p0, x0), glm::dot(p1, x1),
+                                           glm::dot(p2, x2), glm::dot(p3, x3)));
+}
+
+float uni::planet::FractalNoise(int start, int octaves, glm::vec3 pos) {
+  float v = 0.0f;
+  float amplitude = 0.5f;
+  float lacunarity = 2.0f;
+  float gain = 0.5f;
+  int i = 0;
+
+  if (start == 0)
+    v = SimplexNoise(pos);
+
+  while (++i < octaves + start) {
+    pos *= lacunarity;
+    amplitude *= gain;
+    if (i >= start)
+      v += SimplexNoise(pos) * amplitude;
+  }
+  return v;
+}
+
+TerrainSampler::TerrainSampler(const ContinentMap& continents,
+                               float radius,
+                               float maxHeight)
+    : m_Continents(&continents), m_Radius(radius), m_MaxHeight(maxHeight) {}
+
+float TerrainSampler::Continent(const glm::vec3& pos) const {
+  const int size = static_cast<int>(m_Continents->size);
+  if (size == 0)
+    return 0.f;
+
+  // calculateUV
+  auto n = glm::normalize(pos);
+  float u = glm::atan(n.z, n.x) / (2.0f * 3.1415926f) + 0.5f;
+  float v = n.y * 0.5f + 0.5f;
+
+  // Linear filter with repeat addressing: texel centres sit at (i + 0.5) /
+  // size, the four around the sample are blended and indices wrap round
+  float fx = u * size - 0.5f;
+  float fy = v * size - 0.5f;
+  float x0f = floor(fx);
+  float y0f = floor(fy);
+  float tx = fx - x0f;
+  float ty = fy - y0f;
+
+  int x0 = (static_cast<int>(x0f) % size + size) % size;
+  int y0 = (static_cast<int>(y0f) % size + size) % size;
+  int x1 = (x0 + 1) % size;
+  int y1 = (y0 + 1) % size;
+
+  float top = glm::mix(m_Continents->At(x0, y0), m_Continents->At(x1, y0), tx);
+  float bottom =
+      glm::mix(m_Continents->At(x0, y1), m_Continents->At(x1, y1), tx);
+  return glm::mix(top, bottom, ty);
+}
+
+float TerrainSampler::Detail(const glm::vec3& pos, float base) const {
+  float multiplier = std::max(0.1f, base - 0.4f);
+  multiplier *= 6.0f;
+
+  float factor = 0.0f;
+
+  // The shader's first two stacks are 4 octaves at tpos and at tpos * 4, so
+  // the second stack's lower octaves are the first one's upper octaves.
+  // Scaling by powers of two is exact, work those out once.
+  glm::vec3 tpos = glm::normalize(pos) * 12.3587f;
+  float octave[6];
+  glm::vec3 opos = tpos;
+  for (int i = 0; i < 6; i++) {
+    octave[i] = SimplexNoise(opos);
+    opos *= 2.0f;
+  }
+  factor += std::max(0.0f, OctaveSum(octave));
+
+  tpos *= 4.0f;
+  factor += std::max(0.0f, OctaveSum(octave + 2));
+
+  tpos *= 2.7f;
+  factor += std::max(0.0f, FractalNoise(0, 4, tpos));
+
+  return factor * multiplier;
+}
+
+float TerrainSampler::HeightFactor(const glm::vec3& pos) const {
+  float hF = Continent(pos);
+  hF += Detail(pos, hF);
+  return hF;
+}
+
+float TerrainSampler::Height(const glm::vec3& pos) const {
+  return m_Radius + (m_Radius * m_MaxHeight) * HeightFactor(pos);
+}
+
+float TerrainSampler::Altitude(const glm::vec3& point) const {
+  return glm::length(point) - Height(point);
+}
+
+float TerrainSampler::MaxHeight() const {
+  // snoise stays within [-1, 1], so each 4 octave stack is below 1.4375 and
+  // the detail multiplier below (1 - 0.4) * 6. Rounded up for the continent
+  // map's filtering and float error.
+  const float maxFactor = 1.0f + 0.6f * 6.0f * 3.0f * 1.4375f;
+  return m_Radius + (m_Radius * m_MaxHeight) * maxFactor * 1.05f;
+}
+
+void TerrainSampler::Heights(const glm::vec3* pos,
+                             float* out,
+                             size_t count) const {
+  ParallelChunks(count, BatchChunk, [&](size_t begin, size_t end) {
+    for (size_t i = begin; i < end; i++)
+      out[i] = Height(pos[i]);
+  });
+}
+
+void TerrainSampler::Altitudes(const glm::vec3* points,
+                               float* out,
+                               size_t count) const {
+  ParallelChunks(count, BatchChunk, [&](size_t begin, size_t end) {
+    for (size_t i = begin; i < end; i++)
+      out[i] = Altitude(points[i]);
+  });
+}
@@ -0,0 +1,72 @@
+#pragma once
+
+#include <stddef.h>
+#include <algorithm>
+#include <ppl.h>
+#include "PlanetBake.h"
+#include "../3dmaths.h"
+
+namespace uni
+{
+	namespace planet
+	{
+		/** @brief Call func(begin, end) over [0, count) in chunks of chunkSize, spread over all cores when there's more than one */
+		template <typename Func>
+		void ParallelChunks(size_t count, size_t chunkSize, Func func)
+		{
+			if (count <= chunkSize) {
+				func(size_t(0), count);
+				return;
+			}
+
+			size_t chunks = (count + chunkSize - 1) / chunkSize;
+			concurrency::parallel_for(size_t(0), chunks, [&](size_t chunk) {
+				size_t begin = chunk * chunkSize;
+				func(begin, std::min(count, begin + chunkSize));
+			});
+		}
+
+		/** @brief snoise from noise.glsl, 3D simplex noise with the same permutation polynomial and gradients as the shaders */
+		float SimplexNoise(const glm::vec3& v);
+
+		/** @brief fractalNoise from noise.glsl, octaves of SimplexNoise starting at octave start */
+		float FractalNoise(int start, int octaves, glm::vec3 pos);
+
+		/**
+		* @brief CPU copy of the height the planet shaders displace the surface to (GetHeight in noise.glsl)
+		*
+		* The continent map is sampled bilinearly with wrapping, the way the continent texture's linear repeat sampler
+		* reads it, and the detail noise is the same simplex octave stack. Heights agree with the GPU to float precision,
+		* so collision, the altitude readout and ray casts see the terrain that is drawn.
+		*
+		* Only reads its map, any number of threads can share one. The map must outlive the sampler.
+		*/
+		class TerrainSampler {
+		public:
+			TerrainSampler(const ContinentMap& continents, float radius, float maxHeight);
+
+			/** @brief Continent map value in the direction of pos, heightFactor in noise.glsl */
+			float Continent(const glm::vec3& pos) const;
+			/** @brief Detail on top of a continent value base, detailHeightFactor in noise.glsl */
+			float Detail(const glm::vec3& pos, float base) const;
+			/** @brief Continent plus detail, in units of radius * maxHeight */
+			float HeightFactor(const glm::vec3& pos) const;
+			/** @brief Distance from the planet's centre to the surface in the direction of pos */
+			float Height(const glm::vec3& pos) const;
+			/** @brief Height of point above the surface beneath it, negative below ground */
+			float Altitude(const glm::vec3& point) const;
+			/** @brief No Height() is above this, continent and every detail octave at their largest */
+			float MaxHeight() const;
+
+			/** @brief Height() for count directions, large batches are spread over all cores */
+			void Heights(const glm::vec3* pos, float* out, size_t count) const;
+			/** @brief Altitude() for count points, large batches are spread over all cores */
+			void Altitudes(const glm::vec3* points, float* out, size_t count) const;
+
+		private:
+			const ContinentMap* m_Continents;
+			float m_Radius;
+			float m_MaxHeight;
+		};
+	}
+}
@@ -0,0 +1,807 @@
+#include "PlanetVolume.h"
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cmath>
+#include <functional>
+#include <map>
+#include <set>
+#include "PlanetTerrain.h"
+
+using namespace uni::planet;
+
+namespace {
+  const size_t ErrorChunk = 4096;
+  const int MaxDepth = 17;
+
+  // Trailing zero bits, zero has all of them
+  int TrailingZeros(int32_t v) {
+    if (v == 0)
+      return 64;
+    int n = 0;
+    while ((v & 1) == 0) {
+      v >>= 1;
+      n++;
+    }
+    return n;
+  }
+
+  uint64_t Mix(uint64_t key) {
+    key ^= key >> 33;
+    key *= 0xff51afd7ed558ccdull;
+    key ^= key >> 33;
+    key *= 0xc4ceb9fe1a85ec53ull;
+    key ^= key >> 33;
+    return key;
+  }
+
+  int LengthSquared(const glm::ivec3& v) {
+    return v.x * v.x + v.y * v.y + v.z * v.z;
+  }
+
+  // Bounding sphere of a diamond over its scale, the furthest corner of its
+  // tets from the centre
+  const float ShapeRadius[3] = {1.7320508f, 1.4142136f, 1.4142136f};
+
+  const int TetEdges[6][2] = {{0, 1}, {0, 2}, {0, 3}, {1, 2}, {1, 3}, {2, 3}};
+}
+
+FlatTable::FlatTable(size_t capacity) {
+  size_t size = 16;
+  while (size < capacity * 2)
+    size <<= 1;
+  m_Keys.assign(size, 0);
+  m_Values.resize(size);
+  m_Mask = size - 1;
+}
+
+size_t FlatTable::Slot(uint64_t key) const {
+  size_t slot = size_t(Mix(key)) & m_Mask;
+  while (m_Keys[slot] != 0 && m_Keys[slot] != key)
+    slot = (slot + 1) & m_Mask;
+  return slot;
+}
+
+uint32_t FlatTable::Find(uint64_t key) const {
+  size_t slot = Slot(key);
+  return m_Keys[slot] == key ? m_Values[slot] : NotFound;
+}
+
+uint32_t FlatTable::Insert(uint64_t key, uint32_t value) {
+  // Kept at most half full, probes stay short
+  if ((m_Size + 1) * 2 > m_Keys.size())
+    Grow();
+
+  size_t slot = Slot(key);
+  if (m_Keys[slot] == key)
+    return m_Values[slot];
+
+  m_Keys[slot] = key;
+  m_Values[slot] = value;
+  m_Size++;
+  return value;
+}
+
+bool FlatTable::Erase(uint64_t key) {
+  size_t slot = Slot(key);
+  if (m_Keys[slot] != key)
+    return false;
+
+  // Move back whatever later in the run would no longer be found past the gap
+  size_t gap = slot;
+  size_t next = (gap + 1) & m_Mask;
+  while (m_Keys[next] != 0) {
+    size_t home = size_t(Mix(m_Keys[next])) & m_Mask;
+    if (((next - home) & m_Mask) >= ((next - gap) & m_Mask)) {
+      m_Keys[gap] = m_Keys[next];
+      m_Values[gap] = m_Values[next];
+      gap = next;
+    }
+    next = (next + 1) & m_Mask;
+  }
+  m_Keys[gap] = 0;
+  m_Size--;
+  return true;
+}
+
+void FlatTable::Clear() {
+  std::fill(m_Keys.begin(), m_Keys.end(), 0);
+  m_Size = 0;
+}
+
+void FlatTable::Grow() {
+  std::vector<uint64_t> keys(m_Keys.size() * 2, 0);
+  std::vector<uint32_t> values(keys.size());
+  m_Keys.swap(keys);
+  m_Values.swap(values);
+  m_Mask = m_Keys.size() - 1;
+  m_Size = 0;
+  for (size_t i = 0; i < keys.size(); i++) {
+    if (keys[i] != 0)
+      Insert(keys[i], values[i]);
+  }
+}
+
+VolumeRefiner::VolumeRefiner(DensityFunc density,
+                             float extent,
+                             const Settings& settings)
+    : m_Density(density), m_Settings(settings), m_Extent(extent) {
+  m_Settings.depth = std::min<uint32_t>(std::max(1u, m_Settings.depth), MaxDepth);
+  m_Settings.maxDiamonds = std::max(64u, m_Settings.maxDiamonds);
+  m_RootScale = 1 << m_Settings.depth;
+  m_CellSize = extent / float(m_RootScale);
+
+  for (int i = 0; i < 8; i++) {
+    glm::ivec3 corner((i & 1) * 2 * m_RootScale, ((i >> 1) & 1) * 2 * m_RootScale,
+                      ((i >> 2) & 1) * 2 * m_RootScale);
+    m_CornerDensity[i] = m_Density(ToWorld(corner));
+  }
+
+  Reset();
+}
+
+glm::vec3 VolumeRefiner::ToWorld(const glm::ivec3& lattice) const {
+  return (glm::vec3(lattice) - float(m_RootScale)) * m_CellSize;
+}
+
+uint64_t VolumeRefiner::Key(const glm::ivec3& p) const {
+  // 19 bits a coordinate is enough for MaxDepth, the top bit keeps keys off 0
+  return uint64_t(p.x) | (uint64_t(p.y) << 19) | (uint64_t(p.z) << 38) |
+         (1ull << 57);
+}
+
+bool VolumeRefiner::Inside(const glm::ivec3& p) const {
+  const int32_t size = 2 * m_RootScale;
+  return p.x >= 0 && p.y >= 0 && p.z >= 0 && p.x <= size && p.y <= size &&
+         p.z <= size;
+}
+
+int32_t VolumeRefiner::Level(const glm::ivec3& p) const {
+  int tx = TrailingZeros(p.x);
+  int ty = TrailingZeros(p.y);
+  int tz = TrailingZeros(p.z);
+  int m = std::min(tx, std::min(ty, tz));
+  if (m > int(m_Settings.depth))
+    return -1;
+  int odd = (tx == m) + (ty == m) + (tz == m);
+  return 3 * (int(m_Settings.depth) - m) + (3 - odd);
+}
+
+VolumeRefiner::Shape VolumeRefiner::ShapeOf(const glm::ivec3& c) const {
+  Shape shape;
+  int t[3] = {TrailingZeros(c.x), TrailingZeros(c.y), TrailingZeros(c.z)};
+  int m = std::min(t[0], std::min(t[1], t[2]));
+  int32_t h = 1 << m;
+  int odd = (t[0] == m) + (t[1] == m) + (t[2] == m);
+  shape.type = 3 - odd;
+  shape.scale = h;
+
+  // The spine's direction alternates with the centre's position on the
+  // lattice of its scale: two odd axes point the same way when the centre sits
+  // at the same multiple of h, mod 4, on both
+  auto phase = [&](int axis) { return (c[axis] / h) & 3; };
+  glm::ivec3 d(0);
+  if (shape.type == 0) {
+    d = glm::ivec3(1, phase(1) == phase(0) ? 1 : -1, phase(2) == phase(0) ? 1 : -1);
+    static const glm::ivec3 ring[6] = {{1, 1, -1}, {1, -1, -1}, {1, -1, 1},
+                                       {-1, -1, 1}, {-1, 1, 1}, {-1, 1, -1}};
+    shape.ringSize = 6;
+    for (int i = 0; i < 6; i++)
+      shape.ring[i] = c + ring[i] * d * h;
+  } else if (shape.type == 1) {
+    int e = t[0] != m ? 0 : (t[1] != m ? 1 : 2);
+    int a = e == 0 ? 1 : 0;
+    int b = e == 2 ? 1 : 2;
+    d[a] = 1;
+    d[b] = phase(b) == phase(a) ? 1 : -1;
+    glm::ivec3 up(0);
+    up[e] = h;
+    glm::ivec3 across(0);
+    across[a] = h;
+    across[b] = -d[b] * h;
+    shape.ringSize = 4;
+    shape.ring[0] = c + up;
+    shape.ring[1] = c + across;
+    shape.ring[2] = c - up;
+    shape.ring[3] = c - across;
+  } else {
+    int a = t[0] == m ? 0 : (t[1] == m ? 1 : 2);
+    int u = a == 0 ? 1 : 0;
+    int v = a == 2 ? 1 : 2;
+    d[a] = 1;
+    static const int ring[8][2] = {{1, 0}, {1, 1}, {0, 1}, {-1, 1},
+                                   {-1, 0}, {-1, -1}, {0, -1}, {1, -1}};
+    shape.ringSize = 8;
+    for (int i = 0; i < 8; i++) {
+      glm::ivec3 offset(0);
+      offset[u] = ring[i][0] * h;
+      offset[v] = ring[i][1] * h;
+      shape.ring[i] = c + offset;
+    }
+  }
+  shape.spine[0] = c - d * h;
+  shape.spine[1] = c + d * h;
+
+  // On the volume's faces part of the ring is outside, those tets don't exist
+  shape.slots = 0;
+  for (uint32_t i = 0; i < shape.ringSize; i++) {
+    if (Inside(shape.ring[i]) && Inside(shape.ring[(i + 1) % shape.ringSize]))
+      shape.slots |= uint8_t(1 << i);
+  }
+  return shape;
+}
+
+uint32_t VolumeRefiner::SlotCount(const Shape& shape) const {
+  uint32_t count = 0;
+  for (uint32_t slot = 0; slot < shape.ringSize; slot++)
+    count += (shape.slots >> slot) & 1;
+  return count;
+}
+
+glm::ivec3 VolumeRefiner::ParentOf(const Shape& shape, uint32_t slot) const {
+  const glm::ivec3& a = shape.ring[slot];
+  const glm::ivec3& b = shape.ring[(slot + 1) % shape.ringSize];
+  return Level(a) > Level(b) ? a : b;
+}
+
+void VolumeRefiner::Children(const Shape& shape,
+                             const glm::ivec3& centre,
+                             glm::ivec3* children,
+                             uint32_t& count) const {
+  count = 0;
+  for (uint32_t slot = 0; slot < shape.ringSize; slot++) {
+    if (!(shape.slots & (1 << slot)))
+      continue;
+
+    // Each tet is bisected into two, their own spines name the children
+    for (int half = 0; half < 2; half++) {
+      glm::ivec3 v[4] = {shape.spine[half], centre, shape.ring[slot],
+                         shape.ring[(slot + 1) % shape.ringSize]};
+      int longest = -1;
+      glm::ivec3 mid(0);
+      for (auto& edge : TetEdges) {
+        int length = LengthSquared(v[edge[1]] - v[edge[0]]);
+        if (length > longest) {
+          longest = length;
+          mid = (v[edge[0]] + v[edge[1]]) / 2;
+        }
+      }
+      if (std::find(children, children + count, mid) == children + count)
+        children[count++] = mid;
+    }
+  }
+}
+
+float VolumeRefiner::DensityAt(const glm::ivec3& p) const {
+  // Every corner of a leaf tet is either a corner of the volume or the centre
+  // of a split diamond, which keeps its density
+  if (Level(p) < 0) {
+    int corner = (p.x > 0 ? 1 : 0) | (p.y > 0 ? 2 : 0) | (p.z > 0 ? 4 : 0);
+    return m_CornerDensity[corner];
+  }
+  uint32_t index = m_Table.Find(Key(p));
+  if (index != FlatTable::NotFound)
+    return m_Pool[index].density;
+  return m_Density(ToWorld(p));
+}
+
+bool VolumeRefiner::NearSurface(const Diamond& d) const {
+  float radius = ShapeRadius[d.type] * d.scale * m_CellSize;
+  return std::abs(d.density) <= m_Settings.slope * radius;
+}
+
+bool VolumeRefiner::CanSplit(const Diamond& d) const {
+  // The finest edge diamonds would put their children between lattice points
+  return !(d.type == 2 && d.scale == 1);
+}
+
+float VolumeRefiner::Error(const Diamond& d) const {
+  if (!CanSplit(d))
+    return 0.f;
+
+  // Nothing to refine where the surface can't reach
+  if (!NearSurface(d))
+    return 0.f;
+
+  float radius = ShapeRadius[d.type] * d.scale * m_CellSize;
+  float distance = glm::length(ToWorld(d.centre) - m_Camera) - radius;
+  return 2.f * radius / std::max(distance, m_CellSize * 0.5f);
+}
+
+uint32_t VolumeRefiner::Acquire(const glm::ivec3& centre) {
+  uint64_t key = Key(centre);
+  uint32_t index = m_Table.Find(key);
+  if (index != FlatTable::NotFound)
+    return index;
+  if (m_Live >= m_Settings.maxDiamonds)
+    return None;
+
+  if (!m_Free.empty()) {
+    index = m_Free.back();
+    m_Free.pop_back();
+  } else {
+    index = static_cast<uint32_t>(m_Pool.size());
+    m_Pool.emplace_back();
+  }
+
+  int t = std::min(TrailingZeros(centre.x),
+                   std::min(TrailingZeros(centre.y), TrailingZeros(centre.z)));
+  Diamond& d = m_Pool[index];
+  d.centre = centre;
+  d.density = m_Density(ToWorld(centre));
+  d.refs = 0;
+  d.splitChildren = 0;
+  d.flags = 0;
+  d.scale = 1 << t;
+  d.type = uint8_t(3 - ((TrailingZeros(centre.x) == t) + (TrailingZeros(centre.y) == t) +
+                        (TrailingZeros(centre.z) == t)));
+  d.error = Error(d);
+
+  m_Table.Insert(key, index);
+  m_Live++;
+  return index;
+}
+
+void VolumeRefiner::Release(uint32_t index) {
+  Diamond& d = m_Pool[index];
+  m_Table.Erase(Key(d.centre));
+  d.refs = 0;
+  d.flags = 0;
+  m_Free.push_back(index);
+  m_Live--;
+}
+
+bool VolumeRefiner::SplitDiamond(uint32_t index, uint32_t& budget) {
+  if (m_Pool[index].flags & Split)
+    return true;
+  if (budget == 0 || !CanSplit(m_Pool[index]))
+    return false;
+
+  // Up to 16 children come out of the pool
+  if (m_Live + 16 > m_Settings.maxDiamonds)
+    return false;
+
+  glm::ivec3 centre = m_Pool[index].centre;
+  Shape shape = ShapeOf(centre);
+
+  // The tets of this diamond only all exist once the diamonds they come from
+  // are split, split those first
+  uint32_t parents[8];
+  uint32_t parentCount = 0;
+  if (!(m_Pool[index].flags & Root)) {
+    for (uint32_t slot = 0; slot < shape.ringSize; slot++) {
+      if (!(shape.slots & (1 << slot)))
+        continue;
+      uint32_t parent = Acquire(ParentOf(shape, slot));
+      if (parent == None)
+        return false;
+      if (!SplitDiamond(parent, budget)) {
+        const Diamond& p = m_Pool[parent];
+        if (p.refs == 0 && !(p.flags & (Split | Root)))
+          Release(parent);
+        return false;
+      }
+      if (std::find(parents, parents + parentCount, parent) == parents + parentCount)
+        parents[parentCount++] = parent;
+    }
+  }
+
+  // Forced splits may have used up the budget or the pool
+  if (budget == 0 || m_Live + 16 > m_Settings.maxDiamonds)
+    return false;
+
+  glm::ivec3 children[16];
+  uint32_t childCount;
+  Children(shape, centre, children, childCount);
+  for (uint32_t i = 0; i < childCount; i++) {
+    uint32_t child = Acquire(children[i]);
+    m_Pool[child].refs++;
+  }
+  for (uint32_t i = 0; i < parentCount; i++)
+    m_Pool[parents[i]].splitChildren++;
+
+  // Every tet of the diamond is there now and is cut in two
+  m_Pool[index].flags |= Split;
+  m_SplitCount++;
+  m_TetCount += SlotCount(shape);
+  m_Stats.splits++;
+  budget--;
+
+  // The children are new candidates, worth looking at this update
+  for (uint32_t i = 0; i < childCount; i++) {
+    uint32_t child = m_Table.Find(Key(children[i]));
+    if (m_Pool[child].error > m_Settings.maxError) {
+      m_SplitQueue.push_back({m_Pool[child].error, child});
+      std::push_heap(m_SplitQueue.begin(), m_SplitQueue.end());
+    }
+  }
+  return true;
+}
+
+void VolumeRefiner::MergeDiamond(uint32_t index) {
+  glm::ivec3 centre = m_Pool[index].centre;
+  Shape shape = ShapeOf(centre);
+
+  glm::ivec3 children[16];
+  uint32_t childCount;
+  Children(shape, centre, children, childCount);
+  for (uint32_t i = 0; i < childCount; i++) {
+    uint32_t child = m_Table.Find(Key(children[i]));
+    if (--m_Pool[child].refs == 0)
+      Release(child);
+  }
+
+  m_Pool[index].flags &= uint8_t(~Split);
+  m_SplitCount--;
+  m_TetCount -= SlotCount(shape);
+  m_Stats.merges++;
+
+  if (m_Pool[index].flags & Root)
+    return;
+
+  // Parents with no split child left can be merged in turn
+  const float mergeError = m_Settings.maxError * m_Settings.mergeHysteresis;
+  uint32_t seen[8];
+  uint32_t seenCount = 0;
+  for (uint32_t slot = 0; slot < shape.ringSize; slot++) {
+    if (!(shape.slots & (1 << slot)))
+      continue;
+    uint32_t parent = m_Table.Find(Key(ParentOf(shape, slot)));
+    if (std::find(seen, seen + seenCount, parent) != seen + seenCount)
+      continue;
+    seen[seenCount++] = parent;
+
+    Diamond& p = m_Pool[parent];
+    if (--p.splitChildren == 0 && p.error < mergeError) {
+      m_MergeQueue.push_back({p.error, parent});
+      std::push_heap(m_MergeQueue.begin(), m_MergeQueue.end(),
+                     [](const QueueEntry& l, const QueueEntry& r) { return r < l; });
+    }
+  }
+}
+
+void VolumeRefiner::Reset() {
+  m_Pool.clear();
+  m_Free.clear();
+  m_Table.Clear();
+  m_Live = 0;
+  m_SplitCount = 0;
+
+  uint32_t root = Acquire(glm::ivec3(m_RootScale));
+  m_Pool[root].flags = Root;
+  m_TetCount = SlotCount(ShapeOf(m_Pool[root].centre));
+}
+
+const VolumeStats& VolumeRefiner::Update(const glm::vec3& camera) {
+  auto start = std::chrono::high_resolution_clock::now();
+  m_Stats = VolumeStats();
+  m_Camera = camera;
+
+  ParallelChunks(m_Pool.size(), ErrorChunk, [&](size_t begin, size_t end) {
+    for (size_t i = begin; i < end; i++) {
+      Diamond& d = m_Pool[i];
+      if (d.refs > 0 || (d.flags & Root))
+        d.error = Error(d);
+    }
+  });
+
+  const float mergeError = m_Settings.maxError * m_Settings.mergeHysteresis;
+  auto lowestFirst = [](const QueueEntry& l, const QueueEntry& r) { return r < l; };
+
+  m_SplitQueue.clear();
+  m_MergeQueue.clear();
+  for (uint32_t i = 0; i < m_Pool.size(); i++) {
+    const Diamond& d = m_Pool[i];
+    if (d.refs == 0 && !(d.flags & Root))
+      continue;
+    if (d.flags & Split) {
+      if (d.splitChildren == 0 && d.error < mergeError)
+        m_MergeQueue.push_back({d.error, i});
+    } else if (d.error > m_Settings.maxError) {
+      m_SplitQueue.push_back({d.error, i});
+    }
+  }
+  std::make_heap(m_SplitQueue.begin(), m_SplitQueue.end());
+  std::make_heap(m_MergeQueue.begin(), m_MergeQueue.end(), lowestFirst);
+
+  // Merges first, they make room in the pool for the splits. Entries are
+  // checked when they come off a queue, what they point at may have changed
+  // since they went on
+  uint32_t merges = 0;
+  while (!m_MergeQueue.empty() && merges < m_Settings.maxMergesPerUpdate) {
+    std::pop_heap(m_MergeQueue.begin(), m_MergeQueue.end(), lowestFirst);
+    QueueEntry entry = m_MergeQueue.back();
+    m_MergeQueue.pop_back();
+
+    const Diamond& d = m_Pool[entry.diamond];
+    if ((d.refs == 0 && !(d.flags & Root)) || !(d.flags & Split) ||
+        d.splitChildren != 0)
+      continue;
+    MergeDiamond(entry.diamond);
+    merges++;
+  }
+
+  uint32_t budget = m_Settings.maxSplitsPerUpdate;
+  while (!m_SplitQueue.empty()) {
+    std::pop_heap(m_SplitQueue.begin(), m_SplitQueue.end());
+    QueueEntry entry = m_SplitQueue.back();
+    m_SplitQueue.pop_back();
+
+    const Diamond& d = m_Pool[entry.diamond];
+    if ((d.refs == 0 && !(d.flags & Root)) || (d.flags & Split))
+      continue;
+    if (!SplitDiamond(entry.diamond, budget)) {
+      m_Stats.deferred += 1 + static_cast<uint32_t>(m_SplitQueue.size());
+      break;
+    }
+  }
+
+  m_Stats.diamonds = m_Live;
+  m_Stats.splitDiamonds = m_SplitCount;
+  m_Stats.tets = m_TetCount;
+  m_Stats.bytes = m_Pool.capacity() * sizeof(Diamond) +
+                  m_Free.capacity() * sizeof(uint32_t) + m_Table.Bytes() +
+                  (m_SplitQueue.capacity() + m_MergeQueue.capacity()) * sizeof(QueueEntry);
+  m_Stats.updateMs = std::chrono::duration<double, std::milli>(
+                         std::chrono::high_resolution_clock::now() - start)
+                         .count();
+  return m_Stats;
+}
+
+void VolumeRefiner::Tets(std::vector<TetRef>& tets) const {
+  CollectTets(tets, false);
+}
+
+void VolumeRefiner::CollectTets(std::vector<TetRef>& tets, bool nearSurface) const {
+  tets.clear();
+  for (uint32_t i = 0; i < m_Pool.size(); i++) {
+    const Diamond& d = m_Pool[i];
+    if ((d.refs == 0 && !(d.flags & Root)) || (d.flags & Split))
+      continue;
+    if (nearSurface && !NearSurface(d))
+      continue;
+
+    // A slot's tet is there once the diamond it was cut from is split,
+    // otherwise that coarser tet covers it
+    Shape shape = ShapeOf(d.centre);
+    for (uint32_t slot = 0; slot < shape.ringSize; slot++) {
+      if (!(shape.slots & (1 << slot)))
+        continue;
+      if (!(d.flags & Root)) {
+        uint32_t parent = m_Table.Find(Key(ParentOf(shape, slot)));
+        if (parent == FlatTable::NotFound || !(m_Pool[parent].flags & Split))
+          continue;
+      }
+      TetRef tet;
+      tet.id = i * 8 + slot;
+      tet.v[0] = shape.spine[0];
+      tet.v[1] = shape.spine[1];
+      tet.v[2] = shape.ring[slot];
+      tet.v[3] = shape.ring[(slot + 1) % shape.ringSize];
+      tets.push_back(tet);
+    }
+  }
+}
+
+void VolumeRefiner::ExtractSurface(std::vector<glm::vec3>& vertices,
+                                   std::vector<uint32_t>& indices) const {
+  vertices.clear();
+  indices.clear();
+
+  // Tets of diamonds the surface can't reach are skipped without looking at
+  // their corners
+  std::vector<TetRef> tets;
+  CollectTets(tets, true);
+
+  // Edge vertices are keyed by their lower end and the direction to the other
+  // one, no two mesh edges leave a point the same way
+  FlatTable edges(tets.size());
+  auto edgeVertex = [&](const glm::ivec3& a, float da, const glm::ivec3& b,
+                        float db) {
+    bool swap = Key(b) < Key(a);
+    const glm::ivec3& lo = swap ? b : a;
+    const glm::ivec3& hi = swap ? a : b;
+    glm::ivec3 step = glm::sign(hi - lo) + 1;
+    uint64_t key = (Key(lo) << 5) | uint64_t(step.x * 9 + step.y * 3 + step.z);
+
+    uint32_t index = static_cast<uint32_t>(vertices.size());
+    uint32_t found = edges.Insert(key, index);
+    if (found != index)
+      return found;
+
+    float t = da / (da - db);
+    vertices.push_back(glm::mix(ToWorld(a), ToWorld(b), t));
+    return index;
+  };
+
+  for (auto& tet : tets) {
+    float density[4];
+    int inside[4];
+    int outside[4];
+    int insideCount = 0;
+    int outsideCount = 0;
+    for (int i = 0; i < 4; i++) {
+      density[i] = DensityAt(tet.v[i]);
+      if (density[i] > 0.f)
+        inside[insideCount++] = i;
+      else
+        outside[outsideCount++] = i;
+    }
+    if (insideCount == 0 || outsideCount == 0)
+      continue;
+
+    auto edge = [&](int a, int b) {
+      return edgeVertex(tet.v[a], density[a], tet.v[b], density[b]);
+    };
+
+    uint32_t polygon[4];
+    uint32_t corners;
+    if (insideCount == 1) {
+      corners = 3;
+      for (int i = 0; i < 3; i++)
+        polygon[i] = edge(inside[0], outside[i]);
+    } else if (outsideCount == 1) {
+      corners = 3;
+      for (int i = 0; i < 3; i++)
+        polygon[i] = edge(inside[i], outside[0]);
+    } else {
+      corners = 4;
+      polygon[0] = edge(inside[0], outside[0]);
+      polygon[1] = edge(inside[0], outside[1]);
+      polygon[2] = edge(inside[1], outside[1]);
+      polygon[3] = edge(inside[1], outside[0]);
+    }
+
+    // Faces point from the inside corners towards the outside ones
+    glm::vec3 in(0.f);
+    glm::vec3 out(0.f);
+    for (int i = 0; i < insideCount; i++)
+      in += ToWorld(tet.v[inside[i]]) / float(insideCount);
+    for (int i = 0; i < outsideCount; i++)
+      out += ToWorld(tet.v[outside[i]]) / float(outsideCount);
+    glm::vec3 normal = glm::cross(vertices[polygon[1]] - vertices[polygon[0]],
+                                  vertices[polygon[2]] - vertices[polygon[0]]);
+    bool flip = glm::dot(normal, out - in) < 0.f;
+
+    for (uint32_t i = 1; i + 1 < corners; i++) {
+      indices.push_back(polygon[0]);
+      indices.push_back(polygon[flip ? i + 1 : i]);
+      indices.push_back(polygon[flip ? i : i + 1]);
+    }
+  }
+}
+
+bool VolumeRefiner::Validate(std::string& error) const {
+  auto fail = [&](const std::string& what) {
+    error = what;
+    return false;
+  };
+  auto live = [](const Diamond& d) { return d.refs > 0 || (d.flags & Root); };
+
+  // What every live diamond should count: each split diamond references its
+  // children, and is counted by each of its parents as a split child
+  std::map<uint32_t, uint32_t> refs;
+  std::map<uint32_t, uint32_t> splitChildren;
+  uint32_t liveCount = 0;
+  uint32_t splitCount = 0;
+  for (uint32_t i = 0; i < m_Pool.size(); i++) {
+    const Diamond& d = m_Pool[i];
+    if (!live(d))
+      continue;
+    liveCount++;
+    if (m_Table.Find(Key(d.centre)) != i)
+      return fail("diamond " + std::to_string(i) + " missing from the table");
+    if (!(d.flags & Split))
+      continue;
+    splitCount++;
+
+    Shape shape = ShapeOf(d.centre);
+    glm::ivec3 children[16];
+    uint32_t childCount;
+    Children(shape, d.centre, children, childCount);
+    for (uint32_t c = 0; c < childCount; c++) {
+      uint32_t child = m_Table.Find(Key(children[c]));
+      if (child == FlatTable::NotFound)
+        return fail("child of split diamond " + std::to_string(i) + " missing");
+      refs[child]++;
+
+      Shape childShape = ShapeOf(children[c]);
+      bool linked = false;
+      for (uint32_t slot = 0; slot < childShape.ringSize; slot++)
+        if ((childShape.slots & (1 << slot)) &&
+            ParentOf(childShape, slot) == d.centre)
+          linked = true;
+      if (!linked)
+        return fail("diamond " + std::to_string(i) +
+                    " is not a parent of its child");
+    }
+
+    if (d.flags & Root)
+      continue;
+    std::set<uint32_t> parents;
+    for (uint32_t slot = 0; slot < shape.ringSize; slot++) {
+      if (!(shape.slots & (1 << slot)))
+        continue;
+      uint32_t parent = m_Table.Find(Key(ParentOf(shape, slot)));
+      if (parent == FlatTable::NotFound || !(m_Pool[parent].flags & Split))
+        return fail("split diamond " + std::to_string(i) +
+                    " has a parent that isn't split");
+      parents.insert(parent);
+    }
+    for (auto parent : parents)
+      splitChildren[parent]++;
+  }
+
+  if (liveCount != m_Live || m_Table.Size() != m_Live)
+    return fail("live count " + std::to_string(m_Live) + ", counted " +
+                std::to_string(liveCount) + ", table holds " +
+                std::to_string(m_Table.Size()));
+  if (splitCount != m_SplitCount)
+    return fail("split count " + std::to_string(m_SplitCount) + ", counted " +
+                std::to_string(splitCount));
+
+  for (uint32_t i = 0; i < m_Pool.size(); i++) {
+    const Diamond& d = m_Pool[i];
+    if (!live(d))
+      continue;
+    if (!(d.flags & Root) && refs[i] != d.refs)
+      return fail("diamond " + std::to_string(i) + " has " +
+                  std::to_string(d.refs) + " references, counted " +
+                  std::to_string(refs[i]));
+    if (splitChildren[i] != d.splitChildren)
+      return fail("diamond " + std::to_string(i) + " has " +
+                  std::to_string(d.splitChildren) + " split children, counted " +
+                  std::to_string(splitChildren[i]));
+  }
+
+  // Conforming: the tets add up to the cube (six times the volume, in lattice
+  // units) and every face inside it is shared by two of them
+  std::vector<TetRef> tets;
+  Tets(tets);
+  if (tets.size() != m_TetCount)
+    return fail("tet count " + std::to_string(m_TetCount) + ", collected " +
+                std::to_string(tets.size()));
+
+  typedef std::array<int32_t, 3> Point;
+  int64_t size = 2 * int64_t(m_RootScale);
+  int64_t volume = 0;
+  std::map<std::array<Point, 3>, uint32_t> faces;
+  for (auto& tet : tets) {
+    glm::ivec3 a = tet.v[1] - tet.v[0];
+    glm::ivec3 b = tet.v[2] - tet.v[0];
+    glm::ivec3 c = tet.v[3] - tet.v[0];
+    int64_t det = int64_t(a.x) * (int64_t(b.y) * c.z - int64_t(b.z) * c.y) -
+                  int64_t(a.y) * (int64_t(b.x) * c.z - int64_t(b.z) * c.x) +
+                  int64_t(a.z) * (int64_t(b.x) * c.y - int64_t(b.y) * c.x);
+    volume += det < 0 ? -det : det;
+
+    for (int skip = 0; skip < 4; skip++) {
+      std::array<Point, 3> face;
+      int n = 0;
+      for (int v = 0; v < 4; v++)
+        if (v != skip)
+          face[n++] = {tet.v[v].x, tet.v[v].y, tet.v[v].z};
+      std::sort(face.begin(), face.end());
+      faces[face]++;
+    }
+  }
+  if (volume != 6 * size * size * size)
+    return fail("tets cover " + std::to_string(volume) + " of " +
+                std::to_string(6 * size * size * size));
+
+  for (auto& face : faces) {
+    bool boundary = false;
+    for (int axis = 0; axis < 3; axis++) {
+      bool low = true, high = true;
+      for (auto& point : face.first) {
+        low = low && point[axis] == 0;
+        high = high && point[axis] == size;
+      }
+      boundary = boundary || low || high;
+    }
+    if (face.second != (boundary ? 1u : 2u))
+      return fail(std::string(boundary ? "boundary" : "inside") +
+                  " face shared by " + std::to_string(face.second) + " tets");
+  }
+  return true;
+}
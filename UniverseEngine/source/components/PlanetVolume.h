@@ -0,0 +1,205 @@
+#pragma once
+
+#include <stdint.h>
+#include <functional>
+#include <string>
+#include <vector>
+#include "../3dmaths.h"
+
+namespace uni
+{
+	namespace planet
+	{
+		/**
+		* @brief Open addressing hash table from 64 bit keys to 32 bit values
+		*
+		* Linear probing over a power of two array, deletion shifts the following entries back so there are no
+		* tombstones. Key 0 marks an empty slot and can't be stored.
+		*/
+		class FlatTable {
+		public:
+			static const uint32_t NotFound = ~0u;
+
+			explicit FlatTable(size_t capacity = 1024);
+
+			uint32_t Find(uint64_t key) const;
+			/** @brief Value stored under key, value is stored first if there is none */
+			uint32_t Insert(uint64_t key, uint32_t value);
+			bool Erase(uint64_t key);
+			void Clear();
+
+			size_t Size() const { return m_Size; }
+			size_t Bytes() const { return m_Keys.size() * (sizeof(uint64_t) + sizeof(uint32_t)); }
+
+		private:
+			std::vector<uint64_t> m_Keys;
+			std::vector<uint32_t> m_Values;
+			size_t m_Mask;
+			size_t m_Size = 0;
+
+			size_t Slot(uint64_t key) const;
+			void Grow();
+		};
+
+		/** @brief Counters of one VolumeRefiner::Update, diamonds and tets are what is live afterwards */
+		struct VolumeStats {
+			uint32_t diamonds = 0;
+			uint32_t splitDiamonds = 0;
+			uint32_t tets = 0;
+			/** @brief Includes the splits forced on coarser neighbours to keep the mesh conforming */
+			uint32_t splits = 0;
+			uint32_t merges = 0;
+			/** @brief Diamonds that wanted a split but didn't get one, budgets or pool full */
+			uint32_t deferred = 0;
+			size_t bytes = 0;
+			double updateMs = 0.0;
+		};
+
+		/**
+		* @brief Adaptive tetrahedral mesh of a volume, refined around a density function's zero surface
+		*
+		* The volume is the cube [-extent, extent]^3, cut into a hierarchy of diamonds on an integer lattice of
+		* 2^(depth + 1) cells per edge. A diamond is the set of tets sharing one longest edge (its spine) and is named by
+		* the lattice point in the middle of it; its class, scale, spine and the tets around it all follow from that
+		* point, so nothing but the point and a few counters is stored. Splitting a diamond bisects all its tets at once,
+		* which keeps the mesh conforming, and splits the diamonds it depends on first.
+		*
+		* Diamonds live in a pool and are found through a FlatTable keyed by their lattice point. A tet is named by its
+		* diamond's index and its slot around the spine. Each Update refines towards the camera with a split queue and a
+		* merge queue ordered by view error, both bounded per frame.
+		*
+		* Not thread safe, one thread updates and reads a refiner.
+		*/
+		class VolumeRefiner {
+		public:
+			/** @brief Positive inside, roughly the distance to the surface (see Settings::slope) */
+			using DensityFunc = std::function<float(const glm::vec3&)>;
+
+			struct Settings {
+				/** @brief Levels of scale below the root, the finest cell is extent / 2^depth (at most 17) */
+				uint32_t depth = 12;
+				/** @brief Largest spine length over distance to the camera that is left unsplit */
+				float maxError = 0.1f;
+				/** @brief Merging waits until the error is this much below maxError, so diamonds don't flicker */
+				float mergeHysteresis = 0.75f;
+				/** @brief Largest change of density per unit of distance, for deciding what can't touch the surface */
+				float slope = 1.5f;
+				uint32_t maxDiamonds = 1 << 20;
+				uint32_t maxSplitsPerUpdate = 4096;
+				uint32_t maxMergesPerUpdate = 8192;
+			};
+
+			/** @brief Tet as its four lattice corners, v0 and v1 are the spine */
+			struct TetRef {
+				uint32_t id;
+				glm::ivec3 v[4];
+			};
+
+			VolumeRefiner(DensityFunc density, float extent, const Settings& settings);
+			VolumeRefiner(DensityFunc density, float extent) : VolumeRefiner(density, extent, Settings()) {}
+
+			VolumeRefiner(const VolumeRefiner&) = delete;
+			VolumeRefiner& operator=(const VolumeRefiner&) = delete;
+
+			/** @brief Split and merge towards the view from camera, in the volume's space */
+			const VolumeStats& Update(const glm::vec3& camera);
+			/** @brief Back to the six root tets */
+			void Reset();
+
+			/** @brief The conforming leaf tets, id is diamond index * 8 + slot */
+			void Tets(std::vector<TetRef>& tets) const;
+			/** @brief Marching tetrahedra over the leaf tets, vertices are shared along edges */
+			void ExtractSurface(std::vector<glm::vec3>& vertices, std::vector<uint32_t>& indices) const;
+
+			glm::vec3 ToWorld(const glm::ivec3& lattice) const;
+			const VolumeStats& Stats() const { return m_Stats; }
+
+			/**
+			* Recount everything from scratch and check it against what the refiner keeps: the table, reference and split
+			* child counts, and that the leaf tets fill the cube with every inside face shared by exactly two. Slow, for
+			* tests and benchmarks.
+			*
+			* @return False with the first problem found in error
+			*/
+			bool Validate(std::string& error) const;
+
+		private:
+			static const uint32_t None = ~0u;
+
+			enum DiamondFlags : uint8_t {
+				Split = 1,
+				Root = 2
+			};
+
+			struct Diamond {
+				glm::ivec3 centre;
+				float density;
+				float error;
+				/** @brief Split parents, the diamond goes back to the pool when none are left */
+				uint8_t refs;
+				uint8_t splitChildren;
+				uint8_t flags;
+				uint8_t type;
+				int32_t scale;
+			};
+
+			/** @brief Spine, tets around it and what a diamond hangs off, worked out from its centre */
+			struct Shape {
+				uint32_t type;
+				int32_t scale;
+				glm::ivec3 spine[2];
+				uint32_t ringSize;
+				glm::ivec3 ring[8];
+				/** @brief Slots whose tet is inside the volume */
+				uint8_t slots;
+			};
+
+			struct QueueEntry {
+				float error;
+				uint32_t diamond;
+				bool operator<(const QueueEntry& rhs) const { return error < rhs.error; }
+			};
+
+			DensityFunc m_Density;
+			Settings m_Settings;
+			float m_Extent;
+			int32_t m_RootScale;
+			float m_CellSize;
+			glm::vec3 m_Camera = glm::vec3(0.f);
+			float m_CornerDensity[8];
+
+			std::vector<Diamond> m_Pool;
+			std::vector<uint32_t> m_Free;
+			FlatTable m_Table;
+			uint32_t m_Live = 0;
+			uint32_t m_SplitCount = 0;
+			uint32_t m_TetCount = 0;
+
+			std::vector<QueueEntry> m_SplitQueue;
+			std::vector<QueueEntry> m_MergeQueue;
+			VolumeStats m_Stats;
+
+			uint64_t Key(const glm::ivec3& p) const;
+			bool Inside(const glm::ivec3& p) const;
+			/** @brief Level of a lattice point, finer points are higher and the volume's corners are -1 */
+			int32_t Level(const glm::ivec3& p) const;
+			Shape ShapeOf(const glm::ivec3& centre) const;
+			uint32_t SlotCount(const Shape& shape) const;
+			/** @brief The diamond whose split made a tet, its newest ring corner */
+			glm::ivec3 ParentOf(const Shape& shape, uint32_t slot) const;
+			void Children(const Shape& shape, const glm::ivec3& centre, glm::ivec3* children, uint32_t& count) const;
+			float DensityAt(const glm::ivec3& p) const;
+			void CollectTets(std::vector<TetRef>& tets, bool nearSurface) const;
+
+			uint32_t Acquire(const glm::ivec3& centre);
+			void Release(uint32_t index);
+			/** @brief Split index after everything it depends on, false when a budget or the pool ran out */
+			bool SplitDiamond(uint32_t index, uint32_t& budget);
+			void MergeDiamond(uint32_t index);
+			bool CanSplit(const Diamond& d) const;
+			/** @brief Whether the density at the centre lets the surface into the diamond's bounding sphere */
+			bool NearSurface(const Diamond& d) const;
+			float Error(const Diamond& d) const;
+		};
+	}
+}
@@ -5,8 +5,57 @@ using namespace uni::components;
 
 void TransformComponent::SetParent(std::shared_ptr<uni::scene::SceneObject> parent) {
 	m_Parent = parent;
+	MarkDirty();
 };
 
+bool TransformComponent::IsCacheValid() const {
+	if(m_Dirty || m_UpdatedFrame == 0)
+		return false;
+	if(!m_Parent)
+		return true;
+
+	// The parent was moved, or recalculated since this one was, so the product is out of date
+	auto parent = m_Parent->GetTransform();
+	return parent->m_WorldVersion == m_ParentWorldVersion && parent->IsCacheValid();
+}
+
+void TransformComponent::UpdateHierarchy(uint32_t frame) {
+	if(m_UpdatedFrame == frame)
+		return;
+	m_UpdatedFrame = frame;
+
+	bool changed = m_Dirty;
+	if(m_Dirty)
+		m_LocalMat = CalculateLocalMat();
+
+	if(m_Parent) {
+		auto parent = m_Parent->GetTransform();
+		parent->UpdateHierarchy(frame);
+
+		if(changed || parent->m_WorldVersion != m_ParentWorldVersion) {
+			m_WorldMat = parent->m_WorldMat * m_LocalMat;
+			m_WorldRotation = m_Rotation * parent->m_WorldRotation;
+			m_ParentWorldVersion = parent->m_WorldVersion;
+			changed = true;
+		}
+	} else if(changed) {
+		m_WorldMat = m_LocalMat;
+		m_WorldRotation = m_Rotation;
+	}
+
+	if(changed) {
+		m_InverseWorldMat = glm::inverse(m_WorldMat);
+		m_WorldVersion++;
+	}
+
+	m_Dirty = false;
+}
+
+glm::dmat4 TransformComponent::CalculateLocalMat() const {
+	glm::dmat4 mat = glm::dmat4(1.0);
+	return glm::translate(mat, m_dPos) * glm::dmat4(glm::mat3(m_Right, m_Up, m_Forward)) * glm::scale(mat, (glm::dvec3)m_Scale);
+}
+
 void TransformComponent::SetPosition(const glm::vec3 &pos) {
 	SetPosition(pos.x, pos.y, pos.z);
 }
@@ -16,6 +65,7 @@ void TransformComponent::SetRotation(const glm::dvec3 &angleAxis) {
 	auto axis = glm::normalize(angleAxis);
 	if(degrees != 0.0 && glm::length(axis) != 0.0)
 		m_Rotation = glm::angleAxis(glm::radians(degrees), axis);
+	MarkDirty();
 }
 
 glm::vec3 TransformComponent::TransformLocalToWS(glm::vec3 localPos) {
@@ -26,8 +76,18 @@ glm::vec3 TransformComponent::GetPosition() {
 	return TransformLocalToWS(glm::vec3(0));
 }
 
+glm::dvec3 TransformComponent::GetWorldPosition() {
+	if(!m_Parent)
+		return m_dPos;
+
+	if(IsCacheValid())
+		return glm::dvec3(m_WorldMat[3]);
+
+	return glm::dvec3(m_Parent->GetTransform()->GetModelMatDouble() * glm::dvec4(m_dPos, 1.0));
+}
+
 glm::vec3 TransformComponent::TransformWSToLocal(glm::vec3 wsPos) {
-	return glm::vec3(glm::inverse(GetModelMat()) * glm::vec4(wsPos, 1.0));
+	return glm::vec3(GetInverseModelMatDouble() * glm::dvec4(wsPos, 1.0));
 }
 
 glm::vec3 TransformComponent::TransformLocalDirectionToWorldSpace(glm::vec3 wsPos) {
@@ -47,18 +107,21 @@ void TransformComponent::SetPosition(float x, float y, float z) {
 	m_dPos.x = (double)x;
 	m_dPos.y = (double)y;
 	m_dPos.z = (double)z;
+	MarkDirty();
 }
 
 void TransformComponent::SetPosition(double x, double y, double z) {
 	m_dPos.x = x;
 	m_dPos.y = y;
 	m_dPos.z = z;
+	MarkDirty();
 }
 
 void TransformComponent::SetScale(const glm::vec3 &scale) {
 	m_Scale.x = scale.x;
 	m_Scale.y = scale.y;
 	m_Scale.z = scale.z;
+	MarkDirty();
 }
 
 void TransformComponent::Rotate(glm::vec3 axis, float degrees) {
@@ -87,6 +150,7 @@ void TransformComponent::Rotate(glm::quat q) {
 	m_Right = m[0];
 	m_Up = m[1];
 	m_Forward = m[2];
+	MarkDirty();
 }
 
 void TransformComponent::RotateToTarget(glm::vec3 target) {
@@ -100,18 +164,22 @@ void TransformComponent::RotateToTarget(glm::vec3 target) {
 	m_Right = rotQ * m_Right;
 
 	m_Rotation = glm::quat(glm::mat3(m_Right, m_Up, m_Forward));
+	MarkDirty();
 }
 
 void TransformComponent::MoveForward(double distance) {
 	m_dPos += (glm::dvec3)glm::normalize(m_Forward) * distance;
+	MarkDirty();
 }
 
 void TransformComponent::MoveForward(float distance) {
 	m_dPos += glm::normalize(m_Forward) * distance;
+	MarkDirty();
 }
 
 void TransformComponent::MoveWorld(glm::dvec3 velocity) {
 	m_dPos += velocity;
+	MarkDirty();
 
 	//std::cout << "Position now: " << m_dPos.x << ", " << m_dPos.y << ", " << m_dPos.z << std::endl;
 }
@@ -120,11 +188,15 @@ void TransformComponent::MoveRelative(glm::dvec3 velocity) {
 	m_dPos += (glm::dvec3)m_Right * velocity.x;
 	m_dPos += (glm::dvec3)m_Up * velocity.y;
 	m_dPos += (glm::dvec3)m_Forward * velocity.z;
+	MarkDirty();
 
 	//std::cout << "Position now: " << m_dPos.x << ", " << m_dPos.y << ", " << m_dPos.z << std::endl;
 }
 
 glm::quat TransformComponent::GetRotation() {
+	if(IsCacheValid())
+		return m_WorldRotation;
+
 	auto rot = m_Rotation;
 	if(m_Parent) {
 		rot *= m_Parent->GetTransform()->GetRotation();
@@ -134,23 +206,35 @@ glm::quat TransformComponent::GetRotation() {
 }
 
 glm::mat4 TransformComponent::GetModelMat() {
+	return GetModelMatDouble();
+}
 
-	glm::dmat4 mat = glm::dmat4(1.0);
-	mat = glm::translate(mat, m_dPos) * glm::dmat4(glm::mat3(m_Right, m_Up, m_Forward)) * glm::scale(mat, (glm::dvec3)m_Scale);
+glm::dmat4 TransformComponent::GetModelMatDouble() {
+	if(IsCacheValid())
+		return m_WorldMat;
+
+	glm::dmat4 mat = CalculateLocalMat();
 
 	if(m_Parent) {
-		mat = glm::dmat4(m_Parent->GetTransform()->GetModelMat()) * mat;
+		mat = m_Parent->GetTransform()->GetModelMatDouble() * mat;
 	}
 
 	return mat;
 }
 
+glm::dmat4 TransformComponent::GetInverseModelMatDouble() {
+	if(IsCacheValid())
+		return m_InverseWorldMat;
+
+	return glm::inverse(GetModelMatDouble());
+}
+
 glm::mat4 TransformComponent::GetObjectMat() {
 
 	glm::dmat4 mat = glm::dmat4(1.0);
 
 	if(m_Parent) {
-		mat = glm::dmat4(m_Parent->GetTransform()->GetModelMat()) * mat;
+		mat = m_Parent->GetTransform()->GetModelMatDouble() * mat;
 	}
 
 	return mat;
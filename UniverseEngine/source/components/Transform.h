@@ -46,6 +46,25 @@ namespace uni {
 
       std::shared_ptr<uni::scene::SceneObject> m_Parent;
 
+      // Matrices cached by UpdateHierarchy, once per frame. Anything writing the fields above directly must call
+      // MarkDirty(); until the next update, getters compute the result on the fly without touching the cache, so
+      // they stay safe to call from several threads. Only the moved transform is marked, its children see it
+      // through the parent's world version they were last computed against.
+      glm::dmat4 m_LocalMat = glm::dmat4(1.0);
+      glm::dmat4 m_WorldMat = glm::dmat4(1.0);
+      glm::dmat4 m_InverseWorldMat = glm::dmat4(1.0);
+      glm::quat m_WorldRotation = glm::identity<glm::quat>();
+      bool m_Dirty = true;
+      uint32_t m_WorldVersion = 0;
+      uint32_t m_ParentWorldVersion = 0;
+      uint32_t m_UpdatedFrame = 0;
+
+      void MarkDirty() { m_Dirty = true; }
+      /** @brief true if the cached world matrix is current for this transform and all its parents */
+      bool IsCacheValid() const;
+      /** @brief refresh cached matrices for this transform and its parents, each at most once per frame */
+      void UpdateHierarchy(uint32_t frame);
+
       void SetParent(std::shared_ptr<uni::scene::SceneObject> parent);
 
       void SetPosition(const glm::vec3& pos);
@@ -53,6 +72,8 @@ namespace uni {
       glm::vec3 TransformLocalToWS(glm::vec3 localPos);
 
       glm::vec3 GetPosition();
+      /** @brief world space position without going through single precision */
+      glm::dvec3 GetWorldPosition();
 
       glm::vec3 TransformWSToLocal(glm::vec3 wsPos);
 
@@ -87,10 +108,18 @@ namespace uni {
 
       glm::quat GetRotation();
       glm::mat4 GetModelMat();
+      glm::dmat4 GetModelMatDouble();
+      glm::dmat4 GetInverseModelMatDouble();
 
       glm::mat4 GetObjectMat();
 
+    private:
+      glm::dmat4 CalculateLocalMat() const;
+
     };
   }
 
-}
\ No newline at end of file
+}
+
+// Moving a transform only moves a shared_ptr, so it is safe to keep inline in archetype storage.
+ECS_PACKED_COMPONENT(uni::components::TransformComponent);
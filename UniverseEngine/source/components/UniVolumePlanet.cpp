@@ -35,56 +35,21 @@ void UniVolumePlanet::Destroy() {
 
 void UniVolumePlanet::Initialize() {
 
-	std::vector<Tet> tets;
-	double u = pow(2.0, m_Divisions);
-	
-	tets.emplace_back(glm::dvec3(0, 0, 0), glm::dvec3(u, u, u), glm::dvec3(u, u, 0), glm::dvec3(u, 0, 0));
-	tets.emplace_back(glm::dvec3(0, 0, 0), glm::dvec3(u, u, u), glm::dvec3(u, u, 0), glm::dvec3(0, u, 0));
-	tets.emplace_back(glm::dvec3(0, 0, 0), glm::dvec3(u, u, u), glm::dvec3(0, u, u), glm::dvec3(0, 0, u));
-	tets.emplace_back(glm::dvec3(0, 0, 0), glm::dvec3(u, u, u), glm::dvec3(0, u, u), glm::dvec3(0, u, 0));
-	tets.emplace_back(glm::dvec3(0, 0, 0), glm::dvec3(u, u, u), glm::dvec3(u, 0, u), glm::dvec3(u, 0, 0));	
-	tets.emplace_back(glm::dvec3(0, 0, 0), glm::dvec3(u, u, u), glm::dvec3(u, 0, u), glm::dvec3(0, 0, u));
-	
-	for(auto& tet : tets) {
-
-		tet.CalculateLongestEdge();
+	m_TerrainNoise.SetNoiseType(FastNoise::SimplexFractal);
+	m_TerrainNoise.SetFractalOctaves(5);
+	m_TerrainNoise.SetFrequency(1.5f / (float)m_Radius);
 
-		auto le = tet.le;
-		auto d = tet.d;
+	m_CaveNoise.SetSeed(7331);
+	m_CaveNoise.SetNoiseType(FastNoise::Simplex);
+	m_CaveNoise.SetFrequency(8.f / (float)m_Radius);
 
-		auto dir = le.second - le.first;
-		dir /= u;
-
-		auto u2 = u / 2.0;
-
-		if(diamond_map.find(d->pos) == diamond_map.end()) {
-			diamond_map[d->pos] = d;
-			d->type = static_cast<uint32_t>(std::distance(diamond_types.begin(), diamond_types.insert(dir).first));
-		}
-
-		std::cout << "Made a tet with diamond centre: " << d->pos.x << ", " << d->pos.y << ", " << d->pos.z << std::endl;
-		std::cout << "Longest edge direction: " << dir.x << ", " << dir.y << ", " << dir.z << std::endl;
-
-		if(offset_map.find(d->type) == offset_map.end()) {
-			auto od = OffsetLookup();
-			offset_map[d->type] = od;
-		}
-		Tet tt = Tet((d->pos - tet.v0) / u2, (d->pos - tet.v1) / u2, (d->pos - tet.v2) / u2, (d->pos - tet.v3) / u2);
-		offset_map[d->type].tets.insert(tt);
-
-	}
-
-	for(auto& kv : offset_map) {
-		auto tCount = 0;
-		for(auto& t : kv.second.tets) {
-			for(auto& v : { t.v0, t.v1, t.v2, t.v3 }) {
-				std::cout << "Found diamond type " << kv.first << ", tet " << tCount << ": " << v.x << ", " << v.y << ", " << v.z << std::endl;
-			}
-			tCount++;
-		}
-
-	}
+	uni::planet::VolumeRefiner::Settings settings;
+	settings.depth = m_Divisions;
+	//The noise makes the density change a little faster than the distance to the surface
+	settings.slope = 2.f;
 
+	float extent = (float)(m_Radius * (1.0 + m_MaxHeightOffset) * 1.1);
+	m_Volume = std::make_unique<uni::planet::VolumeRefiner>([this](const glm::vec3& pos) { return GetDensity(pos); }, extent, settings);
 
 	/*
 	auto& engine = UniEngine::GetInstance();
@@ -224,6 +189,29 @@ void UniVolumePlanet::UpdateMesh() {
 }
 
 
+float UniVolumePlanet::GetDensity(const glm::vec3& pos) {
+	float distance = glm::length(pos);
+	float height = (float)(m_Radius * m_MaxHeightOffset);
+	float depth = (float)(m_Radius * m_MaxDepthOffset);
+
+	//Heightfield for the ground, 3D noise on top of it leans it over into overhangs
+	glm::vec3 dir = distance > 0.f ? pos / distance : glm::vec3(0.f, 1.f, 0.f);
+	glm::vec3 ground = dir * (float)m_Radius;
+	float surface = (float)m_Radius + height * (0.5f + 0.5f * m_TerrainNoise.GetNoise(ground.x, ground.y, ground.z));
+	float density = surface - distance + height * 0.35f * m_TerrainNoise.GetNoise(pos.x, pos.z, pos.y);
+
+	//Caves are the thin shells where the cave noise crosses zero, only down to the max depth
+	float cave = (std::abs(m_CaveNoise.GetNoise(pos.x, pos.y, pos.z)) - 0.06f) * depth;
+	cave += std::max(0.f, (float)(m_Radius - depth) - distance);
+	return std::min(density, cave);
+}
+
+const uni::planet::VolumeStats& UniVolumePlanet::UpdateVolume() {
+	auto& stats = m_Volume->Update(m_CurrentCameraPos);
+	m_Volume->ExtractSurface(m_MeshVerts, m_Indices);
+	return stats;
+}
+
 void UniVolumePlanet::UpdateBuffers() {
 	m_IndexCount = static_cast<uint32_t>(m_Indices.size());
 	m_VertexCount = static_cast<uint32_t>(m_MeshVerts.size());
@@ -340,32 +328,12 @@ void UniVolumePlanet::UpdateUniformBuffers(glm::mat4& modelMat) {
 	m_UniformBufferData.tessellatedEdgeSize = 4.f;
 
 	m_UniformBufferData.hasOcean = m_HasOcean;
-	
-	vks::Buffer uniformStaging;
-	auto device = UniEngine::GetInstance().vulkanDevice;
-
-	// Vertex buffer
-	VK_CHECK_RESULT(device->createBuffer(
-		VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
-		VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
-		&uniformStaging,
-		static_cast<uint32_t>(sizeof(UniformBufferData)),
-		&m_UniformBufferData));
-
-	// Copy from staging buffers
-	VkCommandBuffer copyCmd = device->createCommandBuffer(VK_COMMAND_BUFFER_LEVEL_PRIMARY, true);
-
-	VkBufferCopy copyRegion{};
-
-	copyRegion.size = static_cast<uint32_t>(sizeof(UniformBufferData));
-	vkCmdCopyBuffer(copyCmd, uniformStaging.buffer, m_UniformBuffer.buffer, 1, &copyRegion);
-
-	device->flushCommandBuffer(copyCmd, UniEngine::GetInstance().GetQueue());
-
-	// Destroy staging resources
-	vkDestroyBuffer(device->logicalDevice, uniformStaging.buffer, nullptr);
-	vkFreeMemory(device->logicalDevice, uniformStaging.memory, nullptr);
+}
 
+void UniVolumePlanet::PushUniforms() {
+	// written straight into mapped memory, nothing to submit or wait for
+	m_Material->SetDynamicUniformOffset(UniEngine::GetInstance().GetUniformRing().push(
+		&m_UniformBufferData, sizeof(UniformBufferData)));
 }
 
 // TODO: Fixme for pn-patch interpolation causing offset problems where shader != cpp
@@ -410,7 +378,6 @@ void UniVolumePlanet::CreateBuffers() {
 	uint32_t oceanVertexBufferSize = static_cast<uint32_t>(m_OceanVerts.size() * sizeof(glm::vec3));
 	uint32_t indexBufferSize = static_cast<uint32_t>(m_Indices.size() * sizeof(uint32_t));
 	uint32_t oceanIndexBufferSize = static_cast<uint32_t>(m_OceanIndices.size() * sizeof(uint32_t));
-	uint32_t ubSize = static_cast<uint32_t>(sizeof(UniVolumePlanet::UniformBufferData));
 	uint32_t storageBufferSize = static_cast<uint32_t>(m_NoiseLayers.size() * sizeof(NoiseLayerData));
 
 	auto device = UniEngine::GetInstance().vulkanDevice;
@@ -449,12 +416,6 @@ void UniVolumePlanet::CreateBuffers() {
 		&m_IndexBuffer,
 		indexBufferSize));
 
-	// uniform buffer
-	VK_CHECK_RESULT(device->createBuffer(
-		VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT,
-		VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT,
-		&m_UniformBuffer, ubSize));
-
 	// storage buffer
 	VK_CHECK_RESULT(device->createBuffer(
 		VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT,
@@ -462,7 +423,8 @@ void UniVolumePlanet::CreateBuffers() {
 		&m_StorageBuffer, storageBufferSize));
 
 
-	m_Material->SetBuffer("uniform", std::make_shared<vks::Buffer>(m_UniformBuffer));
+	// UniformBufferData comes from the engine's uniform ring, at binding 8
+	m_Material->SetDynamicUniform(UniEngine::GetInstance().GetUniformRing().descriptor(sizeof(UniformBufferData)));
 	m_Material->SetBuffer("noiselayers", std::make_shared<vks::Buffer>(m_StorageBuffer));
 	m_Material->SetBuffer("vertex", std::make_shared<vks::Buffer>(m_VertexBuffer));
 	m_Material->SetBuffer("index", std::make_shared<vks::Buffer>(m_IndexBuffer));
@@ -479,7 +441,6 @@ void UniVolumePlanet::DestroyBuffers() {
 		m_OceanVertexBuffer.destroy();
 		m_OceanIndexBuffer.destroy();
 	}
-	m_UniformBuffer.destroy();
 }
 
 
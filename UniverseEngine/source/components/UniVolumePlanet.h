@@ -1,143 +1,17 @@
 #pragma once
 #include <glm/glm.hpp>
-#define GLM_ENABLE_EXPERIMENTAL
-#include <glm/gtx/hash.hpp>
 #include "../vks/VulkanBuffer.hpp"
 #include "../vks/VulkanTexture.hpp"
 #include "../UniMaterial.h"
-#include <unordered_set>
+#include "PlanetVolume.h"
+#include "../FastNoise.h"
+#include <memory>
 #include <vector>
-#include <list>
-
-
-template <class T>
-inline void hash_combine(std::size_t& seed, const T& v) {
-	std::hash<T> hasher;
-	seed ^= hasher(v) + 0x9e3779b9 + (seed << 6) + (seed >> 2);
-}
-
-struct Diamond {
-	glm::dvec3 pos;
-	uint16_t type;
-	uint16_t level;
-	uint16_t j;
-};
-
-struct Tet {
-	glm::dvec3 v0;
-	glm::dvec3 v1;
-	glm::dvec3 v2;
-	glm::dvec3 v3;
-
-	size_t h;
-
-	Tet(glm::dvec3 a, glm::dvec3 b, glm::dvec3 c, glm::dvec3 d) {
-		v0 = a;
-		v1 = b;
-		v2 = c;
-		v3 = d;
-
-		// Compute individual hash values for two data members and combine them using XOR and bit shifting
-		auto h0 = hash<glm::dvec3>()(v0);
-		auto h1 = hash<glm::dvec3>()(v1);
-		auto h2 = hash<glm::dvec3>()(v2);
-		auto h3 = hash<glm::dvec3>()(v3);
-
-		std::list<size_t> hashes = { h0, h1, h2, h3 };
-		hashes.sort();
-
-		size_t seed = 0;
-		for(auto& hx : hashes) {
-			hash_combine(seed, hx);
-		}
-
-		h = seed;
-
-	}
-
-	std::shared_ptr<Diamond> d;
-
-	uint16_t type = 0;
-	uint16_t level = 0;
-	uint16_t j = 19;
-
-	std::pair<glm::dvec3, glm::dvec3> le;
-
-	void CalculateLongestEdge() {
-		std::pair<glm::dvec3, glm::dvec3> v01 = { v0, v1 };
-		std::pair<glm::dvec3, glm::dvec3> v02 = { v0, v2 };
-		std::pair<glm::dvec3, glm::dvec3> v03 = { v0, v3 };
-		std::pair<glm::dvec3, glm::dvec3> v12 = { v1, v2 };
-		std::pair<glm::dvec3, glm::dvec3> v13 = { v1, v3 };
-		std::pair<glm::dvec3, glm::dvec3> v23 = { v2, v3 };
-		std::vector<std::pair<glm::dvec3, glm::dvec3>> pairs = { v01, v02, v03, v12, v13, v23 };
-		glm::dvec3 c;
-		std::pair<glm::dvec3, glm::dvec3> cvs;
-		double longest = 0;
-		for(auto& p : pairs) {
-			auto distance = glm::distance(p.first, p.second);
-			if(distance > longest) {
-				longest = distance;
-				c = (p.first + p.second) / 2.0;
-				cvs = p;
-			}
-		}
-		d = std::make_shared<Diamond>();
-		d->pos = c;
-		d->level = level;
-		d->j = j;
-		le = cvs;
-	}
-
-	bool operator==(const Tet& rhs) const{
-		return rhs.h == h;
-	}
-
-
-};
-
-
-
-namespace std {
-	template <>
-	struct hash<Tet> {
-		size_t operator()(const Tet& k) const {
-			// Compute individual hash values for two data members and combine them using XOR and bit shifting
-			auto h0 = hash<glm::dvec3>()(k.v0);
-			auto h1 = hash<glm::dvec3>()(k.v1);
-			auto h2 = hash<glm::dvec3>()(k.v2);
-			auto h3 = hash<glm::dvec3>()(k.v3);
-
-			std::list<size_t> hashes = { h0, h1, h2, h3 };
-			hashes.sort();
-			
-			size_t seed = 0;
-			for(auto& h : hashes) {
-				hash_combine(seed, h);
-			}
-
-			return seed;
-
-		}
-	};
-}
-
-struct OffsetLookup {
-	std::unordered_set<Tet> tets;
-	std::unordered_set<glm::dvec3> parents;
-	std::unordered_set<glm::dvec3> children;
-};
-
 
 
 class UniVolumePlanet{
 public:
 
-	std::unordered_set<glm::i8vec3> offset_lookups;
-	std::unordered_map<glm::dvec3, std::shared_ptr<Diamond>> diamond_map;
-	std::unordered_map<uint32_t, OffsetLookup> offset_map;
-	std::unordered_set<glm::dvec3> diamond_types;
-
 	enum NoiseType {
 		SIMPLEX,
 		WORLEY_P1,
@@ -176,7 +50,6 @@ public:
 	vks::Buffer m_OceanVertexBuffer;
 	vks::Buffer m_IndexBuffer;
 	vks::Buffer m_OceanIndexBuffer;
-	vks::Buffer m_UniformBuffer;
 	vks::Buffer m_StorageBuffer;
 	uint32_t m_VertexCount;
 	uint32_t m_IndexCount;
@@ -197,8 +70,13 @@ public:
 	void SetCameraPosition(glm::vec3& cam);
 	double GetPositionOffset(glm::vec3& pos);
 	void UpdateMesh();
+	//Refines the volume towards the camera and rebuilds the surface mesh from it
+	const uni::planet::VolumeStats& UpdateVolume();
+	float GetDensity(const glm::vec3& pos);
 	void UpdateBuffers();
 	void UpdateUniformBuffers(glm::mat4& modelMat);
+	//Copies the uniforms into the frame's uniform ring slice, between its beginFrame and the recording
+	void PushUniforms();
 	float GetAltitude(glm::vec3& point);
 	glm::vec3 CameraPos() { return m_CurrentCameraPos; }
 	std::vector<glm::vec3> GetMesh() { return m_MeshVerts; }
@@ -227,6 +105,10 @@ private:
 
 	std::vector<NoiseLayerData> m_NoiseLayers;
 
+	std::unique_ptr<uni::planet::VolumeRefiner> m_Volume;
+	FastNoise m_TerrainNoise;
+	FastNoise m_CaveNoise;
+
 	glm::vec3 m_CurrentCameraPos = glm::vec3(0, 0, 10);
 
 	void CreateBuffers();
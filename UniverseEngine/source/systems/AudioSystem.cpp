@@ -7,6 +7,7 @@
 void AudioSystem::receive(ECS::World* world, const LevelStartEvent& event) {
   auto engine = UniEngine::GetInstance();
   auto renderer = engine->GetSceneRenderer();
+  auto camera = engine->GetSceneManager()->CurrentScene()->GetCameraComponent();
 
   world->each<AudioComponent, TransformComponent>(
     [&](ECS::Entity * ent, ECS::ComponentHandle<AudioComponent> audio,
@@ -14,7 +15,7 @@ void AudioSystem::receive(ECS::World* world, const LevelStartEvent& event) {
 
         if (audio->m_isPlaying) {
           audio->m_channel = UniEngine::GetInstance()->GetAudioManager()->PlaySoundFile(
-            audio->m_filename, transform->GetPosition(), audio->m_volume);
+            audio->m_filename, camera->RelativeToCamera(transform->GetWorldPosition()), audio->m_volume);
 
           std::cout << "Playing audio: " << audio->m_filename << " at " << glm::to_string<glm::vec3>(transform->GetPosition()) << std::endl;
         }
@@ -41,8 +42,18 @@ void AudioSystem::tick(ECS::World* world, float deltaTime) {
   auto cam = UniEngine::GetInstance()->GetSceneManager()->CurrentScene()->GetCameraObject();
   auto transform = cam->GetComponent<TransformComponent>();
   auto physics = cam->GetComponent<PhysicsComponent>();
+  auto camera = cam->GetComponent<CameraComponent>();
 
-  glm::vec3 pos = transform->GetPosition();
+  // Sound is placed camera relative like rendering, so the listener sits at the origin and sources follow it
+  // through origin shifts.
+  world->each<AudioComponent, TransformComponent>(
+    [&](ECS::Entity* ent, ECS::ComponentHandle<AudioComponent> audio,
+      ECS::ComponentHandle<TransformComponent> source) {
+      if (audio->m_isPlaying && audio->m_is3d && audio->m_channel >= 0)
+        UniEngine::GetInstance()->GetAudioManager()->SetChannel3dPosition(audio->m_channel, camera->RelativeToCamera(source->GetWorldPosition()));
+    });
+
+  glm::vec3 pos = glm::vec3(0.f);
   glm::vec3 up = transform->TransformLocalDirectionToWorldSpace({ 0, -1, 0 });
   glm::vec3 forward = transform->TransformLocalDirectionToWorldSpace({ 0, 0, 1 });
   glm::vec3 velocity = physics->m_Velocity;
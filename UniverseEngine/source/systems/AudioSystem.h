@@ -13,6 +13,11 @@ class AudioSystem : public ECS::EntitySystem,
 {
  public:
 
+  AudioSystem() {
+    reads<TransformComponent, PhysicsComponent, CameraComponent, AudioComponent>();
+    runsOnMainThread();
+  }
+
   virtual ~AudioSystem() {}
 
   virtual void receive(ECS::World* world, const LevelStartEvent& event) override;
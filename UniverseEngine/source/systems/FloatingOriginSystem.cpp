@@ -0,0 +1,42 @@
+#include "FloatingOriginSystem.h"
+
+void FloatingOriginSystem::tick(ECS::World* world, float deltaTime) {
+
+	bool found = false;
+	glm::dvec3 shift = glm::dvec3(0.0);
+	world->each<TransformComponent, CameraComponent>([&](ECS::Entity* ent, ECS::ComponentHandle<TransformComponent> transform, ECS::ComponentHandle<CameraComponent> camera) {
+		if(found || !camera->isActive || transform->m_Parent)
+			return;
+
+		found = true;
+		shift = transform->m_dPos;
+	});
+
+	if(!found || glm::length(shift) < m_RebaseDistance)
+		return;
+
+	// Children move with their parents, so only the roots need shifting.
+	world->each<TransformComponent>([&](ECS::Entity* ent, ECS::ComponentHandle<TransformComponent> transform) {
+		if(transform->m_Parent)
+			return;
+
+		transform->m_dPos -= shift;
+		transform->MarkDirty();
+
+		auto physics = ent->get<PhysicsComponent>();
+		if(physics && physics->m_HasSimulationState) {
+			physics->m_Position -= shift;
+			physics->m_PreviousPosition -= shift;
+			physics->m_PresentedPosition -= shift;
+		}
+	});
+
+	world->each<TransformComponent, CameraComponent>([&](ECS::Entity* ent, ECS::ComponentHandle<TransformComponent> transform, ECS::ComponentHandle<CameraComponent> camera) {
+		camera->target -= glm::vec3(shift);
+		camera->CalculateView(transform);
+	});
+
+	m_OriginOffset += shift;
+
+	world->emit<OriginShiftEvent>({ shift });
+}
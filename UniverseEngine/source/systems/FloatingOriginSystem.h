@@ -0,0 +1,29 @@
+#pragma once
+#include "../ECS.h"
+#include "events.h"
+#include "../components/Components.h"
+
+
+/**
+* Keeps the world origin near the camera. Once the camera strays past m_RebaseDistance, every root transform (and the
+* physics state following it) is moved back by the camera's position and an OriginShiftEvent is emitted, so positions
+* near the action keep their precision however far the camera travels. Subscribers are called during this tick.
+*/
+class FloatingOriginSystem : public ECS::EntitySystem {
+public:
+	/** @brief metres the camera may get from the origin before everything is rebased around it */
+	double m_RebaseDistance = 10000.0;
+
+	FloatingOriginSystem() {
+		writes<TransformComponent, PhysicsComponent, CameraComponent>();
+	}
+	virtual ~FloatingOriginSystem() = default;
+
+	virtual void tick(ECS::World* world, float deltaTime) override;
+
+	/** @brief total distance everything has been moved by, add it to a position for the original world coordinates */
+	glm::dvec3 GetOriginOffset() const { return m_OriginOffset; }
+
+private:
+	glm::dvec3 m_OriginOffset = glm::dvec3(0.0);
+};
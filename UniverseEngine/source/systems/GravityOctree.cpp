@@ -0,0 +1,194 @@
+#include "GravityOctree.h"
+#include <algorithm>
+#include <cmath>
+
+namespace {
+	// Spread the low 21 bits of v out to every third bit
+	uint64_t SpreadBits(uint64_t v) {
+		v &= 0x1fffff;
+		v = (v | v << 32) & 0x1f00000000ffffull;
+		v = (v | v << 16) & 0x1f0000ff0000ffull;
+		v = (v | v << 8) & 0x100f00f00f00f00full;
+		v = (v | v << 4) & 0x10c30c30c30c30c3ull;
+		v = (v | v << 2) & 0x1249249249249249ull;
+		return v;
+	}
+}
+
+void GravityOctree::Build(const std::vector<Body>& bodies) {
+	uint32_t count = (uint32_t)bodies.size();
+	m_Nodes.clear();
+	m_Groups.clear();
+	m_Order.resize(count);
+	m_X.resize(count);
+	m_Y.resize(count);
+	m_Z.resize(count);
+	m_Mass.resize(count);
+	m_Codes.resize(count);
+
+	if(count == 0)
+		return;
+
+	glm::dvec3 min = bodies[0].position;
+	glm::dvec3 max = bodies[0].position;
+	for(const auto& body : bodies) {
+		min = glm::min(min, body.position);
+		max = glm::max(max, body.position);
+	}
+
+	// Cube around everything, padded a little so bodies on the boundary still land inside.
+	glm::dvec3 extent = max - min;
+	double halfSize = std::max(std::max(extent.x, extent.y), std::max(extent.z, 1.0)) * 0.5 * 1.001;
+	glm::dvec3 centre = (min + max) * 0.5;
+	glm::dvec3 corner = centre - glm::dvec3(halfSize);
+
+	// x in the lowest bit of every triple, the same as the octant numbering below
+	double scale = double(1u << MaxDepth) / (2.0 * halfSize);
+	double top = double((1u << MaxDepth) - 1);
+	m_Sort.resize(count);
+	for(uint32_t i = 0; i < count; i++) {
+		glm::dvec3 cell = glm::clamp((bodies[i].position - corner) * scale, glm::dvec3(0.0), glm::dvec3(top));
+		uint64_t code = SpreadBits((uint64_t)cell.x) | SpreadBits((uint64_t)cell.y) << 1 | SpreadBits((uint64_t)cell.z) << 2;
+		m_Sort[i] = { code, i };
+	}
+	std::sort(m_Sort.begin(), m_Sort.end());
+
+	for(uint32_t i = 0; i < count; i++) {
+		uint32_t body = m_Sort[i].second;
+		m_Codes[i] = m_Sort[i].first;
+		m_Order[i] = body;
+		m_X[i] = bodies[body].position.x;
+		m_Y[i] = bodies[body].position.y;
+		m_Z[i] = bodies[body].position.z;
+		m_Mass[i] = bodies[body].mass;
+	}
+
+	m_Nodes.reserve(count / 2 + 1);
+	AddNode(0, count, 0, false);
+}
+
+void GravityOctree::AddNode(uint32_t first, uint32_t last, uint32_t depth, bool inGroup) {
+	uint32_t index = (uint32_t)m_Nodes.size();
+	m_Nodes.emplace_back();
+
+	bool isLeaf = last - first <= LeafCapacity || depth >= MaxDepth;
+	if(!inGroup && (last - first <= GroupCapacity || isLeaf)) {
+		m_Groups.push_back(index);
+		inGroup = true;
+	}
+
+	double mass = 0.0;
+	glm::dvec3 weighted(0.0);
+	glm::dvec3 boundsMin(m_X[first], m_Y[first], m_Z[first]);
+	glm::dvec3 boundsMax = boundsMin;
+
+	if(isLeaf) {
+		for(uint32_t i = first; i < last; i++) {
+			glm::dvec3 position(m_X[i], m_Y[i], m_Z[i]);
+			mass += m_Mass[i];
+			weighted += position * m_Mass[i];
+			boundsMin = glm::min(boundsMin, position);
+			boundsMax = glm::max(boundsMax, position);
+		}
+	} else {
+		// The range shares every digit above this level, so it is sorted by this one and splits into runs.
+		uint32_t shift = 3 * (MaxDepth - 1 - depth);
+		uint32_t begin = first;
+		for(uint32_t octant = 0; octant < 8 && begin < last; octant++) {
+			uint32_t end = (uint32_t)(std::upper_bound(m_Codes.begin() + begin, m_Codes.begin() + last, octant, [shift](uint32_t value, uint64_t code) {
+				return value < ((code >> shift) & 7);
+			}) - m_Codes.begin());
+			if(end == begin)
+				continue;
+
+			uint32_t child = (uint32_t)m_Nodes.size();
+			AddNode(begin, end, depth + 1, inGroup);
+			mass += m_Nodes[child].mass;
+			weighted += m_Nodes[child].centreOfMass * m_Nodes[child].mass;
+			boundsMin = glm::min(boundsMin, m_Nodes[child].boundsMin);
+			boundsMax = glm::max(boundsMax, m_Nodes[child].boundsMax);
+			begin = end;
+		}
+	}
+
+	// AddNode on the children can reallocate m_Nodes, so only take the reference now
+	Node& node = m_Nodes[index];
+	node.mass = mass;
+	node.centreOfMass = mass > 0.0 ? weighted / mass : (boundsMin + boundsMax) * 0.5;
+	node.boundsMin = boundsMin;
+	node.boundsMax = boundsMax;
+	node.first = first;
+	node.count = last - first;
+	node.next = (uint32_t)m_Nodes.size();
+	node.isLeaf = isLeaf ? 1 : 0;
+}
+
+void GravityOctree::GroupAccelerations(size_t groupIndex, double openingAngle, double minDistance, std::vector<glm::dvec3>& accelerations) const {
+	// Every mass this group's bodies feel, bodies of nearby leaves and centres of far cells alike. Kept per thread so
+	// the storage is reused from group to group.
+	thread_local std::vector<double> x, y, z, mass;
+	x.clear();
+	y.clear();
+	z.clear();
+	mass.clear();
+
+	const Node& group = m_Nodes[m_Groups[groupIndex]];
+	double theta2 = openingAngle * openingAngle;
+
+	uint32_t i = 0;
+	uint32_t end = (uint32_t)m_Nodes.size();
+	while(i < end) {
+		const Node& node = m_Nodes[i];
+		if(node.mass == 0.0) {
+			i = node.next;
+			continue;
+		}
+
+		if(node.isLeaf) {
+			x.insert(x.end(), m_X.begin() + node.first, m_X.begin() + node.first + node.count);
+			y.insert(y.end(), m_Y.begin() + node.first, m_Y.begin() + node.first + node.count);
+			z.insert(z.end(), m_Z.begin() + node.first, m_Z.begin() + node.first + node.count);
+			mass.insert(mass.end(), m_Mass.begin() + node.first, m_Mass.begin() + node.first + node.count);
+			i = node.next;
+			continue;
+		}
+
+		// Every body of the group is inside its box, so a cell whose box doesn't touch it can't hold any of them
+		bool overlaps = glm::all(glm::lessThanEqual(node.boundsMin, group.boundsMax)) && glm::all(glm::lessThanEqual(group.boundsMin, node.boundsMax));
+		if(!overlaps) {
+			// Nearest any body of the group can be to the centre of mass, so every one of them sees the cell within the angle
+			glm::dvec3 gap = glm::max(glm::max(group.boundsMin - node.centreOfMass, node.centreOfMass - group.boundsMax), glm::dvec3(0.0));
+			glm::dvec3 extent = node.boundsMax - node.boundsMin;
+			double size = std::max(std::max(extent.x, extent.y), extent.z);
+			if(size * size < theta2 * glm::dot(gap, gap)) {
+				x.push_back(node.centreOfMass.x);
+				y.push_back(node.centreOfMass.y);
+				z.push_back(node.centreOfMass.z);
+				mass.push_back(node.mass);
+				i = node.next;
+				continue;
+			}
+		}
+
+		i++;
+	}
+
+	double minDistance2 = minDistance * minDistance;
+	size_t sources = mass.size();
+	for(uint32_t body = group.first; body < group.first + group.count; body++) {
+		double px = m_X[body], py = m_Y[body], pz = m_Z[body];
+		double ax = 0.0, ay = 0.0, az = 0.0;
+		for(size_t j = 0; j < sources; j++) {
+			double dx = x[j] - px;
+			double dy = y[j] - py;
+			double dz = z[j] - pz;
+			double distance2 = dx * dx + dy * dy + dz * dz;
+			// A select rather than a branch, so the loop can vectorise
+			double pull = distance2 > minDistance2 ? mass[j] / (distance2 * std::sqrt(distance2)) : 0.0;
+			ax += dx * pull;
+			ay += dy * pull;
+			az += dz * pull;
+		}
+		accelerations[m_Order[body]] = glm::dvec3(ax, ay, az) * G;
+	}
+}
@@ -0,0 +1,78 @@
+#pragma once
+#include <stdint.h>
+#include <vector>
+#include "../3dmaths.h"
+
+/**
+* Barnes-Hut octree over point masses. Build it from every body once per tick, then work out the accelerations one
+* group of nearby bodies at a time. A cell that looks small enough from the group (size / distance below the opening
+* angle) is treated as one mass at its centre of mass, so updating every body is O(N log N) instead of O(N^2).
+*
+* Build sorts the bodies along a Morton curve and splits the sorted range, so the bodies of every cell are contiguous
+* and each cell's subtree follows it in the node array. A walk is then a forward scan that either opens a cell (steps
+* to the next node) or skips it (jumps past its subtree), with no stack and no pointer chasing. Each group (the
+* biggest cells of up to GroupCapacity bodies) walks the tree once for all of its bodies, measuring distances from its
+* bounding box, and sums the list of masses it collected for every body in a straight loop. Sizes are those of the
+* box around a cell's bodies rather than of the cell, which opens far fewer cells where bodies are clustered.
+*
+* Queries only read the tree, so different groups can run on several threads at once.
+*/
+class GravityOctree {
+public:
+	struct Body {
+		glm::dvec3 position;
+		double mass;
+	};
+
+	/** @brief gravitational constant, m^3 kg^-1 s^-2 */
+	static constexpr double G = 6.67408e-11;
+
+	void Build(const std::vector<Body>& bodies);
+
+	size_t GroupCount() const { return m_Groups.size(); }
+
+	/**
+	* Gravitational acceleration (m/s^2) of every body in a group from all the others, written to accelerations[i] for
+	* body i of what was passed to Build.
+	*
+	* @param openingAngle 0 visits every body, 0.5 is the usual accuracy/speed trade-off
+	* @param minDistance bodies closer than this (metres) are ignored, which also leaves out the body itself
+	*/
+	void GroupAccelerations(size_t group, double openingAngle, double minDistance, std::vector<glm::dvec3>& accelerations) const;
+
+private:
+	struct Node {
+		glm::dvec3 centreOfMass;
+		double mass;
+		/** @brief box around the cell's bodies, usually much smaller than the cell */
+		glm::dvec3 boundsMin;
+		glm::dvec3 boundsMax;
+		/** @brief the cell's bodies are [first, first + count) in tree order */
+		uint32_t first;
+		uint32_t count;
+		/** @brief node after this one's subtree, its first child (if any) is the next node */
+		uint32_t next;
+		uint32_t isLeaf;
+	};
+
+	/** @brief bits of Morton code per axis, also the deepest level */
+	static const uint32_t MaxDepth = 21;
+	static const uint32_t LeafCapacity = 8;
+	static const uint32_t GroupCapacity = 32;
+
+	/**
+	* Append the node for bodies [first, last), all in one cell at depth, and everything below it. inGroup is true
+	* below a node that already started a group.
+	*/
+	void AddNode(uint32_t first, uint32_t last, uint32_t depth, bool inGroup);
+
+	// Bodies in tree order, one array per coordinate so leaves read them in a straight line
+	std::vector<double> m_X, m_Y, m_Z, m_Mass;
+	/** @brief index passed to Build of each body in tree order */
+	std::vector<uint32_t> m_Order;
+	std::vector<uint64_t> m_Codes;
+	std::vector<std::pair<uint64_t, uint32_t>> m_Sort;
+	std::vector<Node> m_Nodes;
+	/** @brief node of each group */
+	std::vector<uint32_t> m_Groups;
+};
@@ -1,10 +1,55 @@
 #include "GravitySystem.h"
 
-GravitySystem::GravitySystem() {}
+GravitySystem::GravitySystem() {
+	reads<TransformComponent, Planet>();
+	writes<PhysicsComponent>();
+}
 
 GravitySystem::~GravitySystem() {}
 
 void GravitySystem::tick(ECS::World* world, float deltaTime) {
+	if(m_Mode == Mode::NBody)
+		TickNBody(world);
+	else
+		TickBiggestPlanet(world);
+}
+
+void GravitySystem::receive(ECS::World* world, const GravityModeEvent& event) {
+	m_Mode = event.nBody ? Mode::NBody : Mode::BiggestPlanet;
+}
+
+void GravitySystem::TickNBody(ECS::World* world) {
+
+	m_Bodies.clear();
+	world->each<TransformComponent, PhysicsComponent>([&](
+		ECS::Entity* ent, ECS::ComponentHandle<TransformComponent> transform, ECS::ComponentHandle<PhysicsComponent> physics) {
+		if(physics->m_Mass > 0.0)
+			m_Bodies.push_back({ transform->GetWorldPosition(), physics->m_Mass });
+	});
+
+	m_Octree.Build(m_Bodies);
+	m_Accelerations.resize(m_Bodies.size());
+
+	// Groups write to disjoint bodies
+	world->parallelFor(m_Octree.GroupCount(), [&](size_t first, size_t last) {
+		for(size_t group = first; group < last; group++)
+			m_Octree.GroupAccelerations(group, m_OpeningAngle, m_MinDistance, m_Accelerations);
+	}, 4);
+
+	// Components can move in storage, so look them up again rather than keep pointers. The same walk visits the
+	// bodies in the same order as the one that gathered them.
+	size_t body = 0;
+	world->each<TransformComponent, PhysicsComponent>([&](
+		ECS::Entity* ent, ECS::ComponentHandle<TransformComponent> transform, ECS::ComponentHandle<PhysicsComponent> physics) {
+		if(physics->m_Mass <= 0.0)
+			return;
+		if(!physics->m_IsStatic)
+			physics->AddAcceleration(m_Accelerations[body]);
+		body++;
+	});
+}
+
+void GravitySystem::TickBiggestPlanet(ECS::World* world) {
 
 	double biggestMass = 0.0;
 	glm::vec3 gravityDirection = glm::vec3(0.0);
@@ -18,7 +63,7 @@ void GravitySystem::tick(ECS::World* world, float deltaTime) {
 		}
 	});
 
-	world->each<TransformComponent, PhysicsComponent>([&](
+	world->parallelEach<TransformComponent, PhysicsComponent>([&](
 		ECS::Entity* ent, ECS::ComponentHandle<TransformComponent> transform, ECS::ComponentHandle<PhysicsComponent> physics) {
 
 		if(!physics->m_IsStatic) {
@@ -39,7 +84,7 @@ void GravitySystem::tick(ECS::World* world, float deltaTime) {
 
 				auto force = (direction * (float)gravFactor);
 
-				physics->AddForce(force * deltaTime);
+				physics->AddForce(force);
 			}
 		}
 	});
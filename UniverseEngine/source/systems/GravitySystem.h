@@ -1,13 +1,50 @@
 #pragma once
+#include <vector>
 #include "../ECS.h"
 #include "events.h"
 #include "../components/Components.h"
+#include "GravityOctree.h"
 
-class GravitySystem : public ECS::EntitySystem {
+class GravitySystem : public ECS::EntitySystem, public ECS::EventSubscriber<GravityModeEvent> {
 public:
+	enum class Mode {
+		/** @brief every body falls towards the single most massive planet */
+		BiggestPlanet,
+		/** @brief every mass pulls on every other, approximated with a Barnes-Hut octree */
+		NBody
+	};
+
+	/**
+	* NBody still takes ~0.8 s a tick for 100k bodies on one core (--cpubench gravity), too slow to be the default.
+	* Switched with a GravityModeEvent, from the "N-body gravity" box in the settings overlay.
+	*/
+	Mode m_Mode = Mode::BiggestPlanet;
+	/** @brief Barnes-Hut opening angle, 0 is exact, bigger is faster and coarser. 0.7 keeps forces within a few percent */
+	double m_OpeningAngle = 0.7;
+	/** @brief bodies closer than this (metres) don't attract each other */
+	double m_MinDistance = 1.0;
+
 	GravitySystem();
 	~GravitySystem();
 
 	virtual void tick(ECS::World* world, float deltaTime) override;
+	virtual void receive(ECS::World* world, const GravityModeEvent& event) override;
+
+	virtual void configure(ECS::World* world) override {
+		world->subscribe<GravityModeEvent>(this);
+	}
+
+	virtual void unconfigure(ECS::World* world) override {
+		world->unsubscribeAll(this);
+	}
+
+private:
+	void TickBiggestPlanet(ECS::World* world);
+	void TickNBody(ECS::World* world);
+
+	// kept between ticks so their storage is reused
+	std::vector<GravityOctree::Body> m_Bodies;
+	std::vector<glm::dvec3> m_Accelerations;
+	GravityOctree m_Octree;
 };
 
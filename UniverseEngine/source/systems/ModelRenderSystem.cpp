@@ -4,29 +4,44 @@
 #include "../SceneManager.h"
 #include "../SceneRenderer.h"
 #include "../materials/ModelMaterial.h"
+#include <unordered_map>
 
-void ModelRenderSystem::receive(ECS::World* world, const RenderEvent& event) {
+void ModelRenderSystem::receive(ECS::World* world, const RenderQueueEvent& event) {
   auto engine = UniEngine::GetInstance();
   auto renderer = engine->GetSceneRenderer();
+  auto& queue = event.queue;
 
-  std::cout << "Render system received render event." << std::endl;
+  // Each material is looked up once, not once per model using it
+  std::unordered_map<std::string, std::shared_ptr<ModelMaterial>> materials;
 
+  queue.Clear();
   world->each<ModelComponent>(
     [&](ECS::Entity * ent, ECS::ComponentHandle<ModelComponent> model) {
-      std::cout << "rendering model " << model->GetName();
-      auto materials = model->GetMaterialIDs();
-      for_each(materials.begin(), materials.end(), [&](std::string matID) {
-        auto material = renderer->GetMaterialByID<ModelMaterial>(matID);
-        material->AddToCommandBuffer(event.cmdBuffer, model);
+      for (auto& matID : model->m_Materials) {
+        auto found = materials.find(matID);
+        if (found == materials.end())
+          found = materials.emplace(matID, renderer->GetMaterialByID<ModelMaterial>(matID)).first;
+        if (!found->second)
+          continue;
 
-        std::cout << " with material " << matID;
-        });
-      std::cout << std::endl;
+        auto meshes = model->m_Model->m_meshesByMaterial.find(matID);
+        if (meshes == model->m_Model->m_meshesByMaterial.end())
+          continue;
+        for (auto mesh : meshes->second)
+          queue.Add(found->second, model->m_Model, mesh, model->GetSceneObject());
+      }
     });
+  // SceneRenderer records the batches of every swapchain image once this returns
+  queue.Build();
 }
 
 void ModelRenderSystem::receive(ECS::World* world, const RemoveEvent& event) {
   event.component->Destroy();
+  UniEngine::GetInstance()->GetSceneRenderer()->MarkCommandBuffersDirty();
+}
+
+void ModelRenderSystem::receive(ECS::World* world, const AssignEvent& event) {
+  UniEngine::GetInstance()->GetSceneRenderer()->MarkCommandBuffersDirty();
 }
 
 void ModelRenderSystem::tick(ECS::World* world, float deltaTime) {}
@@ -6,22 +6,31 @@
 #include "events.h"
 
 using RemoveEvent = ECS::Events::OnComponentRemoved<ModelComponent>;
+using AssignEvent = ECS::Events::OnComponentAssigned<ModelComponent>;
 
 class ModelRenderSystem : public ECS::EntitySystem,
-                          public ECS::EventSubscriber<RenderEvent>,
-      public ECS::EventSubscriber<RemoveEvent> {
+                          public ECS::EventSubscriber<RenderQueueEvent>,
+      public ECS::EventSubscriber<RemoveEvent>,
+      public ECS::EventSubscriber<AssignEvent> {
  public:
 
+  ModelRenderSystem() {
+    // models go in the render queue on the RenderQueueEvent, tick does nothing
+    reads<>();
+  }
+
   virtual ~ModelRenderSystem() {}
 
-  virtual void receive(ECS::World* world, const RenderEvent& event) override;
+  virtual void receive(ECS::World* world, const RenderQueueEvent& event) override;
   virtual void receive(
       ECS::World* world,
       const RemoveEvent& event) override;
+  virtual void receive(ECS::World* world, const AssignEvent& event) override;
 
   virtual void configure(ECS::World* world) override {
-    world->subscribe<RenderEvent>(this);
+    world->subscribe<RenderQueueEvent>(this);
     world->subscribe<RemoveEvent>(this);
+    world->subscribe<AssignEvent>(this);
   }
 
   virtual void unconfigure(ECS::World* world) override {
@@ -0,0 +1,128 @@
+#include "PhysicsIntegrator.h"
+#include <cmath>
+
+#if defined(__AVX__) || defined(_M_X64) || defined(__SSE2__) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <immintrin.h>
+#endif
+
+void PhysicsBodies::Resize(size_t count) {
+	for(auto* v : { &px, &py, &pz, &vx, &vy, &vz, &qx, &qy, &qz, &qw, &wx, &wy, &wz, &ax, &ay, &az, &awx, &awy, &awz,
+		&prevPx, &prevPy, &prevPz, &prevQx, &prevQy, &prevQz, &prevQw }) {
+		v->resize(count);
+	}
+}
+
+void PhysicsBodies::SavePoses() {
+	prevPx = px;
+	prevPy = py;
+	prevPz = pz;
+	prevQx = qx;
+	prevQy = qy;
+	prevQz = qz;
+	prevQw = qw;
+}
+
+namespace {
+
+	struct ScalarLane {
+		static const size_t Width = 1;
+		double v;
+
+		static ScalarLane Load(const double* p) { return { *p }; }
+		static ScalarLane Set(double x) { return { x }; }
+		void Store(double* p) const { *p = v; }
+
+		ScalarLane operator+(ScalarLane o) const { return { v + o.v }; }
+		ScalarLane operator-(ScalarLane o) const { return { v - o.v }; }
+		ScalarLane operator*(ScalarLane o) const { return { v * o.v }; }
+		ScalarLane operator/(ScalarLane o) const { return { v / o.v }; }
+		friend ScalarLane Sqrt(ScalarLane a) { return { std::sqrt(a.v) }; }
+	};
+
+#if defined(__AVX__)
+	struct SimdLane {
+		static const size_t Width = 4;
+		__m256d v;
+
+		static SimdLane Load(const double* p) { return { _mm256_loadu_pd(p) }; }
+		static SimdLane Set(double x) { return { _mm256_set1_pd(x) }; }
+		void Store(double* p) const { _mm256_storeu_pd(p, v); }
+
+		SimdLane operator+(SimdLane o) const { return { _mm256_add_pd(v, o.v) }; }
+		SimdLane operator-(SimdLane o) const { return { _mm256_sub_pd(v, o.v) }; }
+		SimdLane operator*(SimdLane o) const { return { _mm256_mul_pd(v, o.v) }; }
+		SimdLane operator/(SimdLane o) const { return { _mm256_div_pd(v, o.v) }; }
+		friend SimdLane Sqrt(SimdLane a) { return { _mm256_sqrt_pd(a.v) }; }
+	};
+#elif defined(_M_X64) || defined(__SSE2__) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+	struct SimdLane {
+		static const size_t Width = 2;
+		__m128d v;
+
+		static SimdLane Load(const double* p) { return { _mm_loadu_pd(p) }; }
+		static SimdLane Set(double x) { return { _mm_set1_pd(x) }; }
+		void Store(double* p) const { _mm_storeu_pd(p, v); }
+
+		SimdLane operator+(SimdLane o) const { return { _mm_add_pd(v, o.v) }; }
+		SimdLane operator-(SimdLane o) const { return { _mm_sub_pd(v, o.v) }; }
+		SimdLane operator*(SimdLane o) const { return { _mm_mul_pd(v, o.v) }; }
+		SimdLane operator/(SimdLane o) const { return { _mm_div_pd(v, o.v) }; }
+		friend SimdLane Sqrt(SimdLane a) { return { _mm_sqrt_pd(a.v) }; }
+	};
+#else
+	typedef ScalarLane SimdLane;
+#endif
+
+	// Integrates whole lanes from begin and returns where it stopped. Keep this to separate multiplies and adds: a
+	// fused multiply-add rounds once instead of twice and would make the vector and scalar results differ.
+	template<class L>
+	size_t IntegrateLanes(PhysicsBodies& b, size_t begin, double dt) {
+		const size_t count = b.Size();
+		const L step = L::Set(dt);
+		const L halfStep = L::Set(dt * 0.5);
+		const L one = L::Set(1.0);
+
+		size_t i = begin;
+		for(; i + L::Width <= count; i += L::Width) {
+			L vx = L::Load(&b.vx[i]) + L::Load(&b.ax[i]) * step;
+			L vy = L::Load(&b.vy[i]) + L::Load(&b.ay[i]) * step;
+			L vz = L::Load(&b.vz[i]) + L::Load(&b.az[i]) * step;
+			vx.Store(&b.vx[i]);
+			vy.Store(&b.vy[i]);
+			vz.Store(&b.vz[i]);
+			(L::Load(&b.px[i]) + vx * step).Store(&b.px[i]);
+			(L::Load(&b.py[i]) + vy * step).Store(&b.py[i]);
+			(L::Load(&b.pz[i]) + vz * step).Store(&b.pz[i]);
+
+			L x = L::Load(&b.qx[i]);
+			L y = L::Load(&b.qy[i]);
+			L z = L::Load(&b.qz[i]);
+			L w = L::Load(&b.qw[i]);
+			L wx = L::Load(&b.wx[i]) + L::Load(&b.awx[i]) * step;
+			L wy = L::Load(&b.wy[i]) + L::Load(&b.awy[i]) * step;
+			L wz = L::Load(&b.wz[i]) + L::Load(&b.awz[i]) * step;
+			wx.Store(&b.wx[i]);
+			wy.Store(&b.wy[i]);
+			wz.Store(&b.wz[i]);
+
+			// q += q * (wx, wy, wz, 0) * dt / 2, angular velocity applied in the body frame
+			L nx = x + (w * wx + y * wz - z * wy) * halfStep;
+			L ny = y + (w * wy + z * wx - x * wz) * halfStep;
+			L nz = z + (w * wz + x * wy - y * wx) * halfStep;
+			L nw = w - (x * wx + y * wy + z * wz) * halfStep;
+
+			L invLength = one / Sqrt(nx * nx + ny * ny + nz * nz + nw * nw);
+			(nx * invLength).Store(&b.qx[i]);
+			(ny * invLength).Store(&b.qy[i]);
+			(nz * invLength).Store(&b.qz[i]);
+			(nw * invLength).Store(&b.qw[i]);
+		}
+
+		return i;
+	}
+}
+
+void IntegrateBodies(PhysicsBodies& bodies, double dt) {
+	size_t done = IntegrateLanes<SimdLane>(bodies, 0, dt);
+	IntegrateLanes<ScalarLane>(bodies, done, dt);
+}
@@ -0,0 +1,35 @@
+#pragma once
+#include <stddef.h>
+#include <vector>
+
+/**
+* Rigid body state for PhysicsSystem, one packed array per scalar so a fixed step integrates several bodies per
+* instruction. Orientation is a unit quaternion (x, y, z, w) and angular velocity is in the body's own frame, the same
+* convention as TransformComponent::Rotate.
+*/
+struct PhysicsBodies {
+	std::vector<double> px, py, pz;
+	std::vector<double> vx, vy, vz;
+	std::vector<double> qx, qy, qz, qw;
+	std::vector<double> wx, wy, wz;
+	/** @brief linear and angular acceleration, held constant across the steps of one tick */
+	std::vector<double> ax, ay, az;
+	std::vector<double> awx, awy, awz;
+
+	/** @brief pose before the latest step, rendering blends from here to the current pose */
+	std::vector<double> prevPx, prevPy, prevPz;
+	std::vector<double> prevQx, prevQy, prevQz, prevQw;
+
+	size_t Size() const { return px.size(); }
+	void Resize(size_t count);
+	void SavePoses();
+};
+
+/**
+* Advance every body by dt seconds: velocities by their accelerations, then position by velocity and orientation by
+* angular velocity (semi-implicit Euler), then renormalise.
+*
+* Uses AVX or SSE2 when the build enables them, with a scalar loop for the remainder. Only adds, multiplies, a divide
+* and a square root are used, so every path rounds identically and the same input always gives the same bits.
+*/
+void IntegrateBodies(PhysicsBodies& bodies, double dt);
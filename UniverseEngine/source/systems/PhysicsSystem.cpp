@@ -1,25 +1,184 @@
 #include "PhysicsSystem.h"
+#include <cmath>
 #include "../3dmaths.h"
+#include "../SceneObject.h"
 
 void PhysicsSystem::tick(ECS::World* world, float deltaTime) {
 	//std::cout << "Ticking physics system" << std::endl;
-	world->each<TransformComponent, PhysicsComponent>([&](ECS::Entity* ent, ECS::ComponentHandle<TransformComponent> transform, ECS::ComponentHandle<PhysicsComponent> physics) {
 
+	m_Accumulator += (double)deltaTime;
+	uint32_t steps = (uint32_t)std::min(std::floor(m_Accumulator / m_FixedTimestep), (double)m_MaxStepsPerTick);
+	m_Accumulator -= steps * m_FixedTimestep;
+	m_Accumulator = std::min(m_Accumulator, m_FixedTimestep);
+
+	// Gather every moving body into the packed arrays, in entity order so runs are reproducible.
+	uint32_t count = 0;
+	world->each<TransformComponent, PhysicsComponent>([&](ECS::Entity* ent, ECS::ComponentHandle<TransformComponent> transform, ECS::ComponentHandle<PhysicsComponent> physics) {
 		if(physics->m_IsStatic)
 			return;
 
-		auto pos = transform->GetPosition();
-		//std::cout << "Got position: " << pos.x << ", " << pos.y << ", " << pos.z << std::endl;
+		if(!physics->m_HasSimulationState || transform->m_dPos != physics->m_PresentedPosition || transform->m_Rotation != physics->m_PresentedRotation) {
+			physics->m_Position = physics->m_PreviousPosition = transform->m_dPos;
+			physics->m_Orientation = physics->m_PreviousOrientation = glm::dquat(transform->m_Rotation);
+			physics->m_HasSimulationState = true;
+		}
+
+		physics->m_BodyIndex = count++;
+		if(m_Bodies.Size() < count) {
+			m_Bodies.Resize(count * 2);
+			m_ContactRadius.resize(count * 2);
+			m_ParentToWorld.resize(count * 2);
+		}
+
+		uint32_t i = physics->m_BodyIndex;
+		m_ContactRadius[i] = ent->has<Planet>() ? -1.0 : physics->m_Radius;
+		if(m_ContactRadius[i] >= 0.0)
+			m_ParentToWorld[i] = transform->m_Parent ? transform->m_Parent->GetTransform()->GetModelMatDouble() : glm::dmat4(1.0);
+		m_Bodies.px[i] = physics->m_Position.x;
+		m_Bodies.py[i] = physics->m_Position.y;
+		m_Bodies.pz[i] = physics->m_Position.z;
+		m_Bodies.vx[i] = physics->m_Velocity.x;
+		m_Bodies.vy[i] = physics->m_Velocity.y;
+		m_Bodies.vz[i] = physics->m_Velocity.z;
+		m_Bodies.qx[i] = physics->m_Orientation.x;
+		m_Bodies.qy[i] = physics->m_Orientation.y;
+		m_Bodies.qz[i] = physics->m_Orientation.z;
+		m_Bodies.qw[i] = physics->m_Orientation.w;
+		m_Bodies.wx[i] = physics->m_AngularVelocity.x;
+		m_Bodies.wy[i] = physics->m_AngularVelocity.y;
+		m_Bodies.wz[i] = physics->m_AngularVelocity.z;
+		m_Bodies.ax[i] = physics->m_Acceleration.x;
+		m_Bodies.ay[i] = physics->m_Acceleration.y;
+		m_Bodies.az[i] = physics->m_Acceleration.z;
+		m_Bodies.awx[i] = physics->m_AngularAcceleration.x;
+		m_Bodies.awy[i] = physics->m_AngularAcceleration.y;
+		m_Bodies.awz[i] = physics->m_AngularAcceleration.z;
+	});
+	m_Bodies.Resize(count);
+
+	for(uint32_t step = 0; step < steps; step++) {
+		if(step == steps - 1)
+			m_Bodies.SavePoses();
+		IntegrateBodies(m_Bodies, m_FixedTimestep);
+	}
+
+	if(steps > 0)
+		ResolveTerrainContacts(world, count);
 
-		auto vel = physics->m_Velocity;
-		//std::cout << "Got velocity: " << vel.x << ", " << vel.y << ", " << vel.z << std::endl;
+	double alpha = GetInterpolationAlpha();
 
-		//std::cout << "***" << std::endl;
+	// Every body only touches its own transform and physics, so this can be spread across the worker threads.
+	world->parallelEach<TransformComponent, PhysicsComponent>([&](ECS::Entity* ent, ECS::ComponentHandle<TransformComponent> transform, ECS::ComponentHandle<PhysicsComponent> physics) {
 
-		transform->MoveWorld(physics->m_Velocity * (double)deltaTime);
+		// The rates were applied over this tick's steps (or had no step to apply to), systems add them again next frame
+		physics->m_Acceleration = glm::dvec3(0.0);
+		physics->m_AngularAcceleration = glm::dvec3(0.0);
+
+		if(physics->m_IsStatic)
+			return;
+
+		uint32_t i = physics->m_BodyIndex;
+		if(steps > 0) {
+			physics->m_PreviousPosition = glm::dvec3(m_Bodies.prevPx[i], m_Bodies.prevPy[i], m_Bodies.prevPz[i]);
+			physics->m_PreviousOrientation = glm::dquat(m_Bodies.prevQw[i], m_Bodies.prevQx[i], m_Bodies.prevQy[i], m_Bodies.prevQz[i]);
+			physics->m_Position = glm::dvec3(m_Bodies.px[i], m_Bodies.py[i], m_Bodies.pz[i]);
+			physics->m_Orientation = glm::dquat(m_Bodies.qw[i], m_Bodies.qx[i], m_Bodies.qy[i], m_Bodies.qz[i]);
+			// accelerations and terrain contacts change velocity
+			physics->m_Velocity = glm::dvec3(m_Bodies.vx[i], m_Bodies.vy[i], m_Bodies.vz[i]);
+			physics->m_AngularVelocity = glm::dvec3(m_Bodies.wx[i], m_Bodies.wy[i], m_Bodies.wz[i]);
+		}
 
 		//std::cout << "Got rotation: " << glm::to_string(physics->m_AngularVelocity) << std::endl;
-		
-		transform->Rotate(physics->m_AngularVelocity * (double)deltaTime);
+
+		transform->m_dPos = glm::mix(physics->m_PreviousPosition, physics->m_Position, alpha);
+
+		// Short way round, then normalised lerp. Steps are small enough that this is as good as a slerp.
+		glm::dquat to = physics->m_Orientation;
+		if(glm::dot(physics->m_PreviousOrientation, to) < 0.0)
+			to = -to;
+		transform->m_Rotation = glm::quat(glm::normalize(physics->m_PreviousOrientation * (1.0 - alpha) + to * alpha));
+
+		glm::mat3 axes = glm::mat3(transform->m_Rotation);
+		transform->m_Right = axes[0];
+		transform->m_Up = axes[1];
+		transform->m_Forward = axes[2];
+		transform->MarkDirty();
+
+		physics->m_PresentedPosition = transform->m_dPos;
+		physics->m_PresentedRotation = transform->m_Rotation;
+	});
+}
+
+void PhysicsSystem::ResolveTerrainContacts(ECS::World* world, uint32_t count) {
+	world->each<TransformComponent, Planet>([&](ECS::Entity* ent, ECS::ComponentHandle<TransformComponent> transform, ECS::ComponentHandle<Planet> planet) {
+		auto query = planet->GetHeightQuery();
+		if(!query)
+			return;
+
+		glm::dmat4 planetToWorld = transform->GetModelMatDouble();
+		glm::dmat4 worldToPlanet = transform->GetInverseModelMatDouble();
+		double reach = query->Sampler().MaxHeight();
+
+		// Only bodies close enough to touch the highest mountain need a height
+		m_ContactBodies.clear();
+		m_ContactDirections.clear();
+		for(uint32_t i = 0; i < count; i++) {
+			if(m_ContactRadius[i] < 0.0)
+				continue;
+
+			// Body positions are in their parent's space
+			glm::dvec3 local = glm::dvec3(worldToPlanet * m_ParentToWorld[i] * glm::dvec4(m_Bodies.px[i], m_Bodies.py[i], m_Bodies.pz[i], 1.0));
+			if(glm::length(local) - m_ContactRadius[i] > reach)
+				continue;
+
+			m_ContactBodies.push_back(i);
+			m_ContactDirections.push_back(glm::vec3(local));
+		}
+		if(m_ContactBodies.empty())
+			return;
+
+		m_ContactHeights.resize(m_ContactBodies.size());
+		query->HeightAt(m_ContactDirections.data(), m_ContactHeights.data(), m_ContactBodies.size());
+
+		for(size_t c = 0; c < m_ContactBodies.size(); c++) {
+			uint32_t i = m_ContactBodies[c];
+			// Between the planet's space and the body's parent's, where its position, pose and velocity are kept
+			glm::dmat4 parentToPlanet = worldToPlanet * m_ParentToWorld[i];
+			glm::dmat4 planetToParent = glm::inverse(m_ParentToWorld[i]) * planetToWorld;
+			glm::dvec3 centre = glm::dvec3(planetToParent * glm::dvec4(0.0, 0.0, 0.0, 1.0));
+			glm::dvec3 position(m_Bodies.px[i], m_Bodies.py[i], m_Bodies.pz[i]);
+			glm::dvec3 local = glm::dvec3(parentToPlanet * glm::dvec4(position, 1.0));
+			double ground = (double)m_ContactHeights[c] + m_ContactRadius[i];
+			double distance = glm::length(local);
+			if(distance >= ground || distance <= 0.0)
+				continue;
+
+			position = glm::dvec3(planetToParent * glm::dvec4(local * (ground / distance), 1.0));
+			m_Bodies.px[i] = position.x;
+			m_Bodies.py[i] = position.y;
+			m_Bodies.pz[i] = position.z;
+
+			// The frame is drawn between the previous and the new position, so lift the previous one out of the ground
+			// as well or the body is shown sinking in and popping back out. The height under the new position stands in
+			// for the one under the old, a step apart.
+			glm::dvec3 previous = glm::dvec3(parentToPlanet * glm::dvec4(m_Bodies.prevPx[i], m_Bodies.prevPy[i], m_Bodies.prevPz[i], 1.0));
+			double previousDistance = glm::length(previous);
+			if(previousDistance < ground && previousDistance > 0.0) {
+				previous = glm::dvec3(planetToParent * glm::dvec4(previous * (ground / previousDistance), 1.0));
+				m_Bodies.prevPx[i] = previous.x;
+				m_Bodies.prevPy[i] = previous.y;
+				m_Bodies.prevPz[i] = previous.z;
+			}
+
+			glm::dvec3 up = glm::normalize(position - centre);
+			glm::dvec3 velocity(m_Bodies.vx[i], m_Bodies.vy[i], m_Bodies.vz[i]);
+			double into = glm::dot(velocity, up);
+			if(into < 0.0) {
+				velocity -= up * into;
+				m_Bodies.vx[i] = velocity.x;
+				m_Bodies.vy[i] = velocity.y;
+				m_Bodies.vz[i] = velocity.z;
+			}
+		}
 	});
 }
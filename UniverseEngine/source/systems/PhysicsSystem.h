@@ -1,12 +1,46 @@
 #pragma once
 #include "../ECS.h"
 #include "../components/Components.h"
+#include "PhysicsIntegrator.h"
 
 
+/**
+* Moves bodies by their velocities in fixed steps, however long the frame was, so the simulation doesn't depend on
+* frame rate. Leftover time is carried to the next tick and the transforms show the pose blended by
+* GetInterpolationAlpha() between the last two steps.
+*
+* After stepping, bodies that ended up below a planet's terrain (by their radius) are put back on the surface and lose
+* the part of their velocity going into the ground. Heights come from the planet's HeightQuery.
+*/
 class PhysicsSystem : public ECS::EntitySystem {
 public:
-	PhysicsSystem() = default;
+	PhysicsSystem() {
+		writes<PhysicsComponent, TransformComponent>();
+		reads<Planet>();
+	}
 	virtual ~PhysicsSystem() = default;
 
 	virtual void tick(ECS::World* world, float deltaTime) override;
-};
\ No newline at end of file
+
+	/** @brief seconds simulated by one step */
+	double m_FixedTimestep = 1.0 / 60.0;
+	/** @brief steps allowed per tick, time beyond this is dropped so a long stall can't snowball */
+	uint32_t m_MaxStepsPerTick = 8;
+
+	/** @brief how far (0 to 1) rendering is between the previous and the current step */
+	double GetInterpolationAlpha() const { return m_Accumulator / m_FixedTimestep; }
+
+private:
+	double m_Accumulator = 0.0;
+	PhysicsBodies m_Bodies;
+
+	/** @brief per body, how far its surface is from its centre, negative for planets which never touch terrain */
+	std::vector<double> m_ContactRadius;
+	/** @brief per body, its parent's world matrix. Bodies move in their parent's space, planets are met in world space */
+	std::vector<glm::dmat4> m_ParentToWorld;
+	std::vector<uint32_t> m_ContactBodies;
+	std::vector<glm::vec3> m_ContactDirections;
+	std::vector<float> m_ContactHeights;
+
+	void ResolveTerrainContacts(ECS::World* world, uint32_t count);
+};
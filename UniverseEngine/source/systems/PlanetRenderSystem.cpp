@@ -10,7 +10,12 @@
 #include "glm/gtx/vector_angle.hpp"
 
 
-PlanetRenderSystem::PlanetRenderSystem() {}
+PlanetRenderSystem::PlanetRenderSystem() {
+	reads<TransformComponent, CameraComponent>();
+	writes<Planet>();
+	// uploads planet buffers through the graphics queue
+	runsOnMainThread();
+}
 
 
 PlanetRenderSystem::~PlanetRenderSystem() {}
@@ -33,7 +38,19 @@ void PlanetRenderSystem::tick(ECS::World* world, float deltaTime) {
 		auto cam = UniEngine::GetInstance()->GetSceneManager()->CurrentScene()->GetCameraComponent();
 		auto transform = entity->get<TransformComponent>();
 		
-		auto camPos = transform->TransformWSToLocal(cam->GetPosition());
+		auto camPos = glm::vec3(transform->GetInverseModelMatDouble() * glm::dvec4(cam->GetWorldPosition(), 1.0));
+		auto modelMat = cam->RelativeToCamera(transform->GetModelMatDouble());
+
+		// A static grid follows the camera through the uniforms, nothing to rebuild or upload
+		if(planet->m_StaticGrid) {
+			if(!isCameraPaused)
+				planet->SetCameraPosition(camPos);
+			planet->UpdateUniformBuffers(modelMat, camPos);
+			if(auto query = planet->GetHeightQuery())
+				query->EndFrame();
+			return;
+		}
+
 		auto camDistance = glm::length(camPos);
 		auto storedPos = planet->CameraPos();
 		auto storedDistance = glm::length(storedPos);
@@ -55,13 +72,17 @@ void PlanetRenderSystem::tick(ECS::World* world, float deltaTime) {
 		if(camDistance < planet->GetRadius() + planet->GetRadius() * 0.01)
 			shouldUpdateCamera = true;
 		
-		if(!isCameraPaused)// && shouldUpdateCamera)
+		// The grid only has to follow the camera once it has moved far enough for the old one to show, rebuilding
+		// and uploading it every frame was the biggest cost of a still camera.
+		if(!isCameraPaused && shouldUpdateCamera) {
 			planet->SetCameraPosition(camPos);
+			planet->UpdateMesh();
+			planet->UpdateBuffers();
+		}
 
-		auto modelMat = transform->GetModelMat();
+		planet->UpdateUniformBuffers(modelMat, camPos);
 
-		planet->UpdateMesh();
-		planet->UpdateBuffers();
-		planet->UpdateUniformBuffers(modelMat);
+		if(auto query = planet->GetHeightQuery())
+			query->EndFrame();
 	});
 }
@@ -65,13 +65,13 @@ void PlayerControlSystem::tick(ECS::World* world, float deltaTime) {
 
 			if(!isFullStop) {
 				if(glm::length(rotation) != 0.0) {
-					physics->AddAngularVelocity(glm::normalize(rotation) * deltaTime);
+					physics->AddAngularAcceleration(glm::normalize(rotation));
 					//std::cout << "Got input rotation " << glm::to_string(rotation * 90.0f) << std::endl;
 				}
 
 				direction = transform->TransformLocalDirectionToWorldSpace(direction);
 
-				physics->AddForce(direction * m_BoostFactor * 5515.3f * deltaTime);
+				physics->AddForce(direction * m_BoostFactor * 5515.3f);
 			} else {
 				physics->FullStop();
 			}
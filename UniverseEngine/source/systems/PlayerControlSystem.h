@@ -17,6 +17,13 @@ public:
 	bool isFullStop = false;
 
 
+	PlayerControlSystem() {
+		reads<PlayerControlComponent, TransformComponent>();
+		writes<PhysicsComponent>();
+		// the input state above is written by InputEvent from the main thread
+		runsOnMainThread();
+	}
+
 	virtual ~PlayerControlSystem() {}
 
 	virtual void receive(ECS::World* world, const InputEvent& event) override;
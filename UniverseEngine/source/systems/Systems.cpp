@@ -25,3 +25,16 @@ void CameraSystem::tick(ECS::World* world, float deltaTime) {
 		camera->CalculateView(transform);
 	});
 }
+
+
+void TransformSystem::tick(ECS::World* world, float deltaTime) {
+	// 0 is what a new transform starts with, so skip it when wrapping round
+	if(++m_Frame == 0)
+		m_Frame = 1;
+
+	// UpdateHierarchy visits parents first and skips anything already done this frame, so every transform is
+	// updated once however deep the chain is. It writes the parents too, which is why this stays serial.
+	world->each<TransformComponent>([&](ECS::Entity* ent, ECS::ComponentHandle<TransformComponent> transform) {
+		transform->UpdateHierarchy(m_Frame);
+	});
+}
@@ -3,6 +3,7 @@
 #include "../ECS.h"
 #include "../components/Components.h"
 #include "AudioSystem.h"
+#include "FloatingOriginSystem.h"
 #include "GravitySystem.h"
 #include "ModelRenderSystem.h"
 #include "PhysicsSystem.h"
@@ -11,7 +12,10 @@
 
 class MovementSystem : public ECS::EntitySystem {
  public:
-  MovementSystem() {}
+  MovementSystem() {
+    reads<MovementComponent>();
+    writes<TransformComponent>();
+  }
 
   virtual ~MovementSystem() {}
 
@@ -20,9 +24,31 @@ class MovementSystem : public ECS::EntitySystem {
 
 class CameraSystem : public ECS::EntitySystem {
  public:
-  CameraSystem() {}
+  CameraSystem() {
+    reads<TransformComponent>();
+    writes<CameraComponent>();
+  }
 
   virtual ~CameraSystem() {}
 
   virtual void tick(ECS::World* world, float deltaTime) override;
-};
\ No newline at end of file
+};
+
+/**
+* Refreshes the cached matrices of every transform once per frame, parents before children, so a transform is only
+* recalculated when it or something above it moved. Register it after the systems that move things and before the
+* ones that read world matrices, which then get the cached ones.
+*/
+class TransformSystem : public ECS::EntitySystem {
+ public:
+  TransformSystem() {
+    writes<TransformComponent>();
+  }
+
+  virtual ~TransformSystem() {}
+
+  virtual void tick(ECS::World* world, float deltaTime) override;
+
+ private:
+  uint32_t m_Frame = 0;
+};
@@ -1,10 +1,22 @@
 #pragma once
 #include <vulkan/vulkan_core.h>
+#include "../3dmaths.h"
+
+namespace uni {
+	namespace render {
+		class RenderQueue;
+	}
+}
 
 struct CameraPauseEvent {
 	bool value = false;
 };
 
+// Switch GravitySystem between the biggest planet's pull and Barnes-Hut N-body gravity.
+struct GravityModeEvent {
+	bool nBody = false;
+};
+
 struct InputEvent {
 	int axis;
 	float value;
@@ -18,6 +30,16 @@ struct RenderEvent {
   VkCommandBuffer& cmdBuffer;
 };
 
+// Sent once before the command buffers of every swapchain image are recorded, fill the queue and Build it.
+struct RenderQueueEvent {
+  uni::render::RenderQueue& queue;
+};
+
 struct LevelStartEvent {
   bool isStarted;
-};
\ No newline at end of file
+};
+
+// Everything at the root of the scene was just moved by -shift to bring the camera back to the origin.
+struct OriginShiftEvent {
+  glm::dvec3 shift;
+};
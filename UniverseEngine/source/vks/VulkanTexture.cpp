@@ -85,48 +85,7 @@ void vks::Texture2D::loadFromFile(std::string filename, VkFormat format, vks::Vu
   VkMemoryAllocateInfo memAllocInfo = vks::initializers::memoryAllocateInfo();
   VkMemoryRequirements memReqs;
 
-  // Use a separate command buffer for texture loading
-  VkCommandBuffer copyCmd =
-    device->createCommandBuffer(VK_COMMAND_BUFFER_LEVEL_PRIMARY, true);
-
   if (useStaging) {
-    // Create a host-visible staging buffer that contains the raw image data
-    VkBuffer stagingBuffer;
-    VkDeviceMemory stagingMemory;
-
-    VkBufferCreateInfo bufferCreateInfo =
-      vks::initializers::bufferCreateInfo();
-    bufferCreateInfo.size = (int)bitmap.stride * (int)bitmap.height;
-    // This buffer is used as a transfer source for the buffer copy
-    bufferCreateInfo.usage = VK_BUFFER_USAGE_TRANSFER_SRC_BIT;
-    bufferCreateInfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
-
-    VK_CHECK_RESULT(vkCreateBuffer(device->logicalDevice, &bufferCreateInfo,
-      nullptr, &stagingBuffer));
-
-    // Get memory requirements for the staging buffer (alignment, memory type
-    // bits)
-    vkGetBufferMemoryRequirements(device->logicalDevice, stagingBuffer,
-      &memReqs);
-
-    memAllocInfo.allocationSize = memReqs.size;
-    // Get memory type index for a host visible buffer
-    memAllocInfo.memoryTypeIndex = device->getMemoryType(
-      memReqs.memoryTypeBits, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT |
-      VK_MEMORY_PROPERTY_HOST_COHERENT_BIT);
-
-    VK_CHECK_RESULT(vkAllocateMemory(device->logicalDevice, &memAllocInfo,
-      nullptr, &stagingMemory));
-    VK_CHECK_RESULT(vkBindBufferMemory(device->logicalDevice, stagingBuffer,
-      stagingMemory, 0));
-
-    // Copy texture data into staging buffer
-    uint8_t * data;
-    VK_CHECK_RESULT(vkMapMemory(device->logicalDevice, stagingMemory, 0,
-      memReqs.size, 0, (void**)& data));
-    memcpy(data, bitmap.address<mango::u8>(0, 0), (int)bitmap.height * (int)bitmap.stride);
-    vkUnmapMemory(device->logicalDevice, stagingMemory);
-
     // Setup buffer copy regions for each mip level
     std::vector<VkBufferImageCopy> bufferCopyRegions;
     uint32_t offset = 0;
@@ -186,34 +145,13 @@ void vks::Texture2D::loadFromFile(std::string filename, VkFormat format, vks::Vu
     subresourceRange.levelCount = mipLevels;
     subresourceRange.layerCount = 1;
 
-    // Image barrier for optimal image (target)
-    // Optimal image will be used as destination for the copy
-    vks::tools::setImageLayout(copyCmd, image, VK_IMAGE_LAYOUT_UNDEFINED,
-      VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
-      subresourceRange);
-
-    // Copy mip levels from staging buffer
-    vkCmdCopyBufferToImage(copyCmd, stagingBuffer, image,
-      VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
-      static_cast<uint32_t>(bufferCopyRegions.size()),
-      bufferCopyRegions.data());
-
-    // Change texture image layout to shader read after all mip levels have
-    // been copied
+    // Staged and copied by the upload manager, the image is ready for any
+    // later submit to the graphics queue without waiting here
     this->imageLayout = imageLayout;
-    vks::tools::setImageLayout(copyCmd, image,
-      VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
-      imageLayout, subresourceRange);
-
-
-    {
-      std::lock_guard<std::mutex> guard(UniEngine::GetInstance()->m_QueueMutex);
-      device->flushCommandBuffer(copyCmd, copyQueue);
-    }
-
-    // Clean up staging resources
-    vkFreeMemory(device->logicalDevice, stagingMemory, nullptr);
-    vkDestroyBuffer(device->logicalDevice, stagingBuffer, nullptr);
+    auto& uploads = UniEngine::GetInstance()->GetUploadManager();
+    uploads.copyToImage(bitmap.address<mango::u8>(0, 0), offset, image,
+      bufferCopyRegions, subresourceRange, imageLayout);
+    uploads.submit();
   }
   else {
     // Prefer using optimal tiling, as linear tiling
@@ -293,6 +231,9 @@ void vks::Texture2D::loadFromFile(std::string filename, VkFormat format, vks::Vu
     deviceMemory = mappableMemory;
     this->imageLayout = imageLayout;
 
+    VkCommandBuffer copyCmd =
+      device->createCommandBuffer(VK_COMMAND_BUFFER_LEVEL_PRIMARY, true);
+
     // Setup image memory barrier
     vks::tools::setImageLayout(copyCmd, image, VK_IMAGE_ASPECT_COLOR_BIT,
       VK_IMAGE_LAYOUT_UNDEFINED, imageLayout);
@@ -364,46 +305,6 @@ void vks::Texture2D::fromBuffer(void* buffer, VkDeviceSize bufferSize, VkFormat
   VkMemoryAllocateInfo memAllocInfo = vks::initializers::memoryAllocateInfo();
   VkMemoryRequirements memReqs;
 
-  // Use a separate command buffer for texture loading
-  VkCommandBuffer copyCmd =
-    device->createCommandBuffer(VK_COMMAND_BUFFER_LEVEL_PRIMARY, true);
-
-  // Create a host-visible staging buffer that contains the raw image data
-  VkBuffer stagingBuffer;
-  VkDeviceMemory stagingMemory;
-
-  VkBufferCreateInfo bufferCreateInfo = vks::initializers::bufferCreateInfo();
-  bufferCreateInfo.size = bufferSize;
-  // This buffer is used as a transfer source for the buffer copy
-  bufferCreateInfo.usage = VK_BUFFER_USAGE_TRANSFER_SRC_BIT;
-  bufferCreateInfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
-
-  VK_CHECK_RESULT(vkCreateBuffer(device->logicalDevice, &bufferCreateInfo,
-    nullptr, &stagingBuffer));
-
-  // Get memory requirements for the staging buffer (alignment, memory type
-  // bits)
-  vkGetBufferMemoryRequirements(device->logicalDevice, stagingBuffer,
-    &memReqs);
-
-  memAllocInfo.allocationSize = memReqs.size;
-  // Get memory type index for a host visible buffer
-  memAllocInfo.memoryTypeIndex = device->getMemoryType(
-    memReqs.memoryTypeBits, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT |
-    VK_MEMORY_PROPERTY_HOST_COHERENT_BIT);
-
-  VK_CHECK_RESULT(vkAllocateMemory(device->logicalDevice, &memAllocInfo,
-    nullptr, &stagingMemory));
-  VK_CHECK_RESULT(vkBindBufferMemory(device->logicalDevice, stagingBuffer,
-    stagingMemory, 0));
-
-  // Copy texture data into staging buffer
-  uint8_t * data;
-  VK_CHECK_RESULT(vkMapMemory(device->logicalDevice, stagingMemory, 0,
-    memReqs.size, 0, (void**)& data));
-  memcpy(data, buffer, bufferSize);
-  vkUnmapMemory(device->logicalDevice, stagingMemory);
-
   VkBufferImageCopy bufferCopyRegion = {};
   bufferCopyRegion.imageSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
   bufferCopyRegion.imageSubresource.mipLevel = 0;
@@ -450,32 +351,13 @@ void vks::Texture2D::fromBuffer(void* buffer, VkDeviceSize bufferSize, VkFormat
   subresourceRange.levelCount = mipLevels;
   subresourceRange.layerCount = 1;
 
-  // Image barrier for optimal image (target)
-  // Optimal image will be used as destination for the copy
-  vks::tools::setImageLayout(copyCmd, image, VK_IMAGE_LAYOUT_UNDEFINED,
-    VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
-    subresourceRange);
-
-  // Copy mip levels from staging buffer
-  vkCmdCopyBufferToImage(copyCmd, stagingBuffer, image,
-    VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, 1,
-    &bufferCopyRegion);
-
-  // Change texture image layout to shader read after all mip levels have been
-  // copied
+  // Staged and copied by the upload manager, the image is ready for any later
+  // submit to the graphics queue without waiting here
   this->imageLayout = imageLayout;
-  vks::tools::setImageLayout(copyCmd, image,
-    VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
-    imageLayout, subresourceRange);
-
-  {
-    std::lock_guard<std::mutex> guard(UniEngine::GetInstance()->m_QueueMutex);
-    device->flushCommandBuffer(copyCmd, copyQueue);
-  }
-
-  // Clean up staging resources
-  vkFreeMemory(device->logicalDevice, stagingMemory, nullptr);
-  vkDestroyBuffer(device->logicalDevice, stagingBuffer, nullptr);
+  auto& uploads = UniEngine::GetInstance()->GetUploadManager();
+  uploads.copyToImage(buffer, bufferSize, image, { bufferCopyRegion },
+    subresourceRange, imageLayout);
+  uploads.submit();
 
   // Create sampler
   VkSamplerCreateInfo samplerCreateInfo = {};
@@ -61,8 +61,8 @@ class Texture2D : public Texture {
    * @param filename File to load (supports .ktx and .dds)
    * @param format Vulkan format of the image data stored in the file
    * @param device Vulkan device to create the texture on
-   * @param copyQueue Queue used for the texture staging copy commands (must
-   * support transfer)
+   * @param copyQueue Queue used for the layout change of linear textures,
+   * optimal ones go through the engine's upload manager without waiting
    * @param (Optional) imageUsageFlags Usage flags for the texture's image
    * (defaults to VK_IMAGE_USAGE_SAMPLED_BIT)
    * @param (Optional) imageLayout Usage layout for the texture (defaults
@@ -89,8 +89,8 @@ class Texture2D : public Texture {
    * @param height Height of the texture to create
    * @param format Vulkan format of the image data stored in the file
    * @param device Vulkan device to create the texture on
-   * @param copyQueue Queue used for the texture staging copy commands (must
-   * support transfer)
+   * @param copyQueue Unused, the data goes through the engine's upload
+   * manager without waiting
    * @param (Optional) filter Texture filtering for the sampler (defaults to
    * VK_FILTER_LINEAR)
    * @param (Optional) imageUsageFlags Usage flags for the texture's image
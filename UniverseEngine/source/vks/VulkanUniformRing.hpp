@@ -0,0 +1,165 @@
+/*
+* Vulkan uniform ring
+*
+* Persistently mapped per-image uniform memory addressed through dynamic offsets
+*
+* This code is licensed under the MIT license (MIT) (http://opensource.org/licenses/MIT)
+*/
+
+#pragma once
+
+#include <string.h>
+#include <vector>
+#include "vulkan/vulkan.h"
+#include "VulkanTools.h"
+#include "VulkanBuffer.hpp"
+#include "VulkanDevice.hpp"
+
+namespace vks
+{
+	/**
+	* @brief One host visible uniform buffer, mapped once and split into a slice per swapchain image
+	*
+	* beginFrame() waits for the fence of the image about to be drawn and starts its slice from the front. push() copies
+	* a uniform block into that slice and returns its offset within the slice. Command buffers recorded for image i bind
+	* a VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC descriptor written from descriptor() at frameOffset(i) plus that offset,
+	* so blocks have to be pushed in the same order every frame. The memory is coherent, nothing is flushed or submitted.
+	*
+	* The frame's submit signals fence(), the next beginFrame() of the same image waits for it before writing, so a slice
+	* is never written while a submitted frame can still read it.
+	*/
+	class UniformRing
+	{
+	public:
+		/**
+		* Create the ring and map it
+		*
+		* @param device Device to allocate from
+		* @param frameSize Bytes available to push() per frame
+		* @param frameCount Number of slices, one per swapchain image
+		*/
+		void create(vks::VulkanDevice* device, VkDeviceSize frameSize, uint32_t frameCount)
+		{
+			this->device = device;
+			this->frameCount = frameCount;
+
+			alignment = device->properties.limits.minUniformBufferOffsetAlignment;
+			if (alignment == 0)
+			{
+				alignment = 16;
+			}
+			sliceSize = alignUp(frameSize);
+
+			VK_CHECK_RESULT(device->createBuffer(
+				VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT,
+				VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
+				&buffer, sliceSize * frameCount));
+			VK_CHECK_RESULT(buffer.map());
+
+			// Signaled, the first frame of each slice has nothing to wait for
+			VkFenceCreateInfo fenceInfo{};
+			fenceInfo.sType = VK_STRUCTURE_TYPE_FENCE_CREATE_INFO;
+			fenceInfo.flags = VK_FENCE_CREATE_SIGNALED_BIT;
+			fences.resize(frameCount);
+			for (auto& fence : fences)
+			{
+				VK_CHECK_RESULT(vkCreateFence(device->logicalDevice, &fenceInfo, nullptr, &fence));
+			}
+
+			frame = 0;
+			head = 0;
+		}
+
+		/** @brief Unmap and release the ring, the caller makes sure no frame using it is still in flight */
+		void destroy()
+		{
+			if (!device)
+			{
+				return;
+			}
+			for (auto fence : fences)
+			{
+				vkDestroyFence(device->logicalDevice, fence, nullptr);
+			}
+			fences.clear();
+			buffer.unmap();
+			buffer.destroy();
+			device = nullptr;
+		}
+
+		/**
+		* Start the slice of a swapchain image, after the last frame submitted with its fence has finished
+		*
+		* @param image Swapchain image about to be drawn, its frame has to be submitted with fence()
+		*/
+		void beginFrame(uint32_t image)
+		{
+			frame = image % frameCount;
+			head = 0;
+			VK_CHECK_RESULT(vkWaitForFences(device->logicalDevice, 1, &fences[frame], VK_TRUE, UINT64_MAX));
+			VK_CHECK_RESULT(vkResetFences(device->logicalDevice, 1, &fences[frame]));
+		}
+
+		/**
+		* Copy a uniform block into this frame's slice
+		*
+		* @param data Uniform data, copied before this returns
+		* @param size Size of the block, the descriptor's range
+		*
+		* @return Offset of the block within the slice, the same for every image when pushed in the same order
+		*/
+		uint32_t push(const void* data, VkDeviceSize size)
+		{
+			VkDeviceSize aligned = alignUp(size);
+			if (head + aligned > sliceSize)
+			{
+				throw std::runtime_error("Uniform data does not fit in the frame's uniform ring slice");
+			}
+
+			VkDeviceSize offset = head;
+			memcpy((char*)buffer.mapped + frame * sliceSize + offset, data, (size_t)size);
+			head += aligned;
+			return static_cast<uint32_t>(offset);
+		}
+
+		/** @brief Buffer info for a VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC binding of blocks of the given size */
+		VkDescriptorBufferInfo descriptor(VkDeviceSize range) const
+		{
+			VkDescriptorBufferInfo info{};
+			info.buffer = buffer.buffer;
+			info.offset = 0;
+			info.range = range;
+			return info;
+		}
+
+		/** @brief Start of an image's slice, add it to what push() returned to get the dynamic offset */
+		uint32_t frameOffset(uint32_t image) const { return static_cast<uint32_t>((image % frameCount) * sliceSize); }
+		/** @brief Fence the current frame's submit has to signal */
+		VkFence fence() const { return fences[frame]; }
+
+		VkBuffer handle() const { return buffer.buffer; }
+		/** @brief Bytes pushed so far this frame, including alignment padding */
+		VkDeviceSize frameUsage() const { return head; }
+		VkDeviceSize frameCapacity() const { return sliceSize; }
+
+	private:
+		vks::VulkanDevice* device = nullptr;
+		vks::Buffer buffer;
+
+		VkDeviceSize alignment = 16;
+		VkDeviceSize sliceSize = 0;
+		uint32_t frameCount = 1;
+		/** @brief Signaled by the last submit that read each slice */
+		std::vector<VkFence> fences;
+
+		/** @brief Slice pushed into this frame */
+		uint32_t frame = 0;
+		/** @brief Next free byte in the current slice */
+		VkDeviceSize head = 0;
+
+		VkDeviceSize alignUp(VkDeviceSize size) const
+		{
+			return (size + alignment - 1) / alignment * alignment;
+		}
+	};
+}
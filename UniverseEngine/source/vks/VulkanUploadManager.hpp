@@ -0,0 +1,589 @@
+/*
+* Vulkan upload manager
+*
+* Batched buffer and image uploads through persistently mapped staging memory, on a dedicated transfer queue when
+* the device has one
+*
+* This code is licensed under the MIT license (MIT) (http://opensource.org/licenses/MIT)
+*/
+
+#pragma once
+
+#include <chrono>
+#include <deque>
+#include <mutex>
+#include <vector>
+#include <string.h>
+#include "vulkan/vulkan.h"
+#include "VulkanTools.h"
+#include "VulkanBuffer.hpp"
+#include "VulkanDevice.hpp"
+
+namespace vks
+{
+	/** @brief Identifies one UploadManager::submit(), later submissions have larger tickets */
+	typedef uint64_t UploadTicket;
+
+	/**
+	* @brief Stages uploads in one host visible ring buffer, mapped once, and copies them to their destinations in batches
+	*
+	* copy() and copyToImage() write straight into the mapping and record the transfer. submit() sends everything
+	* recorded since the last submit with a fence and hands back a ticket, without waiting for it. Ring space is only
+	* written again once the fence of the submission that read it has signalled, so nothing blocks unless the ring is
+	* full or a caller waits on a ticket. An upload bigger than the whole ring gets a staging buffer of its own, freed
+	* once its submission has finished.
+	*
+	* When the device has a transfer queue family apart from graphics the copies run on it and ownership of every
+	* destination is released to the graphics family, then acquired by a small command buffer on the graphics queue
+	* that waits on the transfer. Anything submitted to the graphics queue afterwards sees the data. Without one the
+	* copies go to the graphics queue, behind barriers that order them after earlier work and before later work.
+	*
+	* On the transfer queue nothing orders a copy after graphics work still reading the destination, so overwrite a
+	* destination only once the frames using it are done (the engine waits for the queue at the end of every frame).
+	* All methods can be called from any thread.
+	*/
+	class UploadManager
+	{
+	public:
+		struct Stats
+		{
+			/** @brief Bytes staged */
+			VkDeviceSize bytes = 0;
+			uint32_t submits = 0;
+			/** @brief Time spent blocked on the GPU, waiting for ring space or for a ticket */
+			double stallMs = 0.0;
+		};
+
+		/**
+		* Create the staging ring, map it and pick the queue uploads go to
+		*
+		* @param device Device to allocate from, its transfer queue family is used when it differs from graphics
+		* @param graphicsQueue Queue the uploaded resources are used on
+		* @param size Staging capacity in bytes, bigger uploads are staged in a buffer of their own
+		* @param graphicsQueueMutex (Optional) Held while submitting to the graphics queue when other threads submit to it too
+		*/
+		void create(vks::VulkanDevice* device, VkQueue graphicsQueue, VkDeviceSize size, std::mutex* graphicsQueueMutex = nullptr)
+		{
+			this->device = device;
+			this->graphicsQueue = graphicsQueue;
+			this->graphicsQueueMutex = graphicsQueueMutex;
+
+			graphicsFamily = device->queueFamilyIndices.graphics;
+			transferFamily = device->queueFamilyIndices.transfer;
+			dedicated = transferFamily != graphicsFamily;
+
+			graphicsPool = device->createCommandPool(graphicsFamily);
+			if (dedicated)
+			{
+				vkGetDeviceQueue(device->logicalDevice, transferFamily, 0, &transferQueue);
+				transferPool = device->createCommandPool(transferFamily);
+			}
+			else
+			{
+				transferQueue = graphicsQueue;
+				transferPool = graphicsPool;
+			}
+
+			VK_CHECK_RESULT(device->createBuffer(
+				VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
+				VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
+				&buffer, size));
+			VK_CHECK_RESULT(buffer.map());
+			// buffer.size is the allocation, which can be bigger than the buffer itself
+			ringSize = size;
+			head = tail = used = batchBytes = 0;
+		}
+
+		/** @brief Wait for every upload still in flight and release the ring */
+		void destroy()
+		{
+			if (!device)
+			{
+				return;
+			}
+			wait();
+			buffer.unmap();
+			buffer.destroy();
+			if (dedicated)
+			{
+				vkDestroyCommandPool(device->logicalDevice, transferPool, nullptr);
+			}
+			vkDestroyCommandPool(device->logicalDevice, graphicsPool, nullptr);
+			device = nullptr;
+		}
+
+		/**
+		* Stage data and record a copy of it into dst
+		*
+		* @param data Source data, copied before this returns
+		* @param size Bytes to copy
+		* @param dst Destination buffer, needs VK_BUFFER_USAGE_TRANSFER_DST_BIT
+		* @param dstOffset (Optional) Byte offset into dst
+		*/
+		void copy(const void* data, VkDeviceSize size, VkBuffer dst, VkDeviceSize dstOffset = 0)
+		{
+			if (size == 0)
+			{
+				return;
+			}
+
+			std::lock_guard<std::mutex> lock(mutex);
+			VkBuffer src;
+			VkDeviceSize offset = stage(data, size, src);
+
+			VkBufferCopy copyRegion{};
+			copyRegion.srcOffset = offset;
+			copyRegion.dstOffset = dstOffset;
+			copyRegion.size = size;
+			vkCmdCopyBuffer(cmdBuffer, src, dst, 1, &copyRegion);
+
+			if (dedicated)
+			{
+				VkBufferMemoryBarrier barrier = vks::initializers::bufferMemoryBarrier();
+				barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+				barrier.srcQueueFamilyIndex = transferFamily;
+				barrier.dstQueueFamilyIndex = graphicsFamily;
+				barrier.buffer = dst;
+				barrier.offset = dstOffset;
+				barrier.size = size;
+				bufferTransfers.push_back(barrier);
+			}
+		}
+
+		/**
+		* Stage data and record a copy of it into an image, which ends up in finalLayout
+		*
+		* The previous contents are discarded, so the regions should cover every subresource in range.
+		*
+		* @param data Source data, copied before this returns
+		* @param size Bytes to copy
+		* @param image Destination image, needs VK_IMAGE_USAGE_TRANSFER_DST_BIT
+		* @param regions Copies with buffer offsets relative to data
+		* @param range Subresources written by the regions
+		* @param finalLayout Layout the image is used in afterwards
+		*/
+		void copyToImage(const void* data, VkDeviceSize size, VkImage image, const std::vector<VkBufferImageCopy>& regions,
+			VkImageSubresourceRange range, VkImageLayout finalLayout)
+		{
+			if (size == 0 || regions.empty())
+			{
+				return;
+			}
+
+			std::lock_guard<std::mutex> lock(mutex);
+			VkBuffer src;
+			VkDeviceSize offset = stage(data, size, src);
+
+			VkImageMemoryBarrier toTransfer = vks::initializers::imageMemoryBarrier();
+			toTransfer.dstAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+			toTransfer.oldLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+			toTransfer.newLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
+			toTransfer.image = image;
+			toTransfer.subresourceRange = range;
+			vkCmdPipelineBarrier(cmdBuffer, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT, 0, 0, nullptr, 0, nullptr, 1, &toTransfer);
+
+			std::vector<VkBufferImageCopy> copyRegions = regions;
+			for (auto& region : copyRegions)
+			{
+				region.bufferOffset += offset;
+			}
+			vkCmdCopyBufferToImage(cmdBuffer, src, image, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+				static_cast<uint32_t>(copyRegions.size()), copyRegions.data());
+
+			VkImageMemoryBarrier toFinal = vks::initializers::imageMemoryBarrier();
+			toFinal.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+			toFinal.oldLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
+			toFinal.newLayout = finalLayout;
+			toFinal.image = image;
+			toFinal.subresourceRange = range;
+			if (dedicated)
+			{
+				// the layout changes as part of the ownership transfer
+				toFinal.srcQueueFamilyIndex = transferFamily;
+				toFinal.dstQueueFamilyIndex = graphicsFamily;
+				imageTransfers.push_back(toFinal);
+			}
+			else
+			{
+				toFinal.dstAccessMask = VK_ACCESS_MEMORY_READ_BIT;
+				vkCmdPipelineBarrier(cmdBuffer, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_ALL_COMMANDS_BIT, 0, 0, nullptr, 0, nullptr, 1, &toFinal);
+			}
+		}
+
+		/**
+		* Submit the uploads recorded since the last submit, returns straight away
+		*
+		* @return Ticket that completes once the uploads are visible to the graphics queue, the last ticket if nothing was recorded
+		*/
+		UploadTicket submit()
+		{
+			std::lock_guard<std::mutex> lock(mutex);
+			return submitBatch();
+		}
+
+		/** @brief True once the uploads of the ticket have finished */
+		bool isComplete(UploadTicket ticket)
+		{
+			std::lock_guard<std::mutex> lock(mutex);
+			retireSignalled();
+			return ticket <= completedTicket;
+		}
+
+		/** @brief Block until the uploads of the ticket have finished */
+		void wait(UploadTicket ticket)
+		{
+			std::lock_guard<std::mutex> lock(mutex);
+			while (completedTicket < ticket && !inFlight.empty())
+			{
+				retireOldest();
+			}
+		}
+
+		/** @brief Submit anything recorded and wait until every upload has finished, e.g. before destroying a destination */
+		void wait()
+		{
+			std::lock_guard<std::mutex> lock(mutex);
+			if (!device)
+			{
+				return;
+			}
+			submitBatch();
+			while (!inFlight.empty())
+			{
+				retireOldest();
+			}
+		}
+
+		/** @brief Close the current frame's stats, call once per frame */
+		void endFrame()
+		{
+			std::lock_guard<std::mutex> lock(mutex);
+			lastFrame = currentFrame;
+			total.bytes += currentFrame.bytes;
+			total.submits += currentFrame.submits;
+			total.stallMs += currentFrame.stallMs;
+			currentFrame = Stats();
+		}
+
+		/** @brief Stats of the last frame closed by endFrame() */
+		Stats frameStats()
+		{
+			std::lock_guard<std::mutex> lock(mutex);
+			return lastFrame;
+		}
+
+		/** @brief Stats of every closed frame together */
+		Stats totalStats()
+		{
+			std::lock_guard<std::mutex> lock(mutex);
+			return total;
+		}
+
+		/** @brief True when uploads run on their own transfer queue */
+		bool usesTransferQueue() const { return dedicated; }
+		VkDeviceSize capacity() const { return ringSize; }
+		/** @brief Bytes recorded or in flight that can't be reused yet */
+		VkDeviceSize inUse() const { return used; }
+
+	private:
+		struct Submission
+		{
+			UploadTicket ticket;
+			VkFence fence;
+			VkCommandBuffer cmdBuffer;
+			/** @brief Acquires ownership on the graphics queue, only with a dedicated transfer queue */
+			VkCommandBuffer acquireCmdBuffer;
+			VkSemaphore semaphore;
+			/** @brief Where the ring's head was when this was submitted, the tail moves here once it's done */
+			VkDeviceSize end;
+			VkDeviceSize bytes;
+			/** @brief Staging buffers of uploads too big for the ring, destroyed with the submission */
+			std::vector<vks::Buffer> oversized;
+		};
+
+		vks::VulkanDevice* device = nullptr;
+		vks::Buffer buffer;
+		std::mutex mutex;
+
+		VkQueue graphicsQueue = VK_NULL_HANDLE;
+		VkQueue transferQueue = VK_NULL_HANDLE;
+		std::mutex* graphicsQueueMutex = nullptr;
+		uint32_t graphicsFamily = 0;
+		uint32_t transferFamily = 0;
+		bool dedicated = false;
+		VkCommandPool graphicsPool = VK_NULL_HANDLE;
+		VkCommandPool transferPool = VK_NULL_HANDLE;
+
+		VkCommandBuffer cmdBuffer = VK_NULL_HANDLE;
+		/** @brief Ownership releases for the current batch, acquired again on the graphics queue */
+		std::vector<VkBufferMemoryBarrier> bufferTransfers;
+		std::vector<VkImageMemoryBarrier> imageTransfers;
+		/** @brief Staging buffers of the current batch's uploads that didn't fit in the ring */
+		std::vector<vks::Buffer> oversized;
+		std::deque<Submission> inFlight;
+
+		UploadTicket lastTicket = 0;
+		UploadTicket completedTicket = 0;
+
+		Stats currentFrame;
+		Stats lastFrame;
+		Stats total;
+
+		/** @brief Bytes of the ring the copies can read */
+		VkDeviceSize ringSize = 0;
+		/** @brief Next free byte */
+		VkDeviceSize head = 0;
+		/** @brief First byte still waiting on the GPU */
+		VkDeviceSize tail = 0;
+		/** @brief Bytes from tail to head, counting any left unused at the end when wrapping */
+		VkDeviceSize used = 0;
+		/** @brief Bytes taken by the uploads not submitted yet */
+		VkDeviceSize batchBytes = 0;
+
+		/** @brief Covers the texel size of every uncompressed format and the block size of the compressed ones */
+		static const VkDeviceSize Alignment = 16;
+
+		/**
+		* Copy data into the ring and make sure a command buffer is recording, returns the staging offset in src
+		*
+		* Data bigger than the ring goes to a buffer of its own instead, at offset 0, rather than waiting for a ring that
+		* could never hold it.
+		*/
+		VkDeviceSize stage(const void* data, VkDeviceSize size, VkBuffer& src)
+		{
+			retireSignalled();
+			VkDeviceSize offset = 0;
+			if (((size + Alignment - 1) & ~(Alignment - 1)) > ringSize)
+			{
+				vks::Buffer staging;
+				VK_CHECK_RESULT(device->createBuffer(
+					VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
+					VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
+					&staging, size, const_cast<void*>(data)));
+				oversized.push_back(staging);
+				src = staging.buffer;
+			}
+			else
+			{
+				offset = allocate(size);
+				memcpy((char*)buffer.mapped + offset, data, (size_t)size);
+				src = buffer.buffer;
+			}
+			currentFrame.bytes += size;
+
+			if (cmdBuffer == VK_NULL_HANDLE)
+			{
+				cmdBuffer = beginCommandBuffer(transferPool);
+				if (!dedicated)
+				{
+					// Anything reading the destinations earlier on the queue has to finish before they're overwritten
+					vkCmdPipelineBarrier(cmdBuffer, VK_PIPELINE_STAGE_ALL_COMMANDS_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT, 0, 0, nullptr, 0, nullptr, 0, nullptr);
+				}
+			}
+			return offset;
+		}
+
+		UploadTicket submitBatch()
+		{
+			if (cmdBuffer == VK_NULL_HANDLE)
+			{
+				return lastTicket;
+			}
+
+			Submission submission{};
+			VkFenceCreateInfo fenceInfo = vks::initializers::fenceCreateInfo(VK_FLAGS_NONE);
+			VK_CHECK_RESULT(vkCreateFence(device->logicalDevice, &fenceInfo, nullptr, &submission.fence));
+
+			if (dedicated)
+			{
+				// Release on the transfer queue...
+				vkCmdPipelineBarrier(cmdBuffer, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, 0, 0, nullptr,
+					static_cast<uint32_t>(bufferTransfers.size()), bufferTransfers.data(),
+					static_cast<uint32_t>(imageTransfers.size()), imageTransfers.data());
+				VK_CHECK_RESULT(vkEndCommandBuffer(cmdBuffer));
+
+				VkSemaphoreCreateInfo semaphoreInfo = vks::initializers::semaphoreCreateInfo();
+				VK_CHECK_RESULT(vkCreateSemaphore(device->logicalDevice, &semaphoreInfo, nullptr, &submission.semaphore));
+
+				VkSubmitInfo submitInfo = vks::initializers::submitInfo();
+				submitInfo.commandBufferCount = 1;
+				submitInfo.pCommandBuffers = &cmdBuffer;
+				submitInfo.signalSemaphoreCount = 1;
+				submitInfo.pSignalSemaphores = &submission.semaphore;
+				VK_CHECK_RESULT(vkQueueSubmit(transferQueue, 1, &submitInfo, VK_NULL_HANDLE));
+
+				// ...and acquire with the same barriers on the graphics queue once the copies are done
+				for (auto& barrier : bufferTransfers)
+				{
+					barrier.srcAccessMask = 0;
+					barrier.dstAccessMask = VK_ACCESS_MEMORY_READ_BIT;
+				}
+				for (auto& barrier : imageTransfers)
+				{
+					barrier.srcAccessMask = 0;
+					barrier.dstAccessMask = VK_ACCESS_MEMORY_READ_BIT;
+				}
+				submission.acquireCmdBuffer = beginCommandBuffer(graphicsPool);
+				vkCmdPipelineBarrier(submission.acquireCmdBuffer, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, VK_PIPELINE_STAGE_ALL_COMMANDS_BIT, 0, 0, nullptr,
+					static_cast<uint32_t>(bufferTransfers.size()), bufferTransfers.data(),
+					static_cast<uint32_t>(imageTransfers.size()), imageTransfers.data());
+				VK_CHECK_RESULT(vkEndCommandBuffer(submission.acquireCmdBuffer));
+				bufferTransfers.clear();
+				imageTransfers.clear();
+
+				VkPipelineStageFlags waitStage = VK_PIPELINE_STAGE_ALL_COMMANDS_BIT;
+				submitInfo = vks::initializers::submitInfo();
+				submitInfo.waitSemaphoreCount = 1;
+				submitInfo.pWaitSemaphores = &submission.semaphore;
+				submitInfo.pWaitDstStageMask = &waitStage;
+				submitInfo.commandBufferCount = 1;
+				submitInfo.pCommandBuffers = &submission.acquireCmdBuffer;
+				submitGraphics(submitInfo, submission.fence);
+			}
+			else
+			{
+				VkMemoryBarrier barrier = vks::initializers::memoryBarrier();
+				barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+				barrier.dstAccessMask = VK_ACCESS_MEMORY_READ_BIT;
+				vkCmdPipelineBarrier(cmdBuffer, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_ALL_COMMANDS_BIT, 0, 1, &barrier, 0, nullptr, 0, nullptr);
+				VK_CHECK_RESULT(vkEndCommandBuffer(cmdBuffer));
+
+				VkSubmitInfo submitInfo = vks::initializers::submitInfo();
+				submitInfo.commandBufferCount = 1;
+				submitInfo.pCommandBuffers = &cmdBuffer;
+				submitGraphics(submitInfo, submission.fence);
+			}
+
+			UploadTicket ticket = ++lastTicket;
+			submission.ticket = ticket;
+			submission.cmdBuffer = cmdBuffer;
+			submission.end = head;
+			submission.bytes = batchBytes;
+			submission.oversized.swap(oversized);
+			inFlight.push_back(std::move(submission));
+			currentFrame.submits++;
+
+			cmdBuffer = VK_NULL_HANDLE;
+			batchBytes = 0;
+			return ticket;
+		}
+
+		void submitGraphics(const VkSubmitInfo& submitInfo, VkFence fence)
+		{
+			if (graphicsQueueMutex)
+			{
+				std::lock_guard<std::mutex> guard(*graphicsQueueMutex);
+				VK_CHECK_RESULT(vkQueueSubmit(graphicsQueue, 1, &submitInfo, fence));
+			}
+			else
+			{
+				VK_CHECK_RESULT(vkQueueSubmit(graphicsQueue, 1, &submitInfo, fence));
+			}
+		}
+
+		VkCommandBuffer beginCommandBuffer(VkCommandPool pool)
+		{
+			VkCommandBufferAllocateInfo allocInfo = vks::initializers::commandBufferAllocateInfo(pool, VK_COMMAND_BUFFER_LEVEL_PRIMARY, 1);
+			VkCommandBuffer commandBuffer;
+			VK_CHECK_RESULT(vkAllocateCommandBuffers(device->logicalDevice, &allocInfo, &commandBuffer));
+
+			VkCommandBufferBeginInfo beginInfo = vks::initializers::commandBufferBeginInfo();
+			beginInfo.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
+			VK_CHECK_RESULT(vkBeginCommandBuffer(commandBuffer, &beginInfo));
+			return commandBuffer;
+		}
+
+		VkDeviceSize allocate(VkDeviceSize size)
+		{
+			size = (size + Alignment - 1) & ~(Alignment - 1);
+			const VkDeviceSize cap = ringSize;
+
+			while (true)
+			{
+				if (used == 0)
+				{
+					head = tail = 0;
+				}
+
+				if (head > tail || used == 0)
+				{
+					// free space is [head, cap) then [0, tail)
+					if (cap - head >= size)
+					{
+						return take(size);
+					}
+					if (tail >= size)
+					{
+						used += cap - head;
+						batchBytes += cap - head;
+						head = 0;
+						return take(size);
+					}
+				}
+				else if (head < tail && tail - head >= size)
+				{
+					return take(size);
+				}
+
+				// Full: make room by finishing the oldest submission, or submit what's recorded so far first
+				if (!inFlight.empty())
+				{
+					retireOldest();
+				}
+				else
+				{
+					submitBatch();
+				}
+			}
+		}
+
+		VkDeviceSize take(VkDeviceSize size)
+		{
+			VkDeviceSize offset = head;
+			head += size;
+			used += size;
+			batchBytes += size;
+			return offset;
+		}
+
+		void retireOldest()
+		{
+			Submission& submission = inFlight.front();
+			auto start = std::chrono::high_resolution_clock::now();
+			VK_CHECK_RESULT(vkWaitForFences(device->logicalDevice, 1, &submission.fence, VK_TRUE, DEFAULT_FENCE_TIMEOUT));
+			auto end = std::chrono::high_resolution_clock::now();
+			currentFrame.stallMs += std::chrono::duration<double, std::milli>(end - start).count();
+			release(submission);
+		}
+
+		void retireSignalled()
+		{
+			while (!inFlight.empty() && vkGetFenceStatus(device->logicalDevice, inFlight.front().fence) == VK_SUCCESS)
+			{
+				release(inFlight.front());
+			}
+		}
+
+		void release(Submission& submission)
+		{
+			vkDestroyFence(device->logicalDevice, submission.fence, nullptr);
+			vkFreeCommandBuffers(device->logicalDevice, transferPool, 1, &submission.cmdBuffer);
+			if (submission.acquireCmdBuffer != VK_NULL_HANDLE)
+			{
+				vkFreeCommandBuffers(device->logicalDevice, graphicsPool, 1, &submission.acquireCmdBuffer);
+			}
+			if (submission.semaphore != VK_NULL_HANDLE)
+			{
+				vkDestroySemaphore(device->logicalDevice, submission.semaphore, nullptr);
+			}
+			for (auto& staging : submission.oversized)
+			{
+				staging.destroy();
+			}
+			tail = submission.end;
+			used -= submission.bytes;
+			completedTicket = submission.ticket;
+			inFlight.pop_front();
+		}
+	};
+}
@@ -849,8 +849,10 @@ bool VulkanExampleBase::initVulkan() {
   // This is handled by a separate class that gets a logical device
   // representation and encapsulates functions related to a device
   vulkanDevice = new vks::VulkanDevice(physicalDevice);
-  VkResult res = vulkanDevice->createLogicalDevice(enabledFeatures,
-                                                   enabledDeviceExtensions);
+  // Ask for a transfer queue too, uploads use it when it's a separate family
+  VkResult res = vulkanDevice->createLogicalDevice(
+      enabledFeatures, enabledDeviceExtensions, true,
+      VK_QUEUE_GRAPHICS_BIT | VK_QUEUE_COMPUTE_BIT | VK_QUEUE_TRANSFER_BIT);
   if (res != VK_SUCCESS) {
     vks::tools::exitFatal(
         "Could not create Vulkan device: \n" + vks::tools::errorString(res),